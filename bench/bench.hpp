@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Helpers shared by the programs in bench/. Each program is a single
+ * translation unit built by the line at its top and prints one row per
+ * measurement; numbers are wall-clock, best of a few runs.
+ */
+namespace bench
+{
+
+using clock = std::chrono::steady_clock;
+
+// seconds taken by the fastest of runs calls to f
+template<typename F>
+double time_best(F&& f, int runs = 5) {
+   double best = 1e300;
+   for (int r = 0; r < runs; r++) {
+      auto start = clock::now();
+      f();
+      std::chrono::duration<double> took = clock::now() - start;
+      best = std::min(best, took.count());
+   }
+   return best;
+}
+
+// keep the optimizer from discarding a result
+template<typename T>
+inline void keep(const T& value) {
+   asm volatile("" : : "r"(&value) : "memory");
+}
+
+// one row: what was measured, time for ops operations, and the rate
+inline void report(const std::string& name, double seconds, double ops) {
+   std::printf("%-48s %10.3f ms %10.2f Mops/s\n", name.c_str(), seconds * 1e3, ops / seconds / 1e6);
+}
+
+// n pseudo-random words of 3 to 12 lowercase letters, with repeats
+inline std::vector<std::string> words(std::size_t n, unsigned seed = 1) {
+   std::mt19937 rng{ seed };
+   std::uniform_int_distribution<int> len{ 3, 12 };
+   // skew letters the way English text is skewed, so prefixes are shared
+   std::discrete_distribution<int> letter{ 8, 2, 3, 4, 12, 2, 2, 6, 7, 1, 1, 4, 2, 7, 8, 2, 1, 6, 6, 9, 3, 1, 2, 1, 2, 1 };
+   std::vector<std::string> out(n);
+   for (auto& w : out) {
+      int l = len(rng);
+      for (int i = 0; i < l; i++) w.push_back(static_cast<char>('a' + letter(rng)));
+   }
+   return out;
+}
+
+// n pseudo-random URLs over a few hosts and path segments
+inline std::vector<std::string> urls(std::size_t n, unsigned seed = 2) {
+   static const char* hosts[] = { "https://www.example.com/", "https://news.example.org/", "http://shop.example.net/", "https://docs.example.io/" };
+   std::mt19937 rng{ seed };
+   std::vector<std::string> segments = words(512, seed + 1);
+   std::uniform_int_distribution<std::size_t> pick{ 0, segments.size() - 1 };
+   std::uniform_int_distribution<int> depth{ 1, 4 };
+   std::vector<std::string> out(n);
+   for (auto& u : out) {
+      u = hosts[rng() % 4];
+      int d = depth(rng);
+      for (int i = 0; i < d; i++) {
+         u += segments[pick(rng)];
+         if (i + 1 < d) u += '/';
+      }
+      u += "?id=" + std::to_string(rng() % 100000);
+   }
+   return out;
+}
+
+} // namespace bench
@@ -0,0 +1,96 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/concurrent_trie_mixed.cpp -o concurrent_trie_mixed && ./concurrent_trie_mixed [max_threads]
+//
+// Mixed read/write throughput on 500K URL keys (user-022): 95/5 and 50/50
+// lookups to writes (half insert_or_assign, half erase) on 1, 2, 4, ...
+// threads, for concurrent_trie and for a trie behind a std::shared_mutex.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/trie/trie.hpp"
+#include "../src/trie/concurrent_trie.hpp"
+
+namespace
+{
+
+// trie behind one reader-writer lock, the setup concurrent_trie replaces
+struct locked_trie {
+   dsacpp::trie<char, long> t;
+   mutable std::shared_mutex lock;
+
+   bool contains(const std::string& k) const {
+      std::shared_lock<std::shared_mutex> guard(lock);
+      return t.find(k) != t.end();
+   }
+   void insert_or_assign(const std::string& k, long v) {
+      std::unique_lock<std::shared_mutex> guard(lock);
+      t.insert_or_assign(k, v);
+   }
+   void erase(const std::string& k) {
+      std::unique_lock<std::shared_mutex> guard(lock);
+      t.erase(k);
+   }
+};
+
+template<typename Map>
+double run(Map& map, const std::vector<std::string>& keys, std::size_t threads, unsigned write_percent, std::size_t total) {
+   std::vector<std::thread> workers;
+   auto start = bench::clock::now();
+   for (std::size_t w = 0; w < threads; w++) {
+      workers.emplace_back([&, w] {
+         std::mt19937_64 rng{ w + 1 };
+         std::size_t found = 0;
+         for (std::size_t i = 0; i < total / threads; i++) {
+            const std::string& k = keys[rng() % keys.size()];
+            unsigned roll = static_cast<unsigned>(rng() % 100);
+            if (roll >= write_percent) {
+               found += map.contains(k);
+            } else if (roll % 2 == 0) {
+               map.insert_or_assign(k, static_cast<long>(i));
+            } else {
+               map.erase(k);
+            }
+         }
+         bench::keep(found);
+      });
+   }
+   for (auto& t : workers) t.join();
+   std::chrono::duration<double> took = bench::clock::now() - start;
+   return took.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+   constexpr std::size_t OPS = 1 << 21;
+   std::size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+   if (max_threads == 0) max_threads = 1;
+   std::vector<std::string> keys = bench::urls(1 << 19);
+
+   for (unsigned write_percent : { 5u, 50u }) {
+      for (std::size_t threads = 1;; threads = std::min(threads * 2, max_threads)) {
+         std::string tag = " [" + std::to_string(100 - write_percent) + "/" + std::to_string(write_percent)
+                         + ", " + std::to_string(threads) + " threads]";
+         double n = static_cast<double>(OPS / threads * threads);
+
+         dsacpp::concurrent_trie<char, long> c;
+         for (std::size_t i = 0; i < keys.size(); i++) c.insert(keys[i], static_cast<long>(i));
+         bench::report("concurrent_trie" + tag, run(c, keys, threads, write_percent, OPS), n);
+
+         locked_trie l;
+         for (std::size_t i = 0; i < keys.size(); i++) l.t.insert(keys[i], static_cast<long>(i));
+         bench::report("trie + shared_mutex" + tag, run(l, keys, threads, write_percent, OPS), n);
+
+         if (threads == max_threads) break;
+      }
+   }
+   return 0;
+}
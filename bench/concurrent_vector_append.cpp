@@ -0,0 +1,66 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/concurrent_vector_append.cpp -o concurrent_vector_append && ./concurrent_vector_append [max_threads]
+//
+// Concurrent push_back throughput of concurrent_vector against a
+// std::vector behind a mutex, at 1, 2, 4, ... writer threads (user-009).
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/concurrent_vector/concurrent_vector.hpp"
+
+namespace
+{
+
+template<typename Push>
+double run(std::size_t threads, std::size_t per_thread, Push push) {
+   auto start = bench::clock::now();
+   std::vector<std::thread> workers;
+   for (std::size_t t = 0; t < threads; t++) {
+      workers.emplace_back([&, t] {
+         for (std::size_t i = 0; i < per_thread; i++) push(t * per_thread + i);
+      });
+   }
+   for (auto& w : workers) w.join();
+   std::chrono::duration<double> took = bench::clock::now() - start;
+   return took.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+   constexpr std::size_t TOTAL = 1 << 23;
+   std::size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+   if (max_threads == 0) max_threads = 1;
+
+   for (std::size_t t = 1;; t = std::min(t * 2, max_threads)) {
+      std::size_t per_thread = TOTAL / t;
+      double n = static_cast<double>(per_thread * t);
+      std::string tag = " [" + std::to_string(t) + " threads]";
+
+      double best = 1e300;
+      for (int r = 0; r < 3; r++) {
+         std::vector<std::size_t> v;
+         std::mutex lock;
+         best = std::min(best, run(t, per_thread, [&](std::size_t x) {
+            std::lock_guard<std::mutex> guard(lock);
+            v.push_back(x);
+         }));
+      }
+      bench::report("mutex + std::vector" + tag, best, n);
+
+      best = 1e300;
+      for (int r = 0; r < 3; r++) {
+         dsacpp::concurrent_vector<std::size_t> v;
+         best = std::min(best, run(t, per_thread, [&](std::size_t x) { v.push_back(x); }));
+      }
+      bench::report("concurrent_vector" + tag, best, n);
+
+      if (t == max_threads) break;
+   }
+   return 0;
+}
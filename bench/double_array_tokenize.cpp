@@ -0,0 +1,78 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/double_array_tokenize.cpp -o double_array_tokenize && ./double_array_tokenize
+//
+// Tokenizer workloads over a 50K-word vocabulary (user-025): exact lookups
+// of whitespace-split tokens, and greedy longest-match segmentation of
+// unspaced text. double_array_trie against the node-based trie it was
+// compiled from; the trie has no longest-prefix query, so it segments by
+// trying the longest candidate first.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/trie/trie.hpp"
+#include "../src/trie/double_array_trie.hpp"
+
+int main() {
+   std::vector<std::string> vocab = bench::words(50000, 21);
+   std::sort(vocab.begin(), vocab.end());
+   vocab.erase(std::unique(vocab.begin(), vocab.end()), vocab.end());
+   // single letters too, so segmentation never gets stuck
+   for (char c = 'a'; c <= 'z'; c++) vocab.emplace_back(1, c);
+
+   dsacpp::trie<char, int> t;
+   std::size_t max_len = 0;
+   for (std::size_t i = 0; i < vocab.size(); i++) {
+      t.insert(vocab[i], static_cast<int>(i));
+      max_len = std::max(max_len, vocab[i].size());
+   }
+   auto da = t.compile();
+   std::printf("%zu tokens, %zu double-array slots, %zu bytes\n", da.size(), da.slot_count(), da.memory_usage());
+
+   // 4M tokens of text drawn from the vocabulary
+   std::mt19937 rng{ 8 };
+   std::vector<std::string> tokens(1 << 22);
+   std::string text;
+   for (auto& tok : tokens) {
+      tok = vocab[rng() % vocab.size()];
+      text += tok;
+   }
+   double n = static_cast<double>(tokens.size());
+
+   bench::report("trie find (split tokens)", bench::time_best([&] {
+      long sum = 0;
+      for (const auto& tok : tokens) sum += t.at(tok);
+      bench::keep(sum);
+   }, 3), n);
+   bench::report("double_array_trie find (split tokens)", bench::time_best([&] {
+      long sum = 0;
+      for (const auto& tok : tokens) sum += *da.find(tok);
+      bench::keep(sum);
+   }, 3), n);
+
+   std::size_t pieces = 0;
+   double s = bench::time_best([&] {
+      pieces = 0;
+      std::string candidate;
+      for (std::size_t pos = 0; pos < text.size(); pieces++) {
+         std::size_t len = std::min(max_len, text.size() - pos);
+         for (;; len--) {
+            candidate.assign(text, pos, len);
+            if (t.find(candidate) != t.end()) break;
+         }
+         pos += len;
+      }
+   }, 1);
+   bench::report("trie longest match by retries (pieces)", s, static_cast<double>(pieces));
+   s = bench::time_best([&] {
+      pieces = 0;
+      for (std::size_t pos = 0; pos < text.size(); pieces++) {
+         pos += da.longest_prefix(text, pos);
+      }
+   }, 3);
+   bench::report("double_array_trie longest_prefix (pieces)", s, static_cast<double>(pieces));
+   return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+
+#include <malloc.h>
+
+/**
+ * Counts heap traffic by interposing glibc's allocation functions, which
+ * every allocator in the library ends up in (operator new included).
+ * Include it from exactly one translation unit: the benchmark program.
+ */
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* __libc_calloc(std::size_t count, std::size_t size);
+extern "C" void* __libc_realloc(void* p, std::size_t size);
+extern "C" void* __libc_memalign(std::size_t alignment, std::size_t size);
+extern "C" void __libc_free(void* p);
+
+namespace bench
+{
+
+struct malloc_counters {
+   std::size_t calls = 0;
+   // usable bytes currently held
+   std::size_t live_bytes = 0;
+
+   void* took(void* p) noexcept {
+      if (p) {
+         calls++;
+         live_bytes += ::malloc_usable_size(p);
+      }
+      return p;
+   }
+
+   void gave(void* p) noexcept {
+      if (p) live_bytes -= ::malloc_usable_size(p);
+   }
+};
+
+inline malloc_counters heap;
+
+} // namespace bench
+
+extern "C" void* malloc(std::size_t size) {
+   return bench::heap.took(__libc_malloc(size));
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size) {
+   return bench::heap.took(__libc_calloc(count, size));
+}
+
+extern "C" void* realloc(void* p, std::size_t size) {
+   bench::heap.gave(p);
+   return bench::heap.took(__libc_realloc(p, size));
+}
+
+extern "C" void* aligned_alloc(std::size_t alignment, std::size_t size) {
+   return bench::heap.took(__libc_memalign(alignment, size));
+}
+
+extern "C" void free(void* p) {
+   bench::heap.gave(p);
+   __libc_free(p);
+}
@@ -0,0 +1,54 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/parallel_scaling.cpp -o parallel_scaling && ./parallel_scaling [max_threads]
+//
+// parallel::sort, transform, reduce and inclusive_scan over 16M elements
+// on pools of 1, 2, 4, ... threads up to the hardware's count (user-008),
+// with the sequential std:: version as the baseline.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "bench.hpp"
+#include "../src/vector/parallel_algorithm.hpp"
+
+int main(int argc, char** argv) {
+   constexpr std::size_t N = 1 << 24;
+   std::size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+   if (max_threads == 0) max_threads = 1;
+
+   std::mt19937_64 rng{ 11 };
+   dsacpp::vector<std::uint64_t> input;
+   input.reserve(N);
+   for (std::size_t i = 0; i < N; i++) input.push_back(rng());
+   dsacpp::vector<std::uint64_t> work;
+   dsacpp::vector<std::uint64_t> out(N);
+   auto mix = [](std::uint64_t x) { return (x ^ (x >> 31)) * 0x9E3779B97F4A7C15ull; };
+
+   auto sorted = [&](auto sort) {
+      return bench::time_best([&] { work = input; sort(); }, 3)
+           - bench::time_best([&] { work = input; }, 3);
+   };
+
+   double n = static_cast<double>(N);
+   bench::report("std::sort", sorted([&] { std::sort(work.begin(), work.end()); }), n);
+   bench::report("std::transform", bench::time_best([&] { std::transform(input.begin(), input.end(), out.begin(), mix); }), n);
+   bench::report("std::reduce", bench::time_best([&] { bench::keep(std::reduce(input.begin(), input.end(), std::uint64_t{ 0 })); }), n);
+   bench::report("std::inclusive_scan", bench::time_best([&] { std::inclusive_scan(input.begin(), input.end(), out.begin()); }), n);
+
+   for (std::size_t t = 1;; t = std::min(t * 2, max_threads)) {
+      dsacpp::thread_pool pool(t);
+      std::string tag = " [" + std::to_string(t) + " threads]";
+      namespace par = dsacpp::parallel;
+      bench::report("parallel::sort" + tag, sorted([&] { par::sort(pool, work); }), n);
+      bench::report("parallel::transform" + tag, bench::time_best([&] { par::transform(pool, input, out, mix); }), n);
+      bench::report("parallel::reduce" + tag, bench::time_best([&] { bench::keep(par::reduce(pool, input, std::uint64_t{ 0 })); }), n);
+      bench::report("parallel::inclusive_scan" + tag, bench::time_best([&] { par::inclusive_scan(pool, input, out); }), n);
+      if (t == max_threads) break;
+   }
+   return 0;
+}
@@ -0,0 +1,129 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/ring_buffer_throughput.cpp -o ring_buffer_throughput && ./ring_buffer_throughput [producer_cpu consumer_cpu]
+//
+// ring_buffer between two threads pinned to separate CPUs (0 and 1 unless
+// given): throughput for single and batched push/pop, SPSC and MPSC, then
+// one-way latency percentiles from a ping-pong over two rings (user-014).
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/ring_buffer/ring_buffer.hpp"
+
+namespace
+{
+
+int producer_cpu = 0;
+int consumer_cpu = 1;
+
+void pin(int cpu) {
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu % static_cast<int>(std::max(1u, std::thread::hardware_concurrency())), &set);
+   pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// spin after a failed try, but give the CPU away now and then in case
+// both threads share one
+struct backoff {
+   unsigned misses = 0;
+
+   void operator()() {
+      if (++misses % 1024 == 0) std::this_thread::yield();
+   }
+};
+
+template<typename F>
+void spin_until(F done) {
+   backoff idle;
+   while (!done()) idle();
+}
+
+template<typename Ring>
+void throughput(const char* name, std::size_t n, std::size_t batch, int producers = 1) {
+   double s = bench::time_best([&] {
+      Ring ring(1024);
+      std::vector<std::thread> threads;
+      std::size_t per_producer = n / producers;
+      for (int p = 0; p < producers; p++) {
+         threads.emplace_back([&] {
+            pin(producer_cpu);
+            std::vector<std::uint64_t> items(batch, 1);
+            backoff idle;
+            for (std::size_t sent = 0; sent < per_producer;) {
+               std::size_t pushed = batch == 1
+                  ? ring.try_push(sent)
+                  : ring.try_push_n(items.begin(), std::min(batch, per_producer - sent));
+               if (pushed) sent += pushed; else idle();
+            }
+         });
+      }
+      pin(consumer_cpu);
+      std::vector<std::uint64_t> out(batch);
+      std::uint64_t sum = 0;
+      backoff idle;
+      for (std::size_t got = 0; got < per_producer * producers;) {
+         std::size_t popped = batch == 1 ? ring.try_pop(out[0]) : ring.try_pop_n(out.begin(), batch);
+         if (popped) { sum += out[0]; got += popped; } else idle();
+      }
+      bench::keep(sum);
+      for (auto& t : threads) t.join();
+   }, 3);
+   bench::report(name, s, static_cast<double>(n));
+}
+
+void latency(std::size_t rounds) {
+   using ring = dsacpp::ring_buffer<std::uint64_t>;
+   ring ping(64);
+   ring pong(64);
+   std::thread echo([&] {
+      pin(consumer_cpu);
+      for (std::size_t i = 0; i < rounds; i++) {
+         std::uint64_t x;
+         spin_until([&] { return ping.try_pop(x); });
+         spin_until([&] { return pong.try_push(x); });
+      }
+   });
+   pin(producer_cpu);
+   std::vector<double> one_way(rounds);
+   for (std::size_t i = 0; i < rounds; i++) {
+      auto start = bench::clock::now();
+      std::uint64_t x = i;
+      spin_until([&] { return ping.try_push(x); });
+      spin_until([&] { return pong.try_pop(x); });
+      std::chrono::duration<double, std::nano> took = bench::clock::now() - start;
+      one_way[i] = took.count() / 2;
+   }
+   echo.join();
+   std::sort(one_way.begin(), one_way.end());
+   auto at = [&](double q) { return one_way[static_cast<std::size_t>(q * static_cast<double>(rounds - 1))]; };
+   std::printf("one-way latency ns: p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+               at(0.5), at(0.9), at(0.99), at(0.999), one_way.back());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+   if (argc > 2) {
+      producer_cpu = std::atoi(argv[1]);
+      consumer_cpu = std::atoi(argv[2]);
+   }
+   constexpr std::size_t N = 1 << 23;
+   using spsc = dsacpp::ring_buffer<std::uint64_t>;
+   using mpsc = dsacpp::ring_buffer<std::uint64_t, dsacpp::ring_producers::multi>;
+
+   throughput<spsc>("SPSC try_push/try_pop", N, 1);
+   throughput<spsc>("SPSC try_push_n/try_pop_n (64)", N, 64);
+   throughput<mpsc>("MPSC, 1 producer, try_push/try_pop", N, 1);
+   throughput<mpsc>("MPSC, 1 producer, batches of 64", N, 64);
+   throughput<mpsc>("MPSC, 2 producers, batches of 64", N, 64, 2);
+   latency(200000);
+   return 0;
+}
@@ -0,0 +1,91 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/simd_scan.cpp -o simd_scan && ./simd_scan
+//
+// dsacpp::simd scans at every level the CPU supports against the std::
+// algorithms on the same data (user-007). Built without -march flags, as
+// a library user would, so std:: gets baseline SSE2 code.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+
+#include "bench.hpp"
+#include "../src/vector/simd_algorithm.hpp"
+
+namespace
+{
+
+const char* level_name(dsacpp::simd::level l) {
+   switch (l) {
+   case dsacpp::simd::level::scalar: return "scalar";
+   case dsacpp::simd::level::sse2: return "sse2";
+   case dsacpp::simd::level::avx2: return "avx2";
+   default: return "avx512";
+   }
+}
+
+template<typename F>
+void row(const std::string& name, std::size_t n, F f) {
+   bench::report(name, bench::time_best(f, 10), static_cast<double>(n));
+}
+
+} // namespace
+
+int main() {
+   constexpr std::size_t N = 1 << 22;
+   namespace simd = dsacpp::simd;
+
+   std::mt19937 rng{ 7 };
+   dsacpp::vector<std::int32_t> ints;
+   dsacpp::vector<float> floats;
+   dsacpp::vector<std::uint8_t> bytes;
+   for (std::size_t i = 0; i < N; i++) {
+      ints.push_back(static_cast<std::int32_t>(rng() % 1000));
+      floats.push_back(static_cast<float>(rng() % 1000) / 7.0f);
+      bytes.push_back(static_cast<std::uint8_t>('a' + rng() % 26));
+   }
+   dsacpp::vector<std::int32_t> copy(ints);
+   dsacpp::vector<std::uint8_t> needle;
+   for (char c : std::string("zzzzq")) needle.push_back(static_cast<std::uint8_t>(c));
+   dsacpp::vector<std::int32_t> out;
+   out.reserve(N);
+
+   const std::int32_t* ib = ints.data();
+   const std::int32_t* ie = ib + N;
+   const float* fb = floats.data();
+   const float* fe = fb + N;
+
+   row("std::find (int32, absent)", N, [&] { bench::keep(std::find(ib, ie, -1)); });
+   row("std::count (int32)", N, [&] { bench::keep(std::count(ib, ie, 500)); });
+   row("std::accumulate (int32 -> int64)", N, [&] { bench::keep(std::accumulate(ib, ie, std::int64_t{ 0 })); });
+   row("std::accumulate (float)", N, [&] { bench::keep(std::accumulate(fb, fe, 0.0f)); });
+   row("std::minmax_element (int32)", N, [&] { bench::keep(std::minmax_element(ib, ie)); });
+   row("std::equal (int32)", N, [&] { bench::keep(std::equal(ib, ie, copy.data())); });
+   row("std::search (bytes)", N, [&] {
+      bench::keep(std::search(bytes.data(), bytes.data() + N, needle.data(), needle.data() + needle.size()));
+   });
+   row("std::copy_if (int32 < 100)", N, [&] {
+      out.clear();
+      std::copy_if(ib, ie, std::back_inserter(out), [](std::int32_t x) { return x < 100; });
+      bench::keep(out);
+   });
+
+   for (int l = 0; l <= static_cast<int>(simd::detected_level()); l++) {
+      simd::set_active_level(static_cast<simd::level>(l));
+      std::string tag = std::string(" [") + level_name(simd::active_level()) + "]";
+      row("simd::find (int32, absent)" + tag, N, [&] { bench::keep(simd::find(ints, -1)); });
+      row("simd::count (int32)" + tag, N, [&] { bench::keep(simd::count(ints, 500)); });
+      row("simd::accumulate (int32 -> int64)" + tag, N, [&] { bench::keep(simd::accumulate(ints)); });
+      row("simd::accumulate (float)" + tag, N, [&] { bench::keep(simd::accumulate(floats)); });
+      row("simd::minmax (int32)" + tag, N, [&] { bench::keep(simd::minmax(ints)); });
+      row("simd::equal (int32)" + tag, N, [&] { bench::keep(simd::equal(ints, copy)); });
+      row("simd::search (bytes)" + tag, N, [&] { bench::keep(simd::search(bytes, needle)); });
+      row("simd::filter (int32 < 100)" + tag, N, [&] {
+         out.clear();
+         bench::keep(simd::filter(ints, simd::compare::less, 100, out));
+      });
+   }
+   return 0;
+}
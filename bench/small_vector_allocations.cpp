@@ -0,0 +1,45 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/small_vector_allocations.cpp -o small_vector_allocations && ./small_vector_allocations
+//
+// Heap allocations and time for building many short lists, the case
+// small_vector's inline buffer is for (user-003). Allocations are counted
+// by malloc_count.hpp.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "malloc_count.hpp"
+#include "../src/vector/vector.hpp"
+#include "../src/vector/small_vector.hpp"
+
+namespace
+{
+
+// n lists of 0 to 2 * inline elements, most of them short
+template<typename Vec>
+void run(const std::string& name, std::size_t n, std::size_t max_len) {
+   std::size_t calls = bench::heap.calls;
+   double s = bench::time_best([&] {
+      for (std::size_t i = 0; i < n; i++) {
+         Vec v;
+         std::size_t len = (i * 2654435761u) % (max_len + 1);
+         if (i % 8 == 0) len *= 2;
+         for (std::size_t k = 0; k < len; k++) v.push_back(static_cast<int>(k));
+         bench::keep(v);
+      }
+   }, 1);
+   bench::report(name, s, static_cast<double>(n));
+   std::printf("%-48s %10zu allocations\n", "", bench::heap.calls - calls);
+}
+
+} // namespace
+
+int main() {
+   constexpr std::size_t N = 1 << 20;
+   run<std::vector<int>>("std::vector<int>", N, 8);
+   run<dsacpp::vector<int>>("dsacpp::vector<int>", N, 8);
+   run<dsacpp::small_vector<int, 8>>("dsacpp::small_vector<int, 8>", N, 8);
+   run<dsacpp::small_vector<int, 16>>("dsacpp::small_vector<int, 16>", N, 8);
+   return 0;
+}
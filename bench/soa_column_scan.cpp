@@ -0,0 +1,63 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/soa_column_scan.cpp -o soa_column_scan && ./soa_column_scan
+//
+// Scanning one field of 4M particles stored as an array of structs in a
+// dsacpp::vector against the same field as an soa_vector column (user-010).
+
+#include <cstdint>
+
+#include "bench.hpp"
+#include "../src/vector/vector.hpp"
+#include "../src/vector/soa_vector.hpp"
+#include "../src/vector/simd_algorithm.hpp"
+
+namespace
+{
+
+struct particle {
+   float x, y, z;
+   float vx, vy, vz;
+   float mass;
+   std::int32_t id;
+};
+
+} // namespace
+
+int main() {
+   constexpr std::size_t N = 1 << 22;
+   dsacpp::vector<particle> aos;
+   dsacpp::soa_vector<float, float, float, float, float, float, float, std::int32_t> soa;
+   for (std::size_t i = 0; i < N; i++) {
+      float f = static_cast<float>(i % 1000);
+      aos.push_back({ f, f, f, 1, 1, 1, 2, static_cast<std::int32_t>(i) });
+      soa.emplace_back(f, f, f, 1.0f, 1.0f, 1.0f, 2.0f, static_cast<std::int32_t>(i));
+   }
+   double n = static_cast<double>(N);
+
+   bench::report("AoS sum of x", bench::time_best([&] {
+      float sum = 0;
+      for (const particle& p : aos) sum += p.x;
+      bench::keep(sum);
+   }), n);
+   bench::report("SoA sum of x (loop)", bench::time_best([&] {
+      float sum = 0;
+      for (float x : soa.column<0>()) sum += x;
+      bench::keep(sum);
+   }), n);
+   bench::report("SoA sum of x (simd::accumulate)", bench::time_best([&] {
+      auto xs = soa.column<0>();
+      bench::keep(dsacpp::simd::accumulate(xs.begin(), xs.end()));
+   }), n);
+
+   // three fields read, three written
+   bench::report("AoS x += vx, y += vy, z += vz", bench::time_best([&] {
+      for (particle& p : aos) { p.x += p.vx; p.y += p.vy; p.z += p.vz; }
+      bench::keep(aos);
+   }), n);
+   bench::report("SoA x += vx, y += vy, z += vz", bench::time_best([&] {
+      auto x = soa.column<0>(); auto y = soa.column<1>(); auto z = soa.column<2>();
+      auto vx = soa.column<3>(); auto vy = soa.column<4>(); auto vz = soa.column<5>();
+      for (std::size_t i = 0; i < x.size(); i++) { x[i] += vx[i]; y[i] += vy[i]; z[i] += vz[i]; }
+      bench::keep(soa);
+   }), n);
+   return 0;
+}
@@ -0,0 +1,51 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/trie_bulk_build.cpp -o trie_bulk_build && ./trie_bulk_build [max_threads]
+//
+// Building a trie from about 2M sorted keys: insert one by one, the
+// one-pass sorted range constructor, and the thread_pool constructor on
+// 1, 2, 4, ... threads (user-020).
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/trie/trie.hpp"
+
+int main(int argc, char** argv) {
+   std::size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+   if (max_threads == 0) max_threads = 1;
+
+   std::vector<std::string> keys = bench::words(1 << 21);
+   std::vector<std::string> more = bench::urls(1 << 20);
+   keys.insert(keys.end(), more.begin(), more.end());
+   std::sort(keys.begin(), keys.end());
+   keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+   std::vector<std::pair<std::string, int>> sorted;
+   for (std::size_t i = 0; i < keys.size(); i++) sorted.emplace_back(keys[i], static_cast<int>(i));
+   double n = static_cast<double>(sorted.size());
+   std::printf("%zu sorted keys\n", sorted.size());
+
+   using trie = dsacpp::trie<char, int>;
+   bench::report("insert one by one", bench::time_best([&] {
+      trie t;
+      for (const auto& [k, v] : sorted) t.insert(k, v);
+      bench::keep(t);
+   }, 3), n);
+   bench::report("sorted range constructor", bench::time_best([&] {
+      trie t(sorted.begin(), sorted.end());
+      bench::keep(t);
+   }, 3), n);
+   for (std::size_t threads = 1;; threads = std::min(threads * 2, max_threads)) {
+      dsacpp::thread_pool pool(threads);
+      bench::report("parallel constructor [" + std::to_string(threads) + " threads]", bench::time_best([&] {
+         trie t(pool, sorted.begin(), sorted.end());
+         bench::keep(t);
+      }, 3), n);
+      if (threads == max_threads) break;
+   }
+   return 0;
+}
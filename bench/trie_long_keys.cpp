@@ -0,0 +1,94 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/trie_long_keys.cpp -o trie_long_keys && ./trie_long_keys
+//
+// Long keys with long shared prefixes and single-child chains, where path
+// compression pays off (user-018): heap bytes per key against the raw key
+// bytes and std::map, exact lookups, and equal_range prefix scans.
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "malloc_count.hpp"
+#include "../src/trie/trie.hpp"
+
+namespace
+{
+
+// deep file paths: a few roots, shared directory chains, long file names
+std::vector<std::string> paths(std::size_t n) {
+   static const char* roots[] = { "/usr/share/documentation/packages/", "/home/build/workspace/projects/", "/var/lib/containers/storage/overlay/" };
+   std::vector<std::string> dirs = bench::words(64, 9);
+   std::vector<std::string> names = bench::words(4096, 10);
+   std::mt19937 rng{ 3 };
+   std::vector<std::string> out(n);
+   for (auto& p : out) {
+      p = roots[rng() % 3];
+      int depth = 2 + static_cast<int>(rng() % 4);
+      for (int d = 0; d < depth; d++) p += dirs[rng() % dirs.size()] + "/";
+      p += names[rng() % names.size()] + "_" + std::to_string(rng() % 1000) + ".txt";
+   }
+   std::sort(out.begin(), out.end());
+   out.erase(std::unique(out.begin(), out.end()), out.end());
+   std::shuffle(out.begin(), out.end(), rng);
+   return out;
+}
+
+} // namespace
+
+int main() {
+   std::vector<std::string> keys = paths(1 << 19);
+   std::size_t raw = 0;
+   for (const auto& k : keys) raw += k.size();
+   double n = static_cast<double>(keys.size());
+   std::printf("%zu paths, %.1f bytes each on average\n", keys.size(), static_cast<double>(raw) / n);
+
+   std::size_t before = bench::heap.live_bytes;
+   dsacpp::trie<char, int> t;
+   for (std::size_t i = 0; i < keys.size(); i++) t.insert(keys[i], static_cast<int>(i));
+   std::printf("%-48s %10.1f bytes/key\n", "dsacpp::trie", static_cast<double>(bench::heap.live_bytes - before) / n);
+
+   before = bench::heap.live_bytes;
+   std::map<std::string, int> m;
+   for (std::size_t i = 0; i < keys.size(); i++) m.emplace(keys[i], static_cast<int>(i));
+   std::printf("%-48s %10.1f bytes/key\n", "std::map", static_cast<double>(bench::heap.live_bytes - before) / n);
+
+   bench::report("trie at()", bench::time_best([&] {
+      long sum = 0;
+      for (const auto& k : keys) sum += t.at(k);
+      bench::keep(sum);
+   }), n);
+   bench::report("std::map at()", bench::time_best([&] {
+      long sum = 0;
+      for (const auto& k : keys) sum += m.at(k);
+      bench::keep(sum);
+   }), n);
+
+   // every key under a directory a few levels down
+   std::vector<std::string> prefixes;
+   for (std::size_t i = 0; i < 1000; i++) {
+      const std::string& k = keys[i];
+      std::size_t cut = k.find('/', k.find('/', 30) + 1);
+      prefixes.push_back(k.substr(0, cut + 1));
+   }
+   std::size_t visited = 0;
+   double scan = bench::time_best([&] {
+      visited = 0;
+      for (const auto& p : prefixes) {
+         auto range = t.equal_range(p);
+         for (auto it = range.first; it != range.second; ++it) visited++;
+      }
+   });
+   bench::report("trie equal_range scans (keys visited)", scan, static_cast<double>(visited));
+   scan = bench::time_best([&] {
+      visited = 0;
+      for (const auto& p : prefixes) {
+         for (auto it = m.lower_bound(p); it != m.end() && it->first.compare(0, p.size(), p) == 0; ++it) visited++;
+      }
+   });
+   bench::report("std::map lower_bound scans (keys visited)", scan, static_cast<double>(visited));
+   return 0;
+}
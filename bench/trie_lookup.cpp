@@ -0,0 +1,72 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/trie_lookup.cpp -o trie_lookup && ./trie_lookup
+//
+// Lookup throughput and heap bytes per key of trie against std::map and
+// std::unordered_map on word and URL corpora (user-017). Bytes are
+// counted by malloc_count.hpp and include the containers' copies of keys.
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.hpp"
+#include "malloc_count.hpp"
+#include "../src/trie/trie.hpp"
+
+namespace
+{
+
+template<typename Map>
+void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& probes,
+         const std::vector<std::string>& misses) {
+   std::size_t before = bench::heap.live_bytes;
+   auto start = bench::clock::now();
+   Map* map = new Map;
+   for (std::size_t i = 0; i < keys.size(); i++) (*map)[keys[i]] = static_cast<int>(i);
+   std::chrono::duration<double> build = bench::clock::now() - start;
+   double bytes = static_cast<double>(bench::heap.live_bytes - before) / static_cast<double>(keys.size());
+
+   double hit = bench::time_best([&] {
+      long sum = 0;
+      for (const auto& k : probes) sum += map->at(k);
+      bench::keep(sum);
+   });
+   double miss = bench::time_best([&] {
+      std::size_t found = 0;
+      for (const auto& k : misses) found += map->find(k) != map->end();
+      bench::keep(found);
+   });
+   std::printf("%-24s build %8.2f ms   hit %7.2f Mops/s   miss %7.2f Mops/s   %6.1f bytes/key\n", name,
+               build.count() * 1e3, static_cast<double>(probes.size()) / hit / 1e6,
+               static_cast<double>(misses.size()) / miss / 1e6, bytes);
+   delete map;
+}
+
+void corpus(const char* title, std::vector<std::string> keys) {
+   std::sort(keys.begin(), keys.end());
+   keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+   std::mt19937 rng{ 5 };
+   std::shuffle(keys.begin(), keys.end(), rng);
+
+   std::vector<std::string> probes = keys;
+   std::shuffle(probes.begin(), probes.end(), rng);
+   // near misses: real keys with their last byte changed
+   std::vector<std::string> misses;
+   for (std::size_t i = 0; i < keys.size(); i++) misses.push_back(keys[i] + "~");
+
+   std::printf("%s: %zu keys\n", title, keys.size());
+   run<dsacpp::trie<char, int>>("dsacpp::trie", keys, probes, misses);
+   run<std::map<std::string, int>>("std::map", keys, probes, misses);
+   run<std::unordered_map<std::string, int>>("std::unordered_map", keys, probes, misses);
+}
+
+} // namespace
+
+int main() {
+   corpus("words", bench::words(1 << 20));
+   corpus("urls", bench::urls(1 << 19));
+   return 0;
+}
@@ -0,0 +1,53 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/trie_teardown.cpp -o trie_teardown && ./trie_teardown
+//
+// Build, clear() and destruction time of a trie whose nodes come from its
+// slab arena, against std::map's one allocation per node (user-019).
+// Trivially destructible data lets clear() drop whole slabs; std::string
+// data makes it walk the tree to run destructors.
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/trie/trie.hpp"
+
+namespace
+{
+
+template<typename Map, typename Make>
+void run(const char* name, const std::vector<std::string>& keys, Make make) {
+   double build = 0, clear = 0, destroy = 0;
+   for (int r = 0; r < 3; r++) {
+      auto* map = new Map;
+      auto t0 = bench::clock::now();
+      for (std::size_t i = 0; i < keys.size(); i++) (*map)[keys[i]] = make(i);
+      auto t1 = bench::clock::now();
+      map->clear();
+      auto t2 = bench::clock::now();
+      for (std::size_t i = 0; i < keys.size(); i++) (*map)[keys[i]] = make(i);
+      auto t3 = bench::clock::now();
+      delete map;
+      auto t4 = bench::clock::now();
+      std::chrono::duration<double> b = t1 - t0, c = t2 - t1, d = t4 - t3;
+      if (r == 0 || b.count() < build) build = b.count();
+      if (r == 0 || c.count() < clear) clear = c.count();
+      if (r == 0 || d.count() < destroy) destroy = d.count();
+   }
+   std::printf("%-36s build %9.2f ms   clear %8.2f ms   destroy %8.2f ms\n", name, build * 1e3, clear * 1e3, destroy * 1e3);
+}
+
+} // namespace
+
+int main() {
+   std::vector<std::string> keys = bench::urls(1 << 20);
+   std::printf("%zu keys\n", keys.size());
+   auto make_int = [](std::size_t i) { return static_cast<long>(i); };
+   auto make_string = [](std::size_t i) { return std::string(24, static_cast<char>('a' + i % 26)); };
+   run<dsacpp::trie<char, long>>("dsacpp::trie<char, long>", keys, make_int);
+   run<std::map<std::string, long>>("std::map<std::string, long>", keys, make_int);
+   run<dsacpp::trie<char, std::string>>("dsacpp::trie<char, std::string>", keys, make_string);
+   run<std::map<std::string, std::string>>("std::map<std::string, std::string>", keys, make_string);
+   return 0;
+}
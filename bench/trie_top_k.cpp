@@ -0,0 +1,75 @@
+// g++ -std=c++20 -O2 -DNDEBUG -pthread bench/trie_top_k.cpp -o trie_top_k && ./trie_top_k
+//
+// Search-as-you-type over 1M scored words (user-021): latency percentiles
+// of top_k(prefix, 10) for one- and two-letter prefixes, against walking
+// equal_range(prefix) and keeping the ten best.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/trie/trie.hpp"
+
+namespace
+{
+
+template<typename F>
+void percentiles(const char* name, const std::vector<std::string>& prefixes, F query) {
+   std::vector<double> micros;
+   for (int round = 0; round < 5; round++) {
+      for (const auto& p : prefixes) {
+         auto start = bench::clock::now();
+         query(p);
+         std::chrono::duration<double, std::micro> took = bench::clock::now() - start;
+         micros.push_back(took.count());
+      }
+   }
+   std::sort(micros.begin(), micros.end());
+   auto at = [&](double q) { return micros[static_cast<std::size_t>(q * static_cast<double>(micros.size() - 1))]; };
+   std::printf("%-40s p50 %9.1f us   p90 %9.1f us   p99 %9.1f us   max %9.1f us\n",
+               name, at(0.5), at(0.9), at(0.99), micros.back());
+}
+
+} // namespace
+
+int main() {
+   using trie = dsacpp::trie<char, std::uint32_t>;
+   trie t;
+   std::mt19937 rng{ 4 };
+   // heavy-tailed scores, like query counts
+   std::exponential_distribution<double> score{ 1e-4 };
+   for (const auto& w : bench::words(1 << 20)) t.insert_or_assign(w, static_cast<std::uint32_t>(score(rng)));
+   std::printf("%zu keys\n", t.size());
+
+   std::vector<std::string> prefixes;
+   for (char a = 'a'; a <= 'z'; a++) {
+      prefixes.emplace_back(1, a);
+      for (char b = 'a'; b <= 'z'; b++) prefixes.push_back(std::string{ a, b });
+   }
+
+   constexpr std::size_t K = 10;
+   percentiles("top_k(prefix, 10)", prefixes, [&](const std::string& p) {
+      bench::keep(t.top_k(p, K));
+   });
+   percentiles("equal_range walk + keep best 10", prefixes, [&](const std::string& p) {
+      std::vector<std::pair<std::uint32_t, std::string>> best;
+      auto range = t.equal_range(p);
+      for (auto it = range.first; it != range.second; ++it) {
+         if (best.size() < K || it->second > best.front().first) {
+            if (best.size() == K) {
+               std::pop_heap(best.begin(), best.end(), std::greater<>());
+               best.pop_back();
+            }
+            best.emplace_back(it->second, it->first);
+            std::push_heap(best.begin(), best.end(), std::greater<>());
+         }
+      }
+      bench::keep(best);
+   });
+   return 0;
+}
@@ -0,0 +1,50 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/vector_growth.cpp -o vector_growth && ./vector_growth
+//
+// Capacity changes, buffer moves and final memory overhead of each growth
+// policy over 1M int push_backs (user-006). A capacity change that keeps
+// data() in place grew the block where it was.
+
+#include <cstdio>
+#include <string>
+
+#include "bench.hpp"
+#include "../src/vector/vector.hpp"
+#include "../src/vector/mmap_allocator.hpp"
+
+namespace
+{
+
+template<typename Vec>
+void run(const char* name, std::size_t n) {
+   std::size_t grows = 0;
+   std::size_t moves = 0;
+   Vec v;
+   double s = bench::time_best([&] {
+      Vec w;
+      for (std::size_t i = 0; i < n; i++) w.push_back(static_cast<int>(i));
+      bench::keep(w);
+   }, 3);
+   for (std::size_t i = 0; i < n; i++) {
+      std::size_t cap = v.capacity();
+      const int* data = v.data();
+      v.push_back(static_cast<int>(i));
+      if (v.capacity() != cap) {
+         grows++;
+         if (data && v.data() != data) moves++;
+      }
+   }
+   double overhead = 100.0 * static_cast<double>(v.capacity() - v.size()) / static_cast<double>(v.size());
+   std::printf("%-32s %6zu grows %6zu moves %7.1f%% overhead %8.3f ms\n", name, grows, moves, overhead, s * 1e3);
+}
+
+} // namespace
+
+int main() {
+   constexpr std::size_t N = 1000000;
+   namespace gp = dsacpp::growth_policy;
+   run<dsacpp::vector<int, dsacpp::allocator<int>, gp::doubling>>("doubling", N);
+   run<dsacpp::vector<int, dsacpp::allocator<int>, gp::one_and_half>>("one_and_half", N);
+   run<dsacpp::vector<int, dsacpp::allocator<int>, gp::fixed_chunk<65536>>>("fixed_chunk<65536>", N);
+   run<dsacpp::mmap_vector<int>>("mmap_vector (doubling)", N);
+   return 0;
+}
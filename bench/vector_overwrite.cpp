@@ -0,0 +1,60 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/vector_overwrite.cpp -o vector_overwrite && ./vector_overwrite
+//
+// Filling a 1 MiB byte buffer the way an I/O loop does: size it, then
+// overwrite every byte (user-012). resize() zeroes the bytes first;
+// resize_for_overwrite() and resize_and_overwrite() leave them be.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/vector/vector.hpp"
+
+int main() {
+   constexpr std::size_t BYTES = 1 << 20;
+   constexpr int ROUNDS = 256;
+   std::vector<std::uint8_t> source(BYTES, 0x5a);
+   // stands in for read(): fills at most n bytes and reports how many
+   auto read_into = [&](std::uint8_t* p, std::size_t n) {
+      std::memcpy(p, source.data(), n);
+      return n;
+   };
+   double n = static_cast<double>(BYTES) * ROUNDS;
+
+   bench::report("std::vector resize + read (bytes)", bench::time_best([&] {
+      for (int r = 0; r < ROUNDS; r++) {
+         std::vector<std::uint8_t> buf;
+         buf.resize(BYTES);
+         read_into(buf.data(), BYTES);
+         bench::keep(buf);
+      }
+   }), n);
+
+   bench::report("dsacpp::vector resize + read (bytes)", bench::time_best([&] {
+      for (int r = 0; r < ROUNDS; r++) {
+         dsacpp::vector<std::uint8_t> buf;
+         buf.resize(BYTES);
+         read_into(buf.data(), BYTES);
+         bench::keep(buf);
+      }
+   }), n);
+
+   bench::report("resize_for_overwrite + read (bytes)", bench::time_best([&] {
+      for (int r = 0; r < ROUNDS; r++) {
+         dsacpp::vector<std::uint8_t> buf;
+         buf.resize_for_overwrite(BYTES);
+         read_into(buf.data(), BYTES);
+         bench::keep(buf);
+      }
+   }), n);
+
+   bench::report("resize_and_overwrite (bytes)", bench::time_best([&] {
+      for (int r = 0; r < ROUNDS; r++) {
+         dsacpp::vector<std::uint8_t> buf;
+         buf.resize_and_overwrite(BYTES, read_into);
+         bench::keep(buf);
+      }
+   }), n);
+   return 0;
+}
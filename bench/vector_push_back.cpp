@@ -0,0 +1,48 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/vector_push_back.cpp -o vector_push_back && ./vector_push_back
+//
+// push_back throughput of dsacpp::vector against std::vector, growing
+// from empty so every reallocation is paid for (user-001).
+
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "../src/vector/vector.hpp"
+
+namespace
+{
+
+// a large trivially copyable element, relocated with memcpy
+struct big_pod {
+   double values[16];
+};
+
+template<typename Vec, typename Make>
+void run(const std::string& name, std::size_t n, Make make) {
+   double s = bench::time_best([&] {
+      Vec v;
+      for (std::size_t i = 0; i < n; i++) v.push_back(make(i));
+      bench::keep(v);
+   });
+   bench::report(name, s, static_cast<double>(n));
+}
+
+} // namespace
+
+int main() {
+   constexpr std::size_t N = 1 << 20;
+
+   auto make_int = [](std::size_t i) { return static_cast<int>(i); };
+   run<std::vector<int>>("std::vector<int>", N, make_int);
+   run<dsacpp::vector<int>>("dsacpp::vector<int>", N, make_int);
+
+   // long enough to live on the heap, so a copy would allocate
+   auto make_string = [](std::size_t i) { return std::string(32, static_cast<char>('a' + i % 26)); };
+   run<std::vector<std::string>>("std::vector<std::string>", N / 4, make_string);
+   run<dsacpp::vector<std::string>>("dsacpp::vector<std::string>", N / 4, make_string);
+
+   auto make_pod = [](std::size_t i) { big_pod p{}; p.values[0] = static_cast<double>(i); return p; };
+   run<std::vector<big_pod>>("std::vector<big_pod>", N / 4, make_pod);
+   run<dsacpp::vector<big_pod>>("dsacpp::vector<big_pod>", N / 4, make_pod);
+   return 0;
+}
@@ -0,0 +1,57 @@
+// g++ -std=c++20 -O2 -DNDEBUG bench/vector_view_open.cpp -o vector_view_open && ./vector_view_open [path]
+//
+// Time to get at a saved 128 MiB vector: mapping it with vector_view
+// against reading it back into a vector, plus save() and checksum
+// verification (user-011). The file is in the page cache after save(),
+// so this measures open cost rather than disk speed; drop caches between
+// runs for a true cold start.
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "bench.hpp"
+#include "../src/vector/vector.hpp"
+#include "../src/vector/vector_view.hpp"
+
+int main(int argc, char** argv) {
+   constexpr std::size_t N = 1 << 24;
+   std::string path = argc > 1 ? argv[1] : "vector_view_open.bin";
+
+   dsacpp::vector<std::uint64_t> v;
+   v.reserve(N);
+   for (std::size_t i = 0; i < N; i++) v.push_back(i * 0x9E3779B97F4A7C15ull);
+   double n = static_cast<double>(N);
+
+   bench::report("save()", bench::time_best([&] { dsacpp::save(v, path); }, 3), n);
+
+   bench::report("vector_view open + first/last element", bench::time_best([&] {
+      dsacpp::vector_view<std::uint64_t> view(path);
+      bench::keep(view.front() + view.back());
+   }), n);
+
+   bench::report("vector_view open + full scan", bench::time_best([&] {
+      dsacpp::vector_view<std::uint64_t> view(path);
+      std::uint64_t sum = 0;
+      for (std::uint64_t x : view) sum += x;
+      bench::keep(sum);
+   }), n);
+
+   bench::report("vector_view open with checksum", bench::time_best([&] {
+      dsacpp::vector_view<std::uint64_t> view(path, true);
+      bench::keep(view.size());
+   }), n);
+
+   bench::report("ifstream read into vector", bench::time_best([&] {
+      std::ifstream in(path, std::ios::binary);
+      in.seekg(static_cast<std::streamoff>(dsacpp::VECTOR_FILE_ALIGNMENT));
+      dsacpp::vector<std::uint64_t> copy;
+      copy.resize_for_overwrite(N);
+      in.read(reinterpret_cast<char*>(copy.data()), static_cast<std::streamsize>(N * sizeof(std::uint64_t)));
+      bench::keep(copy);
+   }), n);
+
+   std::remove(path.c_str());
+   return 0;
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__BMI2__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DSACPP_BIT_VECTOR_BMI2 1
+#endif
+
+namespace dsacpp
+{
+
+/**
+ * Runtime-sized sequence of bits packed into 64-bit words, with rank and
+ * select once build_index() has run. The index is two-level: the count of
+ * ones before every superblock of 64K bits, and before every 512-bit block
+ * relative to its superblock, about 3% on top of the bits. Rank adds at
+ * most eight word popcounts to that; select starts from a sample taken
+ * every SELECT_SAMPLE ones (or zeros), binary searches the blocks up to
+ * the next sample and finishes inside one word.
+ *
+ * Any modification drops the index; rank and select need it rebuilt.
+ */
+class bit_vector {
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using size_type = std::size_t;
+   using word_type = std::uint64_t;
+
+   static constexpr size_type WORD_BITS = CHAR_BIT * sizeof(word_type);
+   static constexpr size_type SELECT_SAMPLE = 4096;
+
+   /**
+    * Constructors
+    */
+
+   bit_vector() noexcept = default;
+
+   explicit bit_vector(size_type n, bool value = false);
+
+   /**
+    * Modifiers
+    */
+
+   void push_back(bool bit);
+   void set(size_type i, bool value = true) noexcept;
+   void reserve(size_type n);
+   void clear() noexcept;
+
+   /**
+    * Element access
+    */
+
+   bool operator[](size_type i) const noexcept;
+
+   const word_type* data() const noexcept;
+   size_type word_count() const noexcept;
+
+   /**
+    * Rank and select
+    */
+
+   void build_index();
+
+   // ones in [0, i)
+   size_type rank1(size_type i) const noexcept;
+   size_type rank0(size_type i) const noexcept;
+
+   // position of the k-th one (zero), counting from 0; k < count1() (count0())
+   size_type select1(size_type k) const noexcept;
+   size_type select0(size_type k) const noexcept;
+
+   size_type count1() const noexcept;
+   size_type count0() const noexcept;
+
+   /**
+    * Getters
+    */
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+   // bytes held by the bits and the index
+   size_type memory_usage() const noexcept;
+
+private:
+
+   static constexpr size_type BLOCK_WORDS = 8;
+   static constexpr size_type BLOCK_BITS = BLOCK_WORDS * WORD_BITS;
+   static constexpr size_type SUPER_BLOCKS = 128;
+
+   std::vector<word_type> words_;
+   size_type size_ = 0;
+   size_type ones_ = 0;
+   // ones before each superblock
+   std::vector<std::uint64_t> super_;
+   // ones before each block since its superblock began, one past the last block too
+   std::vector<std::uint16_t> blocks_;
+   // block holding the (j * SELECT_SAMPLE)-th one, and the same for zeros
+   std::vector<std::uint32_t> select1_;
+   std::vector<std::uint32_t> select0_;
+
+   size_type _block_count() const noexcept;
+
+   // ones before block b
+   size_type _ones_before(size_type b) const noexcept;
+
+   template<bool One>
+   size_type _select(size_type k, const std::vector<std::uint32_t>& samples) const noexcept;
+
+   // position of the r-th set bit of word, counting from 0
+   static size_type _select_in_word(word_type word, size_type r) noexcept;
+
+   static size_type _popcount(word_type word) noexcept;
+};
+
+/**
+ * Constructors
+ */
+
+inline bit_vector::bit_vector(size_type n, bool value) :
+   words_((n + WORD_BITS - 1) / WORD_BITS, value ? ~word_type{ 0 } : 0),
+   size_{ n }
+{
+   // bits past the end stay clear
+   if (value && n % WORD_BITS) words_.back() >>= WORD_BITS - n % WORD_BITS;
+}
+
+/**
+ * Modifiers
+ */
+
+inline void bit_vector::push_back(bool bit) {
+   if (size_ % WORD_BITS == 0) words_.push_back(0);
+   if (bit) words_.back() |= word_type{ 1 } << (size_ % WORD_BITS);
+   size_++;
+   super_.clear();
+}
+
+inline void bit_vector::set(size_type i, bool value) noexcept {
+   word_type mask = word_type{ 1 } << (i % WORD_BITS);
+   if (value) words_[i / WORD_BITS] |= mask;
+   else words_[i / WORD_BITS] &= ~mask;
+   super_.clear();
+}
+
+inline void bit_vector::reserve(size_type n) {
+   words_.reserve((n + WORD_BITS - 1) / WORD_BITS);
+}
+
+inline void bit_vector::clear() noexcept {
+   words_.clear();
+   size_ = 0;
+   ones_ = 0;
+   super_.clear();
+   blocks_.clear();
+   select1_.clear();
+   select0_.clear();
+}
+
+/**
+ * Element access
+ */
+
+inline bool bit_vector::operator[](size_type i) const noexcept {
+   return (words_[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+inline const bit_vector::word_type* bit_vector::data() const noexcept {
+   return words_.data();
+}
+
+inline bit_vector::size_type bit_vector::word_count() const noexcept {
+   return words_.size();
+}
+
+/**
+ * Rank and select
+ */
+
+inline void bit_vector::build_index() {
+   size_type blocks = _block_count();
+   super_.assign(blocks / SUPER_BLOCKS + 1, 0);
+   blocks_.assign(blocks + 1, 0);
+   select1_.clear();
+   select0_.clear();
+
+   size_type ones = 0;
+   for (size_type b = 0; b < blocks; b++) {
+      if (b % SUPER_BLOCKS == 0) super_[b / SUPER_BLOCKS] = ones;
+      blocks_[b] = static_cast<std::uint16_t>(ones - super_[b / SUPER_BLOCKS]);
+      size_type end = std::min((b + 1) * BLOCK_WORDS, words_.size());
+      size_type next = ones;
+      for (size_type w = b * BLOCK_WORDS; w < end; w++) next += _popcount(words_[w]);
+      // samples falling inside this block
+      while (select1_.size() * SELECT_SAMPLE < next) select1_.push_back(static_cast<std::uint32_t>(b));
+      size_type zeros = std::min((b + 1) * BLOCK_BITS, size_) - next;
+      while (select0_.size() * SELECT_SAMPLE < zeros) select0_.push_back(static_cast<std::uint32_t>(b));
+      ones = next;
+   }
+   if (blocks % SUPER_BLOCKS == 0) super_[blocks / SUPER_BLOCKS] = ones;
+   blocks_[blocks] = static_cast<std::uint16_t>(ones - super_[blocks / SUPER_BLOCKS]);
+   ones_ = ones;
+}
+
+inline bit_vector::size_type bit_vector::rank1(size_type i) const noexcept {
+   size_type b = i / BLOCK_BITS;
+   size_type rank = _ones_before(b);
+   size_type w = b * BLOCK_WORDS;
+   for (; w < i / WORD_BITS; w++) rank += _popcount(words_[w]);
+   if (i % WORD_BITS) rank += _popcount(words_[w] & ((word_type{ 1 } << (i % WORD_BITS)) - 1));
+   return rank;
+}
+
+inline bit_vector::size_type bit_vector::rank0(size_type i) const noexcept {
+   return i - rank1(i);
+}
+
+inline bit_vector::size_type bit_vector::select1(size_type k) const noexcept {
+   return _select<true>(k, select1_);
+}
+
+inline bit_vector::size_type bit_vector::select0(size_type k) const noexcept {
+   return _select<false>(k, select0_);
+}
+
+inline bit_vector::size_type bit_vector::count1() const noexcept {
+   return ones_;
+}
+
+inline bit_vector::size_type bit_vector::count0() const noexcept {
+   return size_ - ones_;
+}
+
+/**
+ * Getters
+ */
+
+inline bit_vector::size_type bit_vector::size() const noexcept {
+   return size_;
+}
+
+inline bool bit_vector::empty() const noexcept {
+   return size_ == 0;
+}
+
+inline bit_vector::size_type bit_vector::memory_usage() const noexcept {
+   return words_.capacity() * sizeof(word_type)
+        + super_.capacity() * sizeof(std::uint64_t)
+        + blocks_.capacity() * sizeof(std::uint16_t)
+        + (select1_.capacity() + select0_.capacity()) * sizeof(std::uint32_t);
+}
+
+inline bit_vector::size_type bit_vector::_block_count() const noexcept {
+   return (words_.size() + BLOCK_WORDS - 1) / BLOCK_WORDS;
+}
+
+inline bit_vector::size_type bit_vector::_ones_before(size_type b) const noexcept {
+   return super_[b / SUPER_BLOCKS] + blocks_[b];
+}
+
+template<bool One>
+bit_vector::size_type bit_vector::_select(size_type k, const std::vector<std::uint32_t>& samples) const noexcept {
+   auto before = [this](size_type b) {
+      size_type ones = _ones_before(b);
+      return One ? ones : b * BLOCK_BITS - ones;
+   };
+   // last block with at most k before it, between this sample and the next
+   size_type lo = samples[k / SELECT_SAMPLE];
+   size_type hi = k / SELECT_SAMPLE + 1 < samples.size() ? samples[k / SELECT_SAMPLE + 1] + 1 : _block_count();
+   while (hi - lo > 1) {
+      size_type mid = lo + (hi - lo) / 2;
+      if (before(mid) <= k) lo = mid;
+      else hi = mid;
+   }
+   size_type r = k - before(lo);
+   for (size_type w = lo * BLOCK_WORDS; ; w++) {
+      word_type word = One ? words_[w] : ~words_[w];
+      size_type count = _popcount(word);
+      if (r < count) return w * WORD_BITS + _select_in_word(word, r);
+      r -= count;
+   }
+}
+
+inline bit_vector::size_type bit_vector::_select_in_word(word_type word, size_type r) noexcept {
+#if DSACPP_BIT_VECTOR_BMI2
+   return static_cast<size_type>(__builtin_ctzll(_pdep_u64(word_type{ 1 } << r, word)));
+#else
+   // skip whole bytes, then clear the lowest set bits of the last one
+   size_type shift = 0;
+   for (;;) {
+      size_type count = _popcount(word & 0xff);
+      if (r < count) break;
+      r -= count;
+      word >>= 8;
+      shift += 8;
+   }
+   for (; r; r--) word &= word - 1;
+   return shift + static_cast<size_type>(__builtin_ctzll(word));
+#endif
+}
+
+inline bit_vector::size_type bit_vector::_popcount(word_type word) noexcept {
+   return static_cast<size_type>(__builtin_popcountll(word));
+}
+
+} // namespace dsacpp
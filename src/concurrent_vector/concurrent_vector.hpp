@@ -0,0 +1,658 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "../vector/vector.hpp"
+
+namespace dsacpp
+{
+
+template<typename Container, typename Value>
+class concurrent_vector_iterator;
+
+/**
+ * Append-only vector for many concurrent writers. Storage is a table of
+ * segments of FIRST_SEGMENT, 2 * FIRST_SEGMENT, 4 * FIRST_SEGMENT, ...
+ * elements, so growing allocates a new segment instead of moving the old
+ * ones: references, pointers and iterators stay valid for the life of the
+ * container.
+ *
+ * push_back, emplace_back and grow_by claim their slots with one fetch_add
+ * and may run alongside each other and alongside readers. size() counts
+ * claimed slots, some of which may still be under construction:
+ *    - operator[] requires the element to be constructed, e.g. the caller
+ *      got the index from its own push_back or saw constructed(i)
+ *    - at() and iterator dereference wait for an in-flight element
+ * A slot whose constructor threw stays empty for good; constructed() is
+ * false for it and at() throws. If a segment cannot be allocated, all of
+ * its slots count as failed and appends landing in it throw bad_alloc
+ * until clear(). clear(), swap, assignment and destruction must not
+ * overlap any other operation.
+ */
+template<typename T, typename Allocator = allocator<T>>
+class concurrent_vector {
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using value_type              = T;
+   using size_type               = std::size_t;
+   using difference_type         = std::ptrdiff_t;
+   using reference               = T&;
+   using const_reference         = const T&;
+   using pointer                 = T*;
+   using const_pointer           = const T*;
+   using allocator_type          = Allocator;
+
+   using iterator                = concurrent_vector_iterator<concurrent_vector, T>;
+   using const_iterator          = concurrent_vector_iterator<const concurrent_vector, const T>;
+
+   static constexpr size_type FIRST_SEGMENT_LOG2 = 5;
+   static constexpr size_type FIRST_SEGMENT = size_type{ 1 } << FIRST_SEGMENT_LOG2;
+
+   /**
+    * Constructors
+    */
+
+   concurrent_vector() noexcept(noexcept(Allocator()));
+   explicit concurrent_vector(const allocator_type& alloc) noexcept;
+
+   concurrent_vector(const concurrent_vector& other);
+   concurrent_vector(concurrent_vector&& other) noexcept;
+
+   ~concurrent_vector();
+
+   /**
+    * Element access
+    */
+
+   reference at(size_type index);
+   const_reference at(size_type index) const;
+
+   reference operator[](size_type index) noexcept;
+   const_reference operator[](size_type index) const noexcept;
+
+   // true once the element at index is fully constructed
+   bool constructed(size_type index) const noexcept;
+
+   /**
+    * Iterators
+    */
+
+   iterator begin() noexcept;
+   iterator end() noexcept;
+   const_iterator begin() const noexcept;
+   const_iterator end() const noexcept;
+   const_iterator cbegin() const noexcept;
+   const_iterator cend() const noexcept;
+
+   /**
+    * Modifiers, safe to call concurrently
+    */
+
+   iterator push_back(const T& value);
+   iterator push_back(T&& value);
+
+   template<typename... Args>
+   iterator emplace_back(Args&&... args);
+
+   // append count copies of value in one reservation, returning the first
+   iterator grow_by(size_type count, const T& value = T());
+
+   // allocate segments up front so appends below capacity never allocate
+   void reserve(size_type new_cap);
+
+   /**
+    * Modifiers, not safe to call concurrently
+    */
+
+   void clear() noexcept;
+   void swap(concurrent_vector& other) noexcept;
+
+   /**
+    * Capacity and misc
+    */
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+   size_type capacity() const noexcept;
+   allocator_type get_allocator() const noexcept;
+
+   /**
+    * Assignment
+    */
+
+   concurrent_vector& operator=(const concurrent_vector& other);
+   concurrent_vector& operator=(concurrent_vector&& other) noexcept;
+
+private:
+
+   template<typename Container, typename Value>
+   friend class concurrent_vector_iterator;
+
+   using alloc_traits = std::allocator_traits<Allocator>;
+   using state_type = std::atomic<unsigned char>;
+
+   enum : unsigned char { PENDING = 0, READY = 1, FAILED = 2 };
+
+   // enough segments to index every size_type
+   static constexpr size_type SEGMENT_COUNT = sizeof(size_type) * 8 - FIRST_SEGMENT_LOG2;
+
+   struct Location {
+      size_type segment;
+      size_type offset;
+   };
+
+   [[no_unique_address]] allocator_type alloc_;
+
+   // the claim counter gets a line to itself so appends do not bounce the table
+   alignas(64) std::atomic<size_type> size_;
+   alignas(64) std::atomic<pointer> segments_[SEGMENT_COUNT];
+
+   static Location _locate(size_type index) noexcept;
+   static size_type _segment_size(size_type segment) noexcept;
+
+   // per-slot construction states live in the same block, after the elements
+   static size_type _block_size(size_type segment) noexcept;
+   static state_type* _states(pointer block, size_type segment) noexcept;
+
+   pointer _segment(size_type segment);
+
+   // stands in for a segment whose allocation failed under claimed slots
+   static pointer _dead_segment() noexcept;
+
+   // _segment() for a writer holding slots in it: a failed allocation
+   // marks the segment dead so nobody waits on those slots
+   pointer _claimed_segment(size_type segment);
+
+   // mark claimed slots [first, last) failed after a throw
+   void _abandon(size_type first, size_type last) noexcept;
+
+   pointer _slot(size_type index) const noexcept;
+   state_type& _state(size_type index) const noexcept;
+
+   // spin until the slot leaves PENDING; true if it holds an element
+   bool _wait(size_type index) const noexcept;
+
+   void _destroy() noexcept;
+};
+
+/**
+ * Random access over slot indices. Dereference waits for a slot that is
+ * still being constructed; it must not reach a slot whose constructor threw.
+ */
+template<typename Container, typename Value>
+class concurrent_vector_iterator {
+public:
+   using value_type        = std::remove_const_t<Value>;
+   using reference         = Value&;
+   using pointer           = Value*;
+   using difference_type   = std::ptrdiff_t;
+   using iterator_category = std::random_access_iterator_tag;
+
+   concurrent_vector_iterator() noexcept : vec_{ nullptr }, index_{ 0 } { }
+   concurrent_vector_iterator(Container* vec, std::size_t index) noexcept : vec_{ vec }, index_{ index } { }
+
+   // iterator to const_iterator
+   template<typename C, typename V, typename = std::enable_if_t<std::is_const<Value>::value && !std::is_const<V>::value>>
+   concurrent_vector_iterator(const concurrent_vector_iterator<C, V>& other) noexcept :
+      vec_{ other.vec_ }, index_{ other.index_ } { }
+
+   // dereference and pointer access
+   reference operator*() const noexcept { return *operator->(); }
+   pointer operator->() const noexcept {
+      [[maybe_unused]] bool ok = vec_->_wait(index_);
+      assert(ok && "dereferencing a slot whose constructor threw");
+      return vec_->_slot(index_);
+   }
+   reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+   // index in the container, e.g. to learn where push_back put an element
+   std::size_t index() const noexcept { return index_; }
+
+   // increment/decrement
+   concurrent_vector_iterator& operator++() noexcept { ++index_; return *this; }
+   concurrent_vector_iterator operator++(int) noexcept { auto tmp = *this; ++index_; return tmp; }
+   concurrent_vector_iterator& operator--() noexcept { --index_; return *this; }
+   concurrent_vector_iterator operator--(int) noexcept { auto tmp = *this; --index_; return tmp; }
+
+   // arithmetic
+   concurrent_vector_iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+   concurrent_vector_iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+   concurrent_vector_iterator operator+(difference_type n) const noexcept { return { vec_, index_ + n }; }
+   concurrent_vector_iterator operator-(difference_type n) const noexcept { return { vec_, index_ - n }; }
+   difference_type operator-(const concurrent_vector_iterator& other) const noexcept {
+      return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+   }
+
+   // comparisons
+   bool operator==(const concurrent_vector_iterator& other) const noexcept { return index_ == other.index_; }
+   bool operator!=(const concurrent_vector_iterator& other) const noexcept { return index_ != other.index_; }
+   bool operator<(const concurrent_vector_iterator& other) const noexcept { return index_ < other.index_; }
+   bool operator>(const concurrent_vector_iterator& other) const noexcept { return index_ > other.index_; }
+   bool operator<=(const concurrent_vector_iterator& other) const noexcept { return index_ <= other.index_; }
+   bool operator>=(const concurrent_vector_iterator& other) const noexcept { return index_ >= other.index_; }
+
+private:
+   template<typename C, typename V>
+   friend class concurrent_vector_iterator;
+
+   Container* vec_;
+   std::size_t index_;
+};
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>::concurrent_vector() noexcept(noexcept(Allocator())) :
+   concurrent_vector(Allocator())
+{ }
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>::concurrent_vector(const allocator_type& alloc) noexcept :
+   alloc_{ alloc },
+   size_{ 0 },
+   segments_{}
+{ }
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>::concurrent_vector(const concurrent_vector& other) :
+   concurrent_vector(alloc_traits::select_on_container_copy_construction(other.alloc_))
+{
+   size_type n = other.size();
+   reserve(n);
+   try {
+      for (size_type i = 0; i < n; i++) {
+         // failed slots are copied as failed slots so indices line up
+         if (other._wait(i)) {
+            alloc_traits::construct(alloc_, _slot(i), other[i]);
+            _state(i).store(READY, std::memory_order_relaxed);
+         } else {
+            _state(i).store(FAILED, std::memory_order_relaxed);
+         }
+         size_.store(i + 1, std::memory_order_relaxed);
+      }
+   } catch (...) {
+      _destroy();
+      throw;
+   }
+}
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>::concurrent_vector(concurrent_vector&& other) noexcept :
+   concurrent_vector(std::move(other.alloc_))
+{
+   swap(other);
+}
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>::~concurrent_vector() {
+   _destroy();
+}
+
+/**
+ * Element access
+ */
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::reference concurrent_vector<T, Allocator>::at(size_type index) {
+   if (index >= size() || !_wait(index)) {
+      detail::throw_out_of_range("concurrent_vector::at", index, size());
+   }
+   return *_slot(index);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::const_reference concurrent_vector<T, Allocator>::at(size_type index) const {
+   if (index >= size() || !_wait(index)) {
+      detail::throw_out_of_range("concurrent_vector::at", index, size());
+   }
+   return *_slot(index);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::reference concurrent_vector<T, Allocator>::operator[](size_type index) noexcept {
+   return *_slot(index);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::const_reference concurrent_vector<T, Allocator>::operator[](size_type index) const noexcept {
+   return *_slot(index);
+}
+
+template<typename T, typename Allocator>
+bool concurrent_vector<T, Allocator>::constructed(size_type index) const noexcept {
+   if (index >= size()) return false;
+   Location loc = _locate(index);
+   pointer block = segments_[loc.segment].load(std::memory_order_acquire);
+   if (!block || block == _dead_segment()) return false;
+   return _states(block, loc.segment)[loc.offset].load(std::memory_order_acquire) == READY;
+}
+
+/**
+ * Iterators
+ */
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::iterator concurrent_vector<T, Allocator>::begin() noexcept {
+   return iterator(this, 0);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::iterator concurrent_vector<T, Allocator>::end() noexcept {
+   return iterator(this, size());
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::const_iterator concurrent_vector<T, Allocator>::begin() const noexcept {
+   return const_iterator(this, 0);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::const_iterator concurrent_vector<T, Allocator>::end() const noexcept {
+   return const_iterator(this, size());
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::const_iterator concurrent_vector<T, Allocator>::cbegin() const noexcept {
+   return begin();
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::const_iterator concurrent_vector<T, Allocator>::cend() const noexcept {
+   return end();
+}
+
+/**
+ * Modifiers
+ */
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::iterator concurrent_vector<T, Allocator>::push_back(const T& value) {
+   return emplace_back(value);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::iterator concurrent_vector<T, Allocator>::push_back(T&& value) {
+   return emplace_back(std::move(value));
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+typename concurrent_vector<T, Allocator>::iterator concurrent_vector<T, Allocator>::emplace_back(Args&&... args) {
+   size_type index = size_.fetch_add(1, std::memory_order_relaxed);
+   Location loc = _locate(index);
+   pointer block = _claimed_segment(loc.segment);
+   state_type& state = _states(block, loc.segment)[loc.offset];
+   try {
+      alloc_traits::construct(alloc_, block + loc.offset, std::forward<Args>(args)...);
+   } catch (...) {
+      state.store(FAILED, std::memory_order_release);
+      throw;
+   }
+   state.store(READY, std::memory_order_release);
+   return iterator(this, index);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::iterator concurrent_vector<T, Allocator>::grow_by(size_type count, const T& value) {
+   size_type first = size_.fetch_add(count, std::memory_order_relaxed);
+   size_type i = first;
+   try {
+      while (i < first + count) {
+         // fill one segment at a time
+         Location loc = _locate(i);
+         pointer block = _claimed_segment(loc.segment);
+         state_type* states = _states(block, loc.segment);
+         size_type stop = _segment_size(loc.segment) - loc.offset;
+         if (stop > first + count - i) stop = first + count - i;
+         for (size_type k = loc.offset; k < loc.offset + stop; k++, i++) {
+            alloc_traits::construct(alloc_, block + k, value);
+            states[k].store(READY, std::memory_order_release);
+         }
+      }
+   } catch (...) {
+      // slots are claimed for good, so mark whatever is left as failed
+      _abandon(i, first + count);
+      throw;
+   }
+   return iterator(this, first);
+}
+
+template<typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::reserve(size_type new_cap) {
+   if (new_cap == 0) return;
+   Location last = _locate(new_cap - 1);
+   for (size_type s = 0; s <= last.segment; s++) {
+      _segment(s);
+   }
+}
+
+template<typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::clear() noexcept {
+   _destroy();
+   size_.store(0, std::memory_order_relaxed);
+}
+
+template<typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::swap(concurrent_vector& other) noexcept {
+   using std::swap;
+   swap(alloc_, other.alloc_);
+   size_type n = size_.load(std::memory_order_relaxed);
+   size_.store(other.size_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+   other.size_.store(n, std::memory_order_relaxed);
+   for (size_type s = 0; s < SEGMENT_COUNT; s++) {
+      pointer p = segments_[s].load(std::memory_order_relaxed);
+      segments_[s].store(other.segments_[s].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      other.segments_[s].store(p, std::memory_order_relaxed);
+   }
+}
+
+/**
+ * Capacity and misc
+ */
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::size_type concurrent_vector<T, Allocator>::size() const noexcept {
+   return size_.load(std::memory_order_acquire);
+}
+
+template<typename T, typename Allocator>
+bool concurrent_vector<T, Allocator>::empty() const noexcept {
+   return size() == 0;
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::size_type concurrent_vector<T, Allocator>::capacity() const noexcept {
+   // segments are allocated in order, so capacity ends at the first gap
+   size_type cap = 0;
+   for (size_type s = 0; s < SEGMENT_COUNT; s++) {
+      pointer block = segments_[s].load(std::memory_order_acquire);
+      if (!block || block == _dead_segment()) break;
+      cap += _segment_size(s);
+   }
+   return cap;
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::allocator_type concurrent_vector<T, Allocator>::get_allocator() const noexcept {
+   return alloc_;
+}
+
+/**
+ * Assignment
+ */
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>& concurrent_vector<T, Allocator>::operator=(const concurrent_vector& other) {
+   if (this != &other) {
+      concurrent_vector tmp(other);
+      swap(tmp);
+   }
+   return *this;
+}
+
+template<typename T, typename Allocator>
+concurrent_vector<T, Allocator>& concurrent_vector<T, Allocator>::operator=(concurrent_vector&& other) noexcept {
+   if (this != &other) {
+      clear();
+      swap(other);
+   }
+   return *this;
+}
+
+/**
+ * Private helpers
+ */
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::Location concurrent_vector<T, Allocator>::_locate(size_type index) noexcept {
+   // segment s starts at FIRST_SEGMENT * (2^s - 1), so shifting by
+   // FIRST_SEGMENT turns the segment into the position of the top bit
+   size_type shifted = index + FIRST_SEGMENT;
+   size_type top = sizeof(size_type) * 8 - 1 - static_cast<size_type>(__builtin_clzll(shifted));
+   return { top - FIRST_SEGMENT_LOG2, shifted - (size_type{ 1 } << top) };
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::size_type concurrent_vector<T, Allocator>::_segment_size(size_type segment) noexcept {
+   return FIRST_SEGMENT << segment;
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::size_type concurrent_vector<T, Allocator>::_block_size(size_type segment) noexcept {
+   size_type n = _segment_size(segment);
+   return n + (n * sizeof(state_type) + sizeof(T) - 1) / sizeof(T);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::state_type* concurrent_vector<T, Allocator>::_states(pointer block, size_type segment) noexcept {
+   return reinterpret_cast<state_type*>(block + _segment_size(segment));
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::pointer concurrent_vector<T, Allocator>::_segment(size_type segment) {
+   pointer block = segments_[segment].load(std::memory_order_acquire);
+   if (block == _dead_segment()) throw std::bad_alloc();
+   if (block) return block;
+
+   // racing threads each build a block; the loser of the publish frees its own
+   pointer fresh = alloc_traits::allocate(alloc_, _block_size(segment));
+   state_type* states = _states(fresh, segment);
+   for (size_type k = 0; k < _segment_size(segment); k++) {
+      ::new (static_cast<void*>(states + k)) state_type(PENDING);
+   }
+   if (segments_[segment].compare_exchange_strong(block, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return fresh;
+   }
+   alloc_traits::deallocate(alloc_, fresh, _block_size(segment));
+   if (block == _dead_segment()) throw std::bad_alloc();
+   return block;
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::pointer concurrent_vector<T, Allocator>::_dead_segment() noexcept {
+   alignas(T) static unsigned char tag[sizeof(T)];
+   return reinterpret_cast<pointer>(tag);
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::pointer concurrent_vector<T, Allocator>::_claimed_segment(size_type segment) {
+   try {
+      return _segment(segment);
+   } catch (...) {
+      // our slots have no states to mark, so the whole segment fails;
+      // if another writer published a block meanwhile, use that instead
+      pointer block = nullptr;
+      if (!segments_[segment].compare_exchange_strong(block, _dead_segment(), std::memory_order_acq_rel, std::memory_order_acquire)
+          && block != _dead_segment()) {
+         return block;
+      }
+      throw;
+   }
+}
+
+template<typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::_abandon(size_type first, size_type last) noexcept {
+   while (first < last) {
+      Location loc = _locate(first);
+      size_type stop = _segment_size(loc.segment) - loc.offset;
+      if (stop > last - first) stop = last - first;
+      pointer block;
+      try {
+         block = _claimed_segment(loc.segment);
+      } catch (...) {
+         block = _dead_segment();
+      }
+      if (block != _dead_segment()) {
+         state_type* states = _states(block, loc.segment);
+         for (size_type k = loc.offset; k < loc.offset + stop; k++) {
+            states[k].store(FAILED, std::memory_order_release);
+         }
+      }
+      first += stop;
+   }
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::pointer concurrent_vector<T, Allocator>::_slot(size_type index) const noexcept {
+   Location loc = _locate(index);
+   return segments_[loc.segment].load(std::memory_order_acquire) + loc.offset;
+}
+
+template<typename T, typename Allocator>
+typename concurrent_vector<T, Allocator>::state_type& concurrent_vector<T, Allocator>::_state(size_type index) const noexcept {
+   Location loc = _locate(index);
+   return _states(segments_[loc.segment].load(std::memory_order_acquire), loc.segment)[loc.offset];
+}
+
+template<typename T, typename Allocator>
+bool concurrent_vector<T, Allocator>::_wait(size_type index) const noexcept {
+   Location loc = _locate(index);
+   pointer block;
+   // the claiming thread may not have published the segment yet
+   while (!(block = segments_[loc.segment].load(std::memory_order_acquire))) {
+      std::this_thread::yield();
+   }
+   if (block == _dead_segment()) return false;
+   state_type& state = _states(block, loc.segment)[loc.offset];
+   unsigned char s;
+   while ((s = state.load(std::memory_order_acquire)) == PENDING) {
+      std::this_thread::yield();
+   }
+   return s == READY;
+}
+
+template<typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::_destroy() noexcept {
+   size_type n = size_.load(std::memory_order_relaxed);
+   for (size_type s = 0; s < SEGMENT_COUNT; s++) {
+      pointer block = segments_[s].load(std::memory_order_relaxed);
+      if (!block) continue;
+      if (block == _dead_segment()) {
+         segments_[s].store(nullptr, std::memory_order_relaxed);
+         continue;
+      }
+      size_type begin = FIRST_SEGMENT * ((size_type{ 1 } << s) - 1);
+      state_type* states = _states(block, s);
+      if constexpr (!std::is_trivially_destructible<T>::value) {
+         for (size_type k = 0; k < _segment_size(s) && begin + k < n; k++) {
+            if (states[k].load(std::memory_order_relaxed) == READY) {
+               alloc_traits::destroy(alloc_, block + k);
+            }
+         }
+      }
+      alloc_traits::deallocate(alloc_, block, _block_size(s));
+      segments_[s].store(nullptr, std::memory_order_relaxed);
+   }
+}
+
+} // namespace dsacpp
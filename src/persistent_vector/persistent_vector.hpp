@@ -0,0 +1,854 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "../vector/vector.hpp"
+
+namespace dsacpp
+{
+
+template<typename T, typename Allocator>
+class transient_vector;
+
+template<typename T, typename Allocator>
+class persistent_vector_iterator;
+
+/**
+ * Immutable vector with structural sharing: a 32-way radix trie of leaves
+ * holding 32 elements each, plus a tail leaf for the last (up to) 32
+ * elements. push_back, set, pop_back and slice leave *this untouched and
+ * return a new version that copies only the O(log32 n) nodes on the path
+ * they change; copying a version is O(1).
+ *
+ * Nodes are reference counted atomically, so versions may be shared freely
+ * between threads; a single version object follows the usual rules (no
+ * concurrent writes to the same object). A node whose count is one, with
+ * every node above it also at one, is owned outright by its version and is
+ * updated in place instead of copied. transient_vector builds on this for
+ * batch updates.
+ *
+ * slice() keeps the leading part of the trie reachable until the slice
+ * itself goes away, as the elements before it are skipped rather than
+ * removed.
+ */
+template<typename T, typename Allocator = allocator<T>>
+class persistent_vector {
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using value_type              = T;
+   using size_type               = std::size_t;
+   using difference_type         = std::ptrdiff_t;
+   using reference               = const T&;
+   using const_reference         = const T&;
+   using allocator_type          = Allocator;
+
+   using iterator                = persistent_vector_iterator<T, Allocator>;
+   using const_iterator          = persistent_vector_iterator<T, Allocator>;
+   using transient_type          = transient_vector<T, Allocator>;
+
+   static constexpr size_type BITS = 5;
+   static constexpr size_type BRANCH = size_type{ 1 } << BITS;
+
+   /**
+    * Constructors
+    */
+
+   persistent_vector() noexcept(noexcept(Allocator()));
+   explicit persistent_vector(const allocator_type& alloc) noexcept;
+
+   persistent_vector(std::initializer_list<value_type> init_list, const allocator_type& alloc = Allocator());
+
+   // SNIFAE
+   template<
+      typename iter,
+      typename = std::enable_if_t<
+                  std::is_base_of<
+                  std::input_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value
+      >
+   >
+   persistent_vector(iter begin, iter end, const allocator_type& alloc = Allocator());
+
+   persistent_vector(const persistent_vector& other) noexcept;
+   persistent_vector(persistent_vector&& other) noexcept;
+
+   ~persistent_vector();
+
+   persistent_vector& operator=(const persistent_vector& other) noexcept;
+   persistent_vector& operator=(persistent_vector&& other) noexcept;
+
+   /**
+    * Getters
+    */
+
+   const_reference at(size_type index) const;
+   const_reference operator[](size_type index) const noexcept;
+
+   const_reference front() const;
+   const_reference back() const;
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+   allocator_type get_allocator() const noexcept;
+
+   /**
+    * Iterators
+    */
+
+   const_iterator begin() const noexcept;
+   const_iterator end() const noexcept;
+   const_iterator cbegin() const noexcept;
+   const_iterator cend() const noexcept;
+
+   /**
+    * New versions
+    */
+
+   persistent_vector push_back(const T& value) const;
+   persistent_vector push_back(T&& value) const;
+
+   persistent_vector set(size_type index, const T& value) const;
+   persistent_vector set(size_type index, T&& value) const;
+
+   persistent_vector pop_back() const;
+
+   // elements [begin, end)
+   persistent_vector slice(size_type begin, size_type end) const;
+
+   /**
+    * Conversions
+    */
+
+   // mutable builder starting from this version, for batches of updates
+   transient_type transient() const noexcept;
+
+   vector<T, Allocator> to_vector() const;
+
+   void swap(persistent_vector& other) noexcept;
+
+private:
+
+   friend class transient_vector<T, Allocator>;
+
+   struct node {
+      std::atomic<size_type> refs;
+   };
+
+   struct branch : node {
+      node* children[BRANCH];
+   };
+
+   // trie leaves are always full; only the tail leaf is partly filled
+   struct leaf : node {
+      size_type count;
+      alignas(T) unsigned char storage[sizeof(T) * BRANCH];
+
+      T* data() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+   };
+
+   using alloc_traits = std::allocator_traits<Allocator>;
+   using branch_allocator = typename alloc_traits::template rebind_alloc<branch>;
+   using leaf_allocator = typename alloc_traits::template rebind_alloc<leaf>;
+
+   [[no_unique_address]] allocator_type alloc_;
+   branch* root_;
+   leaf* tail_;
+   // height of root_ in bits: leaves hang off branches at shift BITS
+   size_type shift_;
+   // elements in the trie and tail together, including any skipped by offset_
+   size_type count_;
+   // first element visible through this version, see slice()
+   size_type offset_;
+
+   size_type _tail_offset() const noexcept;
+   size_type _tail_count() const noexcept;
+
+   // leaf data holding underlying element index
+   T* _array_for(size_type index) const noexcept;
+
+   branch* _new_branch();
+   leaf* _new_leaf();
+
+   static void _retain(node* n) noexcept;
+
+   // drop a reference to a node at the given height (0 for a leaf)
+   void _release(node* n, size_type shift) noexcept;
+
+   // replace slot with a copy of itself unless it is already owned outright
+   void _own(branch*& slot, size_type shift);
+   void _own(leaf*& slot);
+
+   template<typename... Args>
+   void _push_back(Args&&... args);
+
+   template<typename U>
+   void _set(size_type index, U&& value);
+
+   // hang a full leaf off the trie, taking over the caller's reference
+   void _push_tail(leaf* full);
+
+   // cut the underlying elements down to the first count
+   void _take(size_type count);
+
+   void _clear() noexcept;
+};
+
+/**
+ * Mutable counterpart of persistent_vector for batches of updates. Nodes
+ * the transient has already copied belong to it alone, so follow-up
+ * updates to them happen in place; persistent() hands out the current
+ * state as an ordinary version in O(1) and the transient stays usable.
+ */
+template<typename T, typename Allocator = allocator<T>>
+class transient_vector {
+public:
+
+   using value_type              = T;
+   using size_type               = std::size_t;
+   using const_reference         = const T&;
+
+   transient_vector() = default;
+   explicit transient_vector(persistent_vector<T, Allocator> base) noexcept;
+
+   const_reference at(size_type index) const;
+   const_reference operator[](size_type index) const noexcept;
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+   void push_back(const T& value);
+   void push_back(T&& value);
+
+   template<typename... Args>
+   void emplace_back(Args&&... args);
+
+   void set(size_type index, const T& value);
+   void set(size_type index, T&& value);
+
+   void pop_back();
+
+   persistent_vector<T, Allocator> persistent() const noexcept;
+
+private:
+
+   persistent_vector<T, Allocator> vec_;
+};
+
+/**
+ * Random access over a persistent_vector; each dereference walks the trie
+ * from the root, which is O(log32 n). to_vector() copies a leaf at a time.
+ */
+template<typename T, typename Allocator>
+class persistent_vector_iterator {
+public:
+   using value_type        = T;
+   using reference         = const T&;
+   using pointer           = const T*;
+   using difference_type   = std::ptrdiff_t;
+   using iterator_category = std::random_access_iterator_tag;
+
+   persistent_vector_iterator() noexcept : vec_{ nullptr }, index_{ 0 } { }
+   persistent_vector_iterator(const persistent_vector<T, Allocator>* vec, std::size_t index) noexcept :
+      vec_{ vec }, index_{ index } { }
+
+   // dereference and pointer access
+   reference operator*() const noexcept { return (*vec_)[index_]; }
+   pointer operator->() const noexcept { return &(*vec_)[index_]; }
+   reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+   // increment/decrement
+   persistent_vector_iterator& operator++() noexcept { ++index_; return *this; }
+   persistent_vector_iterator operator++(int) noexcept { auto tmp = *this; ++index_; return tmp; }
+   persistent_vector_iterator& operator--() noexcept { --index_; return *this; }
+   persistent_vector_iterator operator--(int) noexcept { auto tmp = *this; --index_; return tmp; }
+
+   // arithmetic
+   persistent_vector_iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+   persistent_vector_iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+   persistent_vector_iterator operator+(difference_type n) const noexcept { return { vec_, index_ + n }; }
+   persistent_vector_iterator operator-(difference_type n) const noexcept { return { vec_, index_ - n }; }
+   difference_type operator-(const persistent_vector_iterator& other) const noexcept {
+      return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+   }
+
+   // comparisons
+   bool operator==(const persistent_vector_iterator& other) const noexcept { return index_ == other.index_; }
+   bool operator!=(const persistent_vector_iterator& other) const noexcept { return index_ != other.index_; }
+   bool operator<(const persistent_vector_iterator& other) const noexcept { return index_ < other.index_; }
+   bool operator>(const persistent_vector_iterator& other) const noexcept { return index_ > other.index_; }
+   bool operator<=(const persistent_vector_iterator& other) const noexcept { return index_ <= other.index_; }
+   bool operator>=(const persistent_vector_iterator& other) const noexcept { return index_ >= other.index_; }
+
+private:
+   const persistent_vector<T, Allocator>* vec_;
+   std::size_t index_;
+};
+
+/**
+ * persistent_vector
+ */
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>::persistent_vector() noexcept(noexcept(Allocator())) :
+   persistent_vector(Allocator())
+{ }
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>::persistent_vector(const allocator_type& alloc) noexcept :
+   alloc_{ alloc },
+   root_{ nullptr },
+   tail_{ nullptr },
+   shift_{ BITS },
+   count_{ 0 },
+   offset_{ 0 }
+{ }
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>::persistent_vector(std::initializer_list<value_type> init_list, const allocator_type& alloc) :
+   persistent_vector(init_list.begin(), init_list.end(), alloc)
+{ }
+
+template<typename T, typename Allocator>
+template<typename iter, typename>
+persistent_vector<T, Allocator>::persistent_vector(iter begin, iter end, const allocator_type& alloc) :
+   persistent_vector(alloc)
+{
+   try {
+      for (; begin != end; ++begin) {
+         _push_back(*begin);
+      }
+   } catch (...) {
+      _clear();
+      throw;
+   }
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>::persistent_vector(const persistent_vector& other) noexcept :
+   alloc_{ other.alloc_ },
+   root_{ other.root_ },
+   tail_{ other.tail_ },
+   shift_{ other.shift_ },
+   count_{ other.count_ },
+   offset_{ other.offset_ }
+{
+   _retain(root_);
+   _retain(tail_);
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>::persistent_vector(persistent_vector&& other) noexcept :
+   alloc_{ std::move(other.alloc_) },
+   root_{ other.root_ },
+   tail_{ other.tail_ },
+   shift_{ other.shift_ },
+   count_{ other.count_ },
+   offset_{ other.offset_ }
+{
+   other.root_ = nullptr;
+   other.tail_ = nullptr;
+   other.shift_ = BITS;
+   other.count_ = 0;
+   other.offset_ = 0;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>::~persistent_vector() {
+   _clear();
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>& persistent_vector<T, Allocator>::operator=(const persistent_vector& other) noexcept {
+   persistent_vector tmp(other);
+   swap(tmp);
+   return *this;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator>& persistent_vector<T, Allocator>::operator=(persistent_vector&& other) noexcept {
+   persistent_vector tmp(std::move(other));
+   swap(tmp);
+   return *this;
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_reference persistent_vector<T, Allocator>::at(size_type index) const {
+   if (index >= size()) {
+      detail::throw_out_of_range("persistent_vector::at", index, size());
+   }
+   return (*this)[index];
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_reference persistent_vector<T, Allocator>::operator[](size_type index) const noexcept {
+   size_type i = index + offset_;
+   return _array_for(i)[i & (BRANCH - 1)];
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_reference persistent_vector<T, Allocator>::front() const {
+   if (empty()) {
+      throw std::out_of_range("persistent_vector::front empty vector");
+   }
+   return (*this)[0];
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_reference persistent_vector<T, Allocator>::back() const {
+   if (empty()) {
+      throw std::out_of_range("persistent_vector::back empty vector");
+   }
+   return (*this)[size() - 1];
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::size_type persistent_vector<T, Allocator>::size() const noexcept {
+   return count_ - offset_;
+}
+
+template<typename T, typename Allocator>
+bool persistent_vector<T, Allocator>::empty() const noexcept {
+   return count_ == offset_;
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::allocator_type persistent_vector<T, Allocator>::get_allocator() const noexcept {
+   return alloc_;
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_iterator persistent_vector<T, Allocator>::begin() const noexcept {
+   return const_iterator{ this, 0 };
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_iterator persistent_vector<T, Allocator>::end() const noexcept {
+   return const_iterator{ this, size() };
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_iterator persistent_vector<T, Allocator>::cbegin() const noexcept {
+   return begin();
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::const_iterator persistent_vector<T, Allocator>::cend() const noexcept {
+   return end();
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> persistent_vector<T, Allocator>::push_back(const T& value) const {
+   persistent_vector result(*this);
+   result._push_back(value);
+   return result;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> persistent_vector<T, Allocator>::push_back(T&& value) const {
+   persistent_vector result(*this);
+   result._push_back(std::move(value));
+   return result;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> persistent_vector<T, Allocator>::set(size_type index, const T& value) const {
+   persistent_vector result(*this);
+   result._set(index, value);
+   return result;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> persistent_vector<T, Allocator>::set(size_type index, T&& value) const {
+   persistent_vector result(*this);
+   result._set(index, std::move(value));
+   return result;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> persistent_vector<T, Allocator>::pop_back() const {
+   if (empty()) {
+      throw std::out_of_range("persistent_vector::pop_back empty vector");
+   }
+   persistent_vector result(*this);
+   result._take(count_ - 1);
+   return result;
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> persistent_vector<T, Allocator>::slice(size_type begin, size_type end) const {
+   if (end > size()) {
+      detail::throw_out_of_range("persistent_vector::slice", end, size());
+   }
+   if (begin > end) {
+      detail::throw_out_of_range("persistent_vector::slice", begin, end);
+   }
+   persistent_vector result(*this);
+   result._take(offset_ + end);
+   result.offset_ += begin;
+   return result;
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::transient_type persistent_vector<T, Allocator>::transient() const noexcept {
+   return transient_type{ *this };
+}
+
+template<typename T, typename Allocator>
+vector<T, Allocator> persistent_vector<T, Allocator>::to_vector() const {
+   vector<T, Allocator> result(alloc_);
+   result.reserve(size());
+   // copy a leaf at a time rather than walking the trie per element
+   for (size_type i = offset_; i < count_; ) {
+      const T* chunk = _array_for(i);
+      size_type end = (i | (BRANCH - 1)) + 1;
+      if (end > count_) end = count_;
+      for (size_type j = i & (BRANCH - 1); i < end; i++, j++) {
+         result.push_back(chunk[j]);
+      }
+   }
+   return result;
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::swap(persistent_vector& other) noexcept {
+   std::swap(alloc_, other.alloc_);
+   std::swap(root_, other.root_);
+   std::swap(tail_, other.tail_);
+   std::swap(shift_, other.shift_);
+   std::swap(count_, other.count_);
+   std::swap(offset_, other.offset_);
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::size_type persistent_vector<T, Allocator>::_tail_offset() const noexcept {
+   return count_ - _tail_count();
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::size_type persistent_vector<T, Allocator>::_tail_count() const noexcept {
+   return tail_ ? tail_->count : 0;
+}
+
+template<typename T, typename Allocator>
+T* persistent_vector<T, Allocator>::_array_for(size_type index) const noexcept {
+   if (index >= _tail_offset()) return tail_->data();
+   node* n = root_;
+   for (size_type shift = shift_; shift > 0; shift -= BITS) {
+      n = static_cast<branch*>(n)->children[(index >> shift) & (BRANCH - 1)];
+   }
+   return static_cast<leaf*>(n)->data();
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::branch* persistent_vector<T, Allocator>::_new_branch() {
+   branch_allocator alloc(alloc_);
+   branch* b = std::allocator_traits<branch_allocator>::allocate(alloc, 1);
+   new (b) branch;
+   b->refs.store(1, std::memory_order_relaxed);
+   for (size_type i = 0; i < BRANCH; i++) b->children[i] = nullptr;
+   return b;
+}
+
+template<typename T, typename Allocator>
+typename persistent_vector<T, Allocator>::leaf* persistent_vector<T, Allocator>::_new_leaf() {
+   leaf_allocator alloc(alloc_);
+   leaf* l = std::allocator_traits<leaf_allocator>::allocate(alloc, 1);
+   new (l) leaf;
+   l->refs.store(1, std::memory_order_relaxed);
+   l->count = 0;
+   return l;
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_retain(node* n) noexcept {
+   if (n) n->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_release(node* n, size_type shift) noexcept {
+   if (!n || n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+   if (shift == 0) {
+      leaf* l = static_cast<leaf*>(n);
+      for (size_type i = 0; i < l->count; i++) l->data()[i].~T();
+      l->~leaf();
+      leaf_allocator alloc(alloc_);
+      std::allocator_traits<leaf_allocator>::deallocate(alloc, l, 1);
+   } else {
+      branch* b = static_cast<branch*>(n);
+      for (size_type i = 0; i < BRANCH; i++) _release(b->children[i], shift - BITS);
+      b->~branch();
+      branch_allocator alloc(alloc_);
+      std::allocator_traits<branch_allocator>::deallocate(alloc, b, 1);
+   }
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_own(branch*& slot, size_type shift) {
+   if (slot->refs.load(std::memory_order_acquire) == 1) return;
+   branch* copy = _new_branch();
+   for (size_type i = 0; i < BRANCH; i++) {
+      copy->children[i] = slot->children[i];
+      _retain(copy->children[i]);
+   }
+   _release(slot, shift);
+   slot = copy;
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_own(leaf*& slot) {
+   if (slot->refs.load(std::memory_order_acquire) == 1) return;
+   leaf* copy = _new_leaf();
+   try {
+      for (; copy->count < slot->count; copy->count++) {
+         new (copy->data() + copy->count) T(slot->data()[copy->count]);
+      }
+   } catch (...) {
+      _release(copy, 0);
+      throw;
+   }
+   _release(slot, 0);
+   slot = copy;
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+void persistent_vector<T, Allocator>::_push_back(Args&&... args) {
+   if (tail_ && tail_->count < BRANCH) {
+      _own(tail_);
+      new (tail_->data() + tail_->count) T(std::forward<Args>(args)...);
+      tail_->count++;
+      count_++;
+      return;
+   }
+   leaf* fresh = _new_leaf();
+   try {
+      new (fresh->data()) T(std::forward<Args>(args)...);
+      fresh->count = 1;
+      if (tail_) _push_tail(tail_);
+   } catch (...) {
+      _release(fresh, 0);
+      throw;
+   }
+   tail_ = fresh;
+   count_++;
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_push_tail(leaf* full) {
+   size_type index = _tail_offset();
+   if (!root_) {
+      root_ = _new_branch();
+      shift_ = BITS;
+   } else if (index == size_type{ 1 } << (shift_ + BITS)) {
+      // root is full: grow the trie by a level
+      branch* top = _new_branch();
+      top->children[0] = root_;
+      root_ = top;
+      shift_ += BITS;
+   } else {
+      _own(root_, shift_);
+   }
+   branch* parent = root_;
+   for (size_type shift = shift_; shift > BITS; shift -= BITS) {
+      node*& child = parent->children[(index >> shift) & (BRANCH - 1)];
+      if (!child) {
+         child = _new_branch();
+      } else {
+         branch* b = static_cast<branch*>(child);
+         _own(b, shift - BITS);
+         child = b;
+      }
+      parent = static_cast<branch*>(child);
+   }
+   parent->children[(index >> BITS) & (BRANCH - 1)] = full;
+}
+
+template<typename T, typename Allocator>
+template<typename U>
+void persistent_vector<T, Allocator>::_set(size_type index, U&& value) {
+   if (index >= size()) {
+      detail::throw_out_of_range("persistent_vector::set", index, size());
+   }
+   size_type i = index + offset_;
+   if (i >= _tail_offset()) {
+      _own(tail_);
+      tail_->data()[i - _tail_offset()] = std::forward<U>(value);
+      return;
+   }
+   _own(root_, shift_);
+   branch* parent = root_;
+   for (size_type shift = shift_; shift > BITS; shift -= BITS) {
+      node*& child = parent->children[(i >> shift) & (BRANCH - 1)];
+      branch* b = static_cast<branch*>(child);
+      _own(b, shift - BITS);
+      child = b;
+      parent = b;
+   }
+   node*& slot = parent->children[(i >> BITS) & (BRANCH - 1)];
+   leaf* l = static_cast<leaf*>(slot);
+   _own(l);
+   slot = l;
+   l->data()[i & (BRANCH - 1)] = std::forward<U>(value);
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_take(size_type count) {
+   size_type tail_offset = _tail_offset();
+   if (count >= tail_offset) {
+      if (count == tail_offset) {
+         _release(tail_, 0);
+         tail_ = nullptr;
+      } else if (count < count_) {
+         _own(tail_);
+         while (tail_->count > count - tail_offset) tail_->data()[--tail_->count].~T();
+      }
+      count_ = count;
+      return;
+   }
+
+   // the leaf holding the new last element becomes the tail
+   size_type trie_count = count & ~(BRANCH - 1);
+   leaf* tail = nullptr;
+   if (count != trie_count) {
+      const T* source = _array_for(trie_count);
+      tail = _new_leaf();
+      try {
+         for (; tail->count < count - trie_count; tail->count++) {
+            new (tail->data() + tail->count) T(source[tail->count]);
+         }
+      } catch (...) {
+         _release(tail, 0);
+         throw;
+      }
+   }
+   _release(tail_, 0);
+   tail_ = tail;
+   count_ = count;
+
+   if (trie_count == 0) {
+      _release(root_, shift_);
+      root_ = nullptr;
+      shift_ = BITS;
+      return;
+   }
+
+   // cut every branch on the path to the new last leaf after that path
+   size_type last = trie_count - 1;
+   _own(root_, shift_);
+   branch* parent = root_;
+   for (size_type shift = shift_; ; shift -= BITS) {
+      size_type keep = (last >> shift) & (BRANCH - 1);
+      for (size_type i = keep + 1; i < BRANCH; i++) {
+         _release(parent->children[i], shift - BITS);
+         parent->children[i] = nullptr;
+      }
+      if (shift == BITS) break;
+      branch* b = static_cast<branch*>(parent->children[keep]);
+      _own(b, shift - BITS);
+      parent->children[keep] = b;
+      parent = b;
+   }
+
+   // drop root levels left with a single child
+   while (shift_ > BITS && root_->children[1] == nullptr) {
+      branch* child = static_cast<branch*>(root_->children[0]);
+      _retain(child);
+      _release(root_, shift_);
+      root_ = child;
+      shift_ -= BITS;
+   }
+}
+
+template<typename T, typename Allocator>
+void persistent_vector<T, Allocator>::_clear() noexcept {
+   _release(root_, shift_);
+   _release(tail_, 0);
+   root_ = nullptr;
+   tail_ = nullptr;
+   shift_ = BITS;
+   count_ = 0;
+   offset_ = 0;
+}
+
+/**
+ * transient_vector
+ */
+
+template<typename T, typename Allocator>
+transient_vector<T, Allocator>::transient_vector(persistent_vector<T, Allocator> base) noexcept :
+   vec_{ std::move(base) }
+{ }
+
+template<typename T, typename Allocator>
+typename transient_vector<T, Allocator>::const_reference transient_vector<T, Allocator>::at(size_type index) const {
+   return vec_.at(index);
+}
+
+template<typename T, typename Allocator>
+typename transient_vector<T, Allocator>::const_reference transient_vector<T, Allocator>::operator[](size_type index) const noexcept {
+   return vec_[index];
+}
+
+template<typename T, typename Allocator>
+typename transient_vector<T, Allocator>::size_type transient_vector<T, Allocator>::size() const noexcept {
+   return vec_.size();
+}
+
+template<typename T, typename Allocator>
+bool transient_vector<T, Allocator>::empty() const noexcept {
+   return vec_.empty();
+}
+
+template<typename T, typename Allocator>
+void transient_vector<T, Allocator>::push_back(const T& value) {
+   vec_._push_back(value);
+}
+
+template<typename T, typename Allocator>
+void transient_vector<T, Allocator>::push_back(T&& value) {
+   vec_._push_back(std::move(value));
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+void transient_vector<T, Allocator>::emplace_back(Args&&... args) {
+   vec_._push_back(std::forward<Args>(args)...);
+}
+
+template<typename T, typename Allocator>
+void transient_vector<T, Allocator>::set(size_type index, const T& value) {
+   vec_._set(index, value);
+}
+
+template<typename T, typename Allocator>
+void transient_vector<T, Allocator>::set(size_type index, T&& value) {
+   vec_._set(index, std::move(value));
+}
+
+template<typename T, typename Allocator>
+void transient_vector<T, Allocator>::pop_back() {
+   if (vec_.empty()) {
+      throw std::out_of_range("transient_vector::pop_back empty vector");
+   }
+   vec_._take(vec_.count_ - 1);
+}
+
+template<typename T, typename Allocator>
+persistent_vector<T, Allocator> transient_vector<T, Allocator>::persistent() const noexcept {
+   return vec_;
+}
+
+} // namespace dsacpp
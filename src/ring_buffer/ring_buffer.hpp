@@ -0,0 +1,362 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../vector/vector.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * How many threads may push into a ring_buffer at once. There is always
+ * a single consumer.
+ */
+enum class ring_producers { single, multi };
+
+/**
+ * Bounded lock-free queue over a power-of-two ring of slots. The slots are
+ * raw, uninitialized storage obtained from the allocator the same way
+ * vector obtains its buffer; an element lives in its slot only between
+ * the push that constructs it and the pop that moves it out.
+ *
+ * Head and tail are free-running counters reduced modulo the capacity, each
+ * on its own cache line next to the owning side's cached copy of the other
+ * counter, so producer and consumer only touch each other's line when the
+ * cached view says the ring is full or empty.
+ *
+ *    - single: one producer thread; a push is a plain store of the tail
+ *    - multi:  producers claim slots with a CAS on the tail and publish
+ *              each one through a per-slot turn counter the consumer polls
+ *
+ * try_push* and try_pop* never block: they return false (or a short count)
+ * on a full or empty ring. In the multi variant an element is constructed
+ * before its slot is claimed, so T must be nothrow move constructible.
+ */
+template<
+   typename T,
+   ring_producers Producers = ring_producers::single,
+   typename Allocator = allocator<T>
+>
+class ring_buffer {
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using value_type              = T;
+   using size_type               = std::size_t;
+   using reference               = T&;
+   using const_reference         = const T&;
+   using pointer                 = T*;
+   using allocator_type          = Allocator;
+
+   static constexpr bool MULTI_PRODUCER = Producers == ring_producers::multi;
+
+   static_assert(!MULTI_PRODUCER || std::is_nothrow_move_constructible<T>::value,
+                 "multi-producer ring_buffer needs a nothrow move constructible T");
+
+   /**
+    * Constructors
+    */
+
+   // capacity is rounded up to a power of two
+   explicit ring_buffer(size_type capacity, const allocator_type& alloc = Allocator());
+
+   ring_buffer(const ring_buffer&) = delete;
+   ring_buffer& operator=(const ring_buffer&) = delete;
+
+   ~ring_buffer();
+
+   /**
+    * Producer side
+    */
+
+   bool try_push(const T& value);
+   bool try_push(T&& value);
+
+   template<typename... Args>
+   bool try_emplace(Args&&... args);
+
+   // push up to count elements copied from first; returns how many went in
+   template<typename InputIt>
+   size_type try_push_n(InputIt first, size_type count);
+
+   /**
+    * Consumer side
+    */
+
+   bool try_pop(T& out);
+
+   // move up to count elements into out; returns how many came out
+   template<typename OutputIt>
+   size_type try_pop_n(OutputIt out, size_type count);
+
+   /**
+    * Capacity, exact only while no push or pop is in flight
+    */
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+   size_type capacity() const noexcept;
+   allocator_type get_allocator() const noexcept;
+
+private:
+
+   using alloc_traits = std::allocator_traits<Allocator>;
+   using turn_type = std::atomic<size_type>;
+
+   [[no_unique_address]] allocator_type alloc_;
+   size_type mask_;
+   pointer data_;
+
+   // multi only: turns_[i] is pos + 1 once the element for pos is in slot i
+   std::unique_ptr<turn_type[]> turns_;
+
+   // producer line: the tail and the producers' view of the head
+   alignas(CACHE_LINE_SIZE) std::atomic<size_type> tail_;
+   size_type head_cache_;
+
+   // consumer line: the head and the consumer's view of the tail
+   alignas(CACHE_LINE_SIZE) std::atomic<size_type> head_;
+   size_type tail_cache_;
+
+   static size_type _round_up(size_type capacity) noexcept;
+
+   pointer _slot(size_type pos) const noexcept;
+
+   // claim up to count slots for the caller; returns the first position
+   size_type _claim(size_type& count) noexcept;
+
+   // make [pos, pos + count) visible to the consumer
+   void _publish(size_type pos, size_type count) noexcept;
+
+   // number of elements from head on the consumer may take, at most count
+   size_type _ready(size_type head, size_type count) noexcept;
+};
+
+template<typename T, typename Allocator = allocator<T>>
+using spsc_ring_buffer = ring_buffer<T, ring_producers::single, Allocator>;
+
+template<typename T, typename Allocator = allocator<T>>
+using mpsc_ring_buffer = ring_buffer<T, ring_producers::multi, Allocator>;
+
+template<typename T, ring_producers Producers, typename Allocator>
+ring_buffer<T, Producers, Allocator>::ring_buffer(size_type capacity, const allocator_type& alloc) :
+   alloc_{ alloc },
+   mask_{ _round_up(capacity) - 1 },
+   data_{ alloc_traits::allocate(alloc_, mask_ + 1) },
+   tail_{ 0 },
+   head_cache_{ 0 },
+   head_{ 0 },
+   tail_cache_{ 0 }
+{
+   if constexpr (MULTI_PRODUCER) {
+      try {
+         turns_.reset(new turn_type[mask_ + 1]);
+      } catch (...) {
+         alloc_traits::deallocate(alloc_, data_, mask_ + 1);
+         throw;
+      }
+      for (size_type i = 0; i <= mask_; i++) {
+         turns_[i].store(0, std::memory_order_relaxed);
+      }
+   }
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+ring_buffer<T, Producers, Allocator>::~ring_buffer() {
+   size_type head = head_.load(std::memory_order_relaxed);
+   size_type tail = tail_.load(std::memory_order_relaxed);
+   for (; head != tail; head++) {
+      _slot(head)->~T();
+   }
+   alloc_traits::deallocate(alloc_, data_, mask_ + 1);
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+bool ring_buffer<T, Producers, Allocator>::try_push(const T& value) {
+   return try_emplace(value);
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+bool ring_buffer<T, Producers, Allocator>::try_push(T&& value) {
+   return try_emplace(std::move(value));
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+template<typename... Args>
+bool ring_buffer<T, Producers, Allocator>::try_emplace(Args&&... args) {
+   if constexpr (MULTI_PRODUCER && !std::is_nothrow_constructible<T, Args&&...>::value) {
+      // a throw after claiming would leave a hole the consumer waits on forever
+      T value(std::forward<Args>(args)...);
+      return try_emplace(std::move(value));
+   } else {
+      size_type count = 1;
+      size_type pos = _claim(count);
+      if (count == 0) return false;
+      new (_slot(pos)) T(std::forward<Args>(args)...);
+      _publish(pos, 1);
+      return true;
+   }
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+template<typename InputIt>
+typename ring_buffer<T, Producers, Allocator>::size_type
+ring_buffer<T, Producers, Allocator>::try_push_n(InputIt first, size_type count) {
+   using source = typename std::iterator_traits<InputIt>::reference;
+   if constexpr (MULTI_PRODUCER && !std::is_nothrow_constructible<T, source>::value) {
+      size_type pushed = 0;
+      for (; pushed < count && try_push(*first); pushed++) ++first;
+      return pushed;
+   } else {
+      size_type pos = _claim(count);
+      size_type i = 0;
+      try {
+         for (; i < count; i++, ++first) {
+            new (_slot(pos + i)) T(*first);
+         }
+      } catch (...) {
+         // only reachable with one producer, where the tail is ours to set
+         _publish(pos, i);
+         throw;
+      }
+      _publish(pos, count);
+      return count;
+   }
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+bool ring_buffer<T, Producers, Allocator>::try_pop(T& out) {
+   return try_pop_n(&out, 1) == 1;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+template<typename OutputIt>
+typename ring_buffer<T, Producers, Allocator>::size_type
+ring_buffer<T, Producers, Allocator>::try_pop_n(OutputIt out, size_type count) {
+   size_type head = head_.load(std::memory_order_relaxed);
+   count = _ready(head, count);
+   size_type i = 0;
+   try {
+      for (; i < count; i++, ++out) {
+         pointer p = _slot(head + i);
+         *out = std::move(*p);
+         p->~T();
+      }
+   } catch (...) {
+      // the element that failed to move out stays queued
+      head_.store(head + i, std::memory_order_release);
+      throw;
+   }
+   head_.store(head + count, std::memory_order_release);
+   return count;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::size_type ring_buffer<T, Producers, Allocator>::size() const noexcept {
+   size_type head = head_.load(std::memory_order_acquire);
+   size_type tail = tail_.load(std::memory_order_acquire);
+   size_type n = tail - head;
+   // the head may have moved past the tail we read in between
+   return n > mask_ + 1 ? 0 : n;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+bool ring_buffer<T, Producers, Allocator>::empty() const noexcept {
+   return size() == 0;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::size_type ring_buffer<T, Producers, Allocator>::capacity() const noexcept {
+   return mask_ + 1;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::allocator_type
+ring_buffer<T, Producers, Allocator>::get_allocator() const noexcept {
+   return alloc_;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::size_type
+ring_buffer<T, Producers, Allocator>::_round_up(size_type capacity) noexcept {
+   size_type n = 1;
+   while (n < capacity) n <<= 1;
+   return n;
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::pointer
+ring_buffer<T, Producers, Allocator>::_slot(size_type pos) const noexcept {
+   return data_ + (pos & mask_);
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::size_type
+ring_buffer<T, Producers, Allocator>::_claim(size_type& count) noexcept {
+   size_type capacity = mask_ + 1;
+   if constexpr (MULTI_PRODUCER) {
+      size_type pos = tail_.load(std::memory_order_relaxed);
+      for (;;) {
+         // the consumer stores the head only after moving the slots out
+         size_type free = capacity - (pos - head_.load(std::memory_order_acquire));
+         size_type n = count < free ? count : free;
+         if (n == 0) {
+            count = 0;
+            return pos;
+         }
+         if (tail_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            count = n;
+            return pos;
+         }
+      }
+   } else {
+      size_type pos = tail_.load(std::memory_order_relaxed);
+      if (capacity - (pos - head_cache_) < count) {
+         head_cache_ = head_.load(std::memory_order_acquire);
+      }
+      size_type free = capacity - (pos - head_cache_);
+      if (free < count) count = free;
+      return pos;
+   }
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+void ring_buffer<T, Producers, Allocator>::_publish(size_type pos, size_type count) noexcept {
+   if constexpr (MULTI_PRODUCER) {
+      for (size_type i = 0; i < count; i++) {
+         turns_[(pos + i) & mask_].store(pos + i + 1, std::memory_order_release);
+      }
+   } else {
+      tail_.store(pos + count, std::memory_order_release);
+   }
+}
+
+template<typename T, ring_producers Producers, typename Allocator>
+typename ring_buffer<T, Producers, Allocator>::size_type
+ring_buffer<T, Producers, Allocator>::_ready(size_type head, size_type count) noexcept {
+   if constexpr (MULTI_PRODUCER) {
+      // producers may publish out of order; stop at the first gap
+      size_type n = 0;
+      while (n < count && turns_[(head + n) & mask_].load(std::memory_order_acquire) == head + n + 1) {
+         n++;
+      }
+      return n;
+   } else {
+      if (tail_cache_ - head < count) {
+         tail_cache_ = tail_.load(std::memory_order_acquire);
+      }
+      size_type available = tail_cache_ - head;
+      return available < count ? available : count;
+   }
+}
+
+} // namespace dsacpp
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dsacpp
+{
+
+/**
+ * Fixed-size work-stealing thread pool. Each worker owns a deque: it pushes
+ * and pops its own tasks at the back (newest first, which keeps recursive
+ * splits cache-warm) and, when that runs dry, steals the oldest task from
+ * the front of another worker's deque. Tasks submitted from outside the
+ * pool are dealt round-robin across the workers.
+ *
+ * Threads blocked in task_group::wait() run pending tasks instead of
+ * sleeping, so fork-join code may nest to any depth without deadlocking.
+ */
+class thread_pool {
+public:
+
+   /**
+    * Constructors
+    */
+
+   explicit thread_pool(std::size_t threads = default_threads());
+
+   thread_pool(const thread_pool&) = delete;
+   thread_pool& operator=(const thread_pool&) = delete;
+
+   ~thread_pool();
+
+   /**
+    * Tasks
+    */
+
+   // task must not throw; use task_group to carry exceptions back
+   template<typename F>
+   void submit(F&& task);
+
+   // run one pending task on the calling thread; false if none was found
+   bool run_pending();
+
+   /**
+    * Getters
+    */
+
+   std::size_t size() const noexcept;
+
+   // process-wide pool with default_threads() workers, created on first use
+   static thread_pool& shared();
+
+   static std::size_t default_threads() noexcept;
+
+private:
+
+   using task = std::function<void()>;
+
+   // padded so neighbouring workers do not share a line through their locks
+   struct alignas(64) Queue {
+      std::mutex lock;
+      std::deque<task> tasks;
+   };
+
+   struct Local {
+      thread_pool* pool = nullptr;
+      std::size_t index = 0;
+   };
+
+   // fixed before any worker starts; workers_ is still filling up then
+   std::size_t size_;
+   std::unique_ptr<Queue[]> queues_;
+   std::vector<std::thread> workers_;
+   std::atomic<std::size_t> pending_;
+   std::atomic<std::size_t> next_queue_;
+   std::atomic<bool> stop_;
+   std::mutex sleep_lock_;
+   std::condition_variable wake_;
+
+   static Local& _local() noexcept;
+
+   void _worker(std::size_t index);
+   bool _pop(std::size_t index, task& out);
+   bool _steal(std::size_t start, task& out);
+};
+
+/**
+ * Fork-join scope over a thread_pool. run() forks a task, wait() joins all
+ * of them, helping with pending work meanwhile, and rethrows the first
+ * exception any task threw. The destructor waits but swallows errors.
+ */
+class task_group {
+public:
+
+   explicit task_group(thread_pool& pool) noexcept;
+
+   task_group(const task_group&) = delete;
+   task_group& operator=(const task_group&) = delete;
+
+   ~task_group();
+
+   template<typename F>
+   void run(F&& task);
+
+   void wait();
+
+private:
+
+   thread_pool& pool_;
+   std::atomic<std::size_t> pending_;
+   std::mutex error_lock_;
+   std::exception_ptr error_;
+
+   void _join() noexcept;
+};
+
+inline thread_pool::thread_pool(std::size_t threads) :
+   size_{ threads ? threads : 1 },
+   queues_{ new Queue[size_] },
+   pending_{ 0 },
+   next_queue_{ 0 },
+   stop_{ false }
+{
+   workers_.reserve(size_);
+   try {
+      for (std::size_t i = 0; i < size_; i++) {
+         workers_.emplace_back(&thread_pool::_worker, this, i);
+      }
+   } catch (...) {
+      stop_.store(true);
+      wake_.notify_all();
+      for (std::thread& worker : workers_) worker.join();
+      throw;
+   }
+}
+
+inline thread_pool::~thread_pool() {
+   {
+      std::lock_guard<std::mutex> guard(sleep_lock_);
+      stop_.store(true);
+   }
+   wake_.notify_all();
+   for (std::thread& worker : workers_) {
+      worker.join();
+   }
+}
+
+template<typename F>
+void thread_pool::submit(F&& f) {
+   Local& local = _local();
+   std::size_t index = local.pool == this
+      ? local.index
+      : next_queue_.fetch_add(1, std::memory_order_relaxed) % size_;
+   {
+      std::lock_guard<std::mutex> guard(queues_[index].lock);
+      queues_[index].tasks.emplace_back(std::forward<F>(f));
+   }
+   pending_.fetch_add(1, std::memory_order_release);
+   // taking the lock orders this wakeup after a sleeper's predicate check
+   { std::lock_guard<std::mutex> guard(sleep_lock_); }
+   wake_.notify_one();
+}
+
+inline bool thread_pool::run_pending() {
+   Local& local = _local();
+   task t;
+   bool found = local.pool == this
+      ? _pop(local.index, t) || _steal(local.index + 1, t)
+      : _steal(next_queue_.load(std::memory_order_relaxed), t);
+   if (!found) return false;
+   t();
+   return true;
+}
+
+inline std::size_t thread_pool::size() const noexcept {
+   return size_;
+}
+
+inline thread_pool& thread_pool::shared() {
+   static thread_pool pool;
+   return pool;
+}
+
+inline std::size_t thread_pool::default_threads() noexcept {
+   unsigned hw = std::thread::hardware_concurrency();
+   return hw ? hw : 1;
+}
+
+inline thread_pool::Local& thread_pool::_local() noexcept {
+   thread_local Local local;
+   return local;
+}
+
+inline void thread_pool::_worker(std::size_t index) {
+   _local() = Local{ this, index };
+   task t;
+   for (;;) {
+      if (_pop(index, t) || _steal(index + 1, t)) {
+         t();
+         t = nullptr;
+         continue;
+      }
+      std::unique_lock<std::mutex> guard(sleep_lock_);
+      wake_.wait(guard, [this] {
+         return stop_.load() || pending_.load(std::memory_order_acquire) != 0;
+      });
+      if (stop_.load() && pending_.load(std::memory_order_acquire) == 0) return;
+   }
+}
+
+inline bool thread_pool::_pop(std::size_t index, task& out) {
+   Queue& q = queues_[index];
+   std::lock_guard<std::mutex> guard(q.lock);
+   if (q.tasks.empty()) return false;
+   out = std::move(q.tasks.back());
+   q.tasks.pop_back();
+   pending_.fetch_sub(1, std::memory_order_relaxed);
+   return true;
+}
+
+inline bool thread_pool::_steal(std::size_t start, task& out) {
+   std::size_t n = size_;
+   for (std::size_t i = 0; i < n; i++) {
+      Queue& q = queues_[(start + i) % n];
+      std::unique_lock<std::mutex> guard(q.lock, std::try_to_lock);
+      if (!guard.owns_lock() || q.tasks.empty()) continue;
+      out = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+   }
+   return false;
+}
+
+inline task_group::task_group(thread_pool& pool) noexcept :
+   pool_{ pool },
+   pending_{ 0 }
+{ }
+
+inline task_group::~task_group() {
+   _join();
+}
+
+template<typename F>
+void task_group::run(F&& f) {
+   pending_.fetch_add(1, std::memory_order_relaxed);
+   try {
+      pool_.submit([this, f = std::forward<F>(f)]() mutable {
+         try {
+            f();
+         } catch (...) {
+            std::lock_guard<std::mutex> guard(error_lock_);
+            if (!error_) error_ = std::current_exception();
+         }
+         pending_.fetch_sub(1, std::memory_order_release);
+      });
+   } catch (...) {
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      throw;
+   }
+}
+
+inline void task_group::wait() {
+   _join();
+   std::exception_ptr error;
+   {
+      std::lock_guard<std::mutex> guard(error_lock_);
+      std::swap(error, error_);
+   }
+   if (error) std::rethrow_exception(error);
+}
+
+inline void task_group::_join() noexcept {
+   while (pending_.load(std::memory_order_acquire) != 0) {
+      if (!pool_.run_pending()) std::this_thread::yield();
+   }
+}
+
+} // namespace dsacpp
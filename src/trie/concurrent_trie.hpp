@@ -0,0 +1,1129 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "epoch_domain.hpp"
+#include "detail/key_bytes.hpp"
+#include "trie.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Ordered map (or set, with Data = void) from token strings for many
+ * concurrent readers and writers, laid out as a path-compressed adaptive
+ * radix tree like trie, with keys walked as the same big-endian bytes.
+ *
+ * Synchronization is optimistic lock coupling. Every node carries a
+ * version word whose low bits mark it locked or obsolete:
+ *    - readers (find, contains, lower_bound, for_each_prefix) take no
+ *      locks: they note a node's version, read what they need and check
+ *      the version again before trusting it, starting over from the root
+ *      when a writer got in between
+ *    - writers walk down the same way and lock only the nodes they change,
+ *      the node itself for an in-place change and its parent too when the
+ *      node is replaced
+ * A node's label never changes once the node is published: splitting a
+ * label or growing a full node builds a replacement, swaps it into the
+ * parent and marks the old node obsolete. Data is never changed in place
+ * either; insert_or_assign swaps in a new leaf. Replaced nodes and leaves
+ * are retired to an epoch_domain and freed once no reader can still hold
+ * them, so a reader may always finish reading a node it has reached.
+ *
+ * Erase drops the node of the erased key when it has no children and
+ * otherwise just its data; it never merges labels or shrinks nodes, so
+ * keys erased under a shared prefix leave their branch nodes behind for
+ * later inserts to reuse.
+ *
+ * Scans are weakly consistent: they visit every key present for the whole
+ * scan, in key order and each once, and may or may not see keys inserted
+ * or erased meanwhile. A long scan holds back reclamation while it runs.
+ * The destructor must not run alongside any other operation.
+ */
+template<
+   typename Token,
+   typename Data        = void,
+   typename Traits      = std::char_traits<Token>,
+   typename Allocator   = std::allocator<Data>
+>
+class concurrent_trie {
+public:
+
+   /**
+    * Type Declarations
+    */
+
+   using token_type        = Token;
+   using key_type          = std::basic_string<Token, Traits>;
+   using data_type         = Data;
+   using mapped_type       = std::conditional_t<std::is_void<Data>::value, trie_no_data, Data>;
+   using traits_type       = Traits;
+   using allocator_type    = Allocator;
+   using size_type         = size_t;
+   using difference_type   = std::ptrdiff_t;
+
+   static_assert(std::is_integral<Token>::value, "trie tokens must be integral");
+
+   /*
+    * Constructors
+   */
+
+   explicit concurrent_trie(const allocator_type& alloc = Allocator());
+
+   concurrent_trie(const concurrent_trie&) = delete;
+   concurrent_trie& operator=(const concurrent_trie&) = delete;
+
+   ~concurrent_trie() noexcept;
+
+   /**
+    * Modifiers
+    */
+
+   // leaves an existing key's data untouched; true if the key was inserted
+   bool insert(const key_type& key, const mapped_type& data = mapped_type());
+
+   // overwrites an existing key's data; true if the key was inserted
+   bool insert_or_assign(const key_type& key, const mapped_type& data);
+
+   // true if the key was there
+   bool erase(const key_type& key);
+
+   /**
+    * Lookup
+    */
+
+   bool contains(const key_type& key) const;
+
+   // a copy of key's data, as of some moment during the call
+   std::optional<mapped_type> find(const key_type& key) const;
+
+   // the first key not less than key, with a copy of its data
+   std::optional<std::pair<key_type, mapped_type>> lower_bound(const key_type& key) const;
+
+   // f(key) for a set, f(key, data) for a map, over the keys starting with
+   // prefix in key order, until f returns false; true if it saw them all
+   template<typename F>
+   bool for_each_prefix(const key_type& prefix, F f) const;
+
+   /**
+    * Getters
+    */
+
+   // exact when no writer is running
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+private:
+
+   enum node_kind : std::uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+   // low bits of a node's version word; unlocking adds LOCKED again,
+   // carrying into the counter above
+   static constexpr std::uint64_t OBSOLETE = 1;
+   static constexpr std::uint64_t LOCKED = 2;
+
+   struct Leaf {
+      mapped_type data;
+   };
+
+   // header shared by every node; what readers may see change is atomic
+   struct Node {
+      std::atomic<std::uint64_t> version{ 0 };
+      const node_kind kind;
+      std::atomic<std::uint16_t> count{ 0 };
+      // label of the edge into this node, fixed for the node's life
+      std::uint32_t prefix_len = 0;
+      std::uint8_t* prefix = nullptr;
+      // data of the key that ends at this node, if any
+      std::atomic<Leaf*> value{ nullptr };
+
+      explicit Node(node_kind k) noexcept : kind{ k } { }
+   };
+
+   struct Node4 : Node {
+      std::atomic<std::uint8_t> keys[4]{};
+      std::atomic<Node*> children[4]{};
+
+      Node4() noexcept : Node(NODE4) { }
+   };
+
+   struct Node16 : Node {
+      std::atomic<std::uint8_t> keys[16]{};
+      std::atomic<Node*> children[16]{};
+
+      Node16() noexcept : Node(NODE16) { }
+   };
+
+   struct Node48 : Node {
+      // slot + 1 of each byte's child, 0 for none
+      std::atomic<std::uint8_t> index[256]{};
+      std::atomic<Node*> children[48]{};
+
+      Node48() noexcept : Node(NODE48) { }
+   };
+
+   struct Node256 : Node {
+      std::atomic<Node*> children[256]{};
+
+      Node256() noexcept : Node(NODE256) { }
+   };
+
+   // a child as read off its parent
+   struct Entry {
+      std::uint8_t byte;
+      Node* child;
+   };
+
+   // what one optimistic attempt at an operation came to
+   enum attempt : std::uint8_t { RESTART, DONE, FAILED };
+
+   using alloc_traits = std::allocator_traits<allocator_type>;
+
+   [[no_unique_address]] allocator_type alloc_;
+   // a Node256 with an empty label, so it is never replaced
+   Node* root_ = nullptr;
+   std::atomic<size_type> size_{ 0 };
+   // destroyed first, reclaiming through alloc_
+   mutable epoch_domain domain_;
+
+   /**
+    * Version locks
+    */
+
+   // node's version once no writer holds it; false if it is obsolete
+   static bool _read_lock(const Node* node, std::uint64_t& version) noexcept;
+
+   // whether node is still at version, i.e. what was read of it holds
+   static bool _validate(const Node* node, std::uint64_t version) noexcept;
+
+   // lock node if it is still at version
+   static bool _upgrade(Node* node, std::uint64_t version) noexcept;
+
+   static void _unlock(Node* node) noexcept;
+   static void _unlock_obsolete(Node* node) noexcept;
+
+   /**
+    * Node management
+    */
+
+   template<typename N>
+   N* _create_node(size_type prefix_len);
+
+   // a node of kind with an uninitialized label of prefix_len bytes
+   Node* _create(node_kind kind, size_type prefix_len);
+
+   template<typename N>
+   void _free_node(N* node) noexcept;
+
+   // frees the node and its label, not its children or data
+   void _destroy_node(Node* node) noexcept;
+
+   // frees node's whole subtree and data
+   void _destroy_tree(Node* node) noexcept;
+
+   Leaf* _create_leaf(const mapped_type& data);
+   void _destroy_leaf(Leaf* leaf) noexcept;
+
+   // node labelled with key's bytes from position from on, holding leaf
+   Node* _create_tail(const key_type& key, size_type from, Leaf* leaf);
+
+   // how many bytes of node's label match key from position from on
+   static size_type _match_prefix(const Node* node, const key_type& key, size_type from) noexcept;
+
+   static std::uint16_t _capacity(const Node* node) noexcept;
+
+   // the child under byte, or null
+   static Node* _find_child(const Node* node, std::uint8_t byte) noexcept;
+
+   // append node's children to entries in byte order
+   static void _snapshot(const Node* node, std::vector<Entry>& entries);
+
+   // the following need node locked or unpublished
+
+   // add a child under a byte node does not have yet; node must have room
+   static void _add_child(Node* node, std::uint8_t byte, Node* child) noexcept;
+
+   template<typename N>
+   static void _insert_sorted(N* node, std::uint8_t byte, Node* child) noexcept;
+
+   static void _remove_child(Node* node, std::uint8_t byte) noexcept;
+
+   template<typename N>
+   static void _erase_sorted(N* node, std::uint8_t byte) noexcept;
+
+   static void _replace_child(Node* node, std::uint8_t byte, Node* child) noexcept;
+
+   // node's replacement with kind's layout, a label of prefix_len bytes
+   // from node's label at offset on, and node's data and children
+   Node* _copy(const Node* node, node_kind kind, size_type offset, size_type prefix_len);
+
+   // replacement for node, whose label key leaves after matched bytes, with
+   // leaf added; key continues, or ends, at byte from
+   Node* _split(const Node* node, size_type matched, const key_type& key, size_type from, Leaf* leaf);
+
+   // replacement for the full node with room for child under byte, and child added
+   Node* _grow(const Node* node, std::uint8_t byte, Node* child);
+
+   /**
+    * Reclamation
+    */
+
+   static void _reclaim_node(void* context, void* object);
+   static void _reclaim_leaf(void* context, void* object);
+
+   void _retire_node(epoch_domain::guard& guard, Node* node) noexcept;
+   void _retire_leaf(epoch_domain::guard& guard, Leaf* leaf) noexcept;
+
+   /**
+    * Operations, one optimistic attempt each
+    */
+
+   // leaf for key, or null; valid while guard is open
+   attempt _lookup(const key_type& key, Leaf*& leaf) const;
+
+   // DONE if key was inserted, FAILED if it was there (and assign did not
+   // replace its data)
+   attempt _insert(epoch_domain::guard& guard, const key_type& key, const mapped_type& data, bool assign);
+
+   // FAILED if key was not there
+   attempt _erase(epoch_domain::guard& guard, const key_type& key);
+
+   // f(bytes, leaf) over the keys from bound on (past it unless inclusive)
+   // in key order until f returns false; true if it saw them all
+   template<typename F>
+   bool _scan(std::vector<std::uint8_t> bound, bool inclusive, F f) const;
+
+   // _scan below node, whose key bytes so far are path; above when every
+   // key below node comes after bound. bound moves on as keys are seen, so
+   // a restart resumes past them. entries is scratch shared down the walk
+   template<typename F>
+   attempt _scan_node(const Node* node, std::vector<std::uint8_t>& path,
+                      std::vector<std::uint8_t>& bound, bool& inclusive, bool above,
+                      std::vector<Entry>& entries, F& f) const;
+};
+
+/*
+ * Constructors
+*/
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+concurrent_trie<Token, Data, Traits, Allocator>::concurrent_trie(const allocator_type& alloc) :
+   alloc_{ alloc }
+{
+   root_ = _create(NODE256, 0);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+concurrent_trie<Token, Data, Traits, Allocator>::~concurrent_trie() noexcept {
+   _destroy_tree(root_);
+}
+
+/**
+ * Modifiers
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::insert(const key_type& key, const mapped_type& data) {
+   for (;;) {
+      epoch_domain::guard guard(domain_);
+      attempt result = _insert(guard, key, data, false);
+      if (result != RESTART) return result == DONE;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::insert_or_assign(const key_type& key, const mapped_type& data) {
+   for (;;) {
+      epoch_domain::guard guard(domain_);
+      attempt result = _insert(guard, key, data, true);
+      if (result != RESTART) return result == DONE;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::erase(const key_type& key) {
+   for (;;) {
+      epoch_domain::guard guard(domain_);
+      attempt result = _erase(guard, key);
+      if (result != RESTART) return result == DONE;
+   }
+}
+
+/**
+ * Lookup
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::contains(const key_type& key) const {
+   epoch_domain::guard guard(domain_);
+   Leaf* leaf;
+   while (_lookup(key, leaf) == RESTART) { }
+   return leaf != nullptr;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::optional<typename concurrent_trie<Token, Data, Traits, Allocator>::mapped_type>
+concurrent_trie<Token, Data, Traits, Allocator>::find(const key_type& key) const {
+   epoch_domain::guard guard(domain_);
+   Leaf* leaf;
+   while (_lookup(key, leaf) == RESTART) { }
+   if (!leaf) return std::nullopt;
+   return leaf->data;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::optional<std::pair<typename concurrent_trie<Token, Data, Traits, Allocator>::key_type,
+                        typename concurrent_trie<Token, Data, Traits, Allocator>::mapped_type>>
+concurrent_trie<Token, Data, Traits, Allocator>::lower_bound(const key_type& key) const {
+   std::vector<std::uint8_t> bound;
+   detail::key_to_bytes(key, bound);
+   std::optional<std::pair<key_type, mapped_type>> found;
+   _scan(std::move(bound), true, [&found](const std::vector<std::uint8_t>& bytes, const Leaf* leaf) {
+      key_type first;
+      detail::bytes_to_key(bytes, first);
+      found.emplace(std::move(first), leaf->data);
+      return false;
+   });
+   return found;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename F>
+bool concurrent_trie<Token, Data, Traits, Allocator>::for_each_prefix(const key_type& prefix, F f) const {
+   std::vector<std::uint8_t> bound;
+   detail::key_to_bytes(prefix, bound);
+   size_type n = bound.size();
+   // the scan runs on to the first key past the prefix and stops there
+   bool past = false;
+   key_type key;
+   bool all = _scan(bound, true, [&](const std::vector<std::uint8_t>& bytes, const Leaf* leaf) {
+      if (bytes.size() < n || !std::equal(bound.begin(), bound.end(), bytes.begin())) {
+         past = true;
+         return false;
+      }
+      detail::bytes_to_key(bytes, key);
+      if constexpr (std::is_void<Data>::value) {
+         (void)leaf;
+         return static_cast<bool>(f(static_cast<const key_type&>(key)));
+      } else {
+         return static_cast<bool>(f(static_cast<const key_type&>(key), leaf->data));
+      }
+   });
+   return all || past;
+}
+
+/**
+ * Getters
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::size_type concurrent_trie<Token, Data, Traits, Allocator>::size() const noexcept {
+   return size_.load(std::memory_order_relaxed);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::empty() const noexcept {
+   return size() == 0;
+}
+
+/**
+ * Version locks
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::_read_lock(const Node* node, std::uint64_t& version) noexcept {
+   std::uint64_t v;
+   while ((v = node->version.load(std::memory_order_acquire)) & LOCKED) {
+      std::this_thread::yield();
+   }
+   version = v;
+   return !(v & OBSOLETE);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::_validate(const Node* node, std::uint64_t version) noexcept {
+   // keeps the reads being validated before the version check; pairs with
+   // the fence in _upgrade
+   std::atomic_thread_fence(std::memory_order_acquire);
+   return node->version.load(std::memory_order_relaxed) == version;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool concurrent_trie<Token, Data, Traits, Allocator>::_upgrade(Node* node, std::uint64_t version) noexcept {
+   if (!node->version.compare_exchange_strong(version, version + LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+      return false;
+   }
+   // a reader that sees any write made under the lock also sees the lock
+   std::atomic_thread_fence(std::memory_order_release);
+   return true;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_unlock(Node* node) noexcept {
+   node->version.fetch_add(LOCKED, std::memory_order_release);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_unlock_obsolete(Node* node) noexcept {
+   node->version.fetch_add(LOCKED | OBSOLETE, std::memory_order_release);
+}
+
+/**
+ * Node management
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename N>
+N* concurrent_trie<Token, Data, Traits, Allocator>::_create_node(size_type prefix_len) {
+   using node_allocator = typename alloc_traits::template rebind_alloc<N>;
+   node_allocator alloc(alloc_);
+   N* node = std::allocator_traits<node_allocator>::allocate(alloc, 1);
+   new (node) N();
+   if (prefix_len) {
+      using byte_allocator = typename alloc_traits::template rebind_alloc<std::uint8_t>;
+      byte_allocator bytes(alloc_);
+      try {
+         node->prefix = std::allocator_traits<byte_allocator>::allocate(bytes, prefix_len);
+      } catch (...) {
+         node->~N();
+         std::allocator_traits<node_allocator>::deallocate(alloc, node, 1);
+         throw;
+      }
+      node->prefix_len = static_cast<std::uint32_t>(prefix_len);
+   }
+   return node;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Node* concurrent_trie<Token, Data, Traits, Allocator>::_create(node_kind kind, size_type prefix_len) {
+   switch (kind) {
+      case NODE4:   return _create_node<Node4>(prefix_len);
+      case NODE16:  return _create_node<Node16>(prefix_len);
+      case NODE48:  return _create_node<Node48>(prefix_len);
+      default:      return _create_node<Node256>(prefix_len);
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename N>
+void concurrent_trie<Token, Data, Traits, Allocator>::_free_node(N* node) noexcept {
+   if (node->prefix) {
+      using byte_allocator = typename alloc_traits::template rebind_alloc<std::uint8_t>;
+      byte_allocator bytes(alloc_);
+      std::allocator_traits<byte_allocator>::deallocate(bytes, node->prefix, node->prefix_len);
+   }
+   using node_allocator = typename alloc_traits::template rebind_alloc<N>;
+   node_allocator alloc(alloc_);
+   node->~N();
+   std::allocator_traits<node_allocator>::deallocate(alloc, node, 1);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_destroy_node(Node* node) noexcept {
+   switch (node->kind) {
+      case NODE4:   _free_node(static_cast<Node4*>(node)); break;
+      case NODE16:  _free_node(static_cast<Node16*>(node)); break;
+      case NODE48:  _free_node(static_cast<Node48*>(node)); break;
+      case NODE256: _free_node(static_cast<Node256*>(node)); break;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_destroy_tree(Node* node) noexcept {
+   std::vector<Node*> stack{ node };
+   std::vector<Entry> entries;
+   while (!stack.empty()) {
+      Node* top = stack.back();
+      stack.pop_back();
+      entries.clear();
+      _snapshot(top, entries);
+      for (const Entry& entry : entries) stack.push_back(entry.child);
+      if (Leaf* leaf = top->value.load(std::memory_order_relaxed)) _destroy_leaf(leaf);
+      _destroy_node(top);
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Leaf* concurrent_trie<Token, Data, Traits, Allocator>::_create_leaf(const mapped_type& data) {
+   using leaf_allocator = typename alloc_traits::template rebind_alloc<Leaf>;
+   leaf_allocator alloc(alloc_);
+   Leaf* leaf = std::allocator_traits<leaf_allocator>::allocate(alloc, 1);
+   try {
+      new (leaf) Leaf{ data };
+   } catch (...) {
+      std::allocator_traits<leaf_allocator>::deallocate(alloc, leaf, 1);
+      throw;
+   }
+   return leaf;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_destroy_leaf(Leaf* leaf) noexcept {
+   using leaf_allocator = typename alloc_traits::template rebind_alloc<Leaf>;
+   leaf_allocator alloc(alloc_);
+   leaf->~Leaf();
+   std::allocator_traits<leaf_allocator>::deallocate(alloc, leaf, 1);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Node* concurrent_trie<Token, Data, Traits, Allocator>::_create_tail(const key_type& key, size_type from, Leaf* leaf) {
+   size_type n = detail::key_byte_count(key);
+   Node* node = _create(NODE4, n - from);
+   for (size_type i = from; i < n; i++) node->prefix[i - from] = detail::key_byte(key, i);
+   node->value.store(leaf, std::memory_order_relaxed);
+   return node;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::size_type concurrent_trie<Token, Data, Traits, Allocator>::_match_prefix(const Node* node, const key_type& key, size_type from) noexcept {
+   size_type n = std::min<size_type>(node->prefix_len, detail::key_byte_count(key) - from);
+   size_type i = 0;
+   while (i < n && node->prefix[i] == detail::key_byte(key, from + i)) i++;
+   return i;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::uint16_t concurrent_trie<Token, Data, Traits, Allocator>::_capacity(const Node* node) noexcept {
+   switch (node->kind) {
+      case NODE4:   return 4;
+      case NODE16:  return 16;
+      case NODE48:  return 48;
+      default:      return 256;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Node* concurrent_trie<Token, Data, Traits, Allocator>::_find_child(const Node* node, std::uint8_t byte) noexcept {
+   switch (node->kind) {
+      case NODE4: {
+         const Node4* n = static_cast<const Node4*>(node);
+         std::uint16_t count = std::min<std::uint16_t>(n->count.load(std::memory_order_relaxed), 4);
+         for (std::uint16_t i = 0; i < count; i++) {
+            if (n->keys[i].load(std::memory_order_relaxed) == byte) return n->children[i].load(std::memory_order_acquire);
+         }
+         return nullptr;
+      }
+      case NODE16: {
+         const Node16* n = static_cast<const Node16*>(node);
+         std::uint16_t count = std::min<std::uint16_t>(n->count.load(std::memory_order_relaxed), 16);
+         for (std::uint16_t i = 0; i < count; i++) {
+            if (n->keys[i].load(std::memory_order_relaxed) == byte) return n->children[i].load(std::memory_order_acquire);
+         }
+         return nullptr;
+      }
+      case NODE48: {
+         const Node48* n = static_cast<const Node48*>(node);
+         std::uint8_t slot = n->index[byte].load(std::memory_order_relaxed);
+         return slot ? n->children[slot - 1].load(std::memory_order_acquire) : nullptr;
+      }
+      default:
+         return static_cast<const Node256*>(node)->children[byte].load(std::memory_order_acquire);
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_snapshot(const Node* node, std::vector<Entry>& entries) {
+   auto sorted = [&entries](const auto* n, std::uint16_t capacity) {
+      std::uint16_t count = std::min<std::uint16_t>(n->count.load(std::memory_order_relaxed), capacity);
+      for (std::uint16_t i = 0; i < count; i++) {
+         Node* child = n->children[i].load(std::memory_order_acquire);
+         if (child) entries.push_back({ n->keys[i].load(std::memory_order_relaxed), child });
+      }
+   };
+   switch (node->kind) {
+      case NODE4:
+         sorted(static_cast<const Node4*>(node), 4);
+         break;
+      case NODE16:
+         sorted(static_cast<const Node16*>(node), 16);
+         break;
+      case NODE48: {
+         const Node48* n = static_cast<const Node48*>(node);
+         for (int byte = 0; byte < 256; byte++) {
+            std::uint8_t slot = n->index[byte].load(std::memory_order_relaxed);
+            if (!slot) continue;
+            Node* child = n->children[slot - 1].load(std::memory_order_acquire);
+            if (child) entries.push_back({ static_cast<std::uint8_t>(byte), child });
+         }
+         break;
+      }
+      case NODE256: {
+         const Node256* n = static_cast<const Node256*>(node);
+         for (int byte = 0; byte < 256; byte++) {
+            Node* child = n->children[byte].load(std::memory_order_acquire);
+            if (child) entries.push_back({ static_cast<std::uint8_t>(byte), child });
+         }
+         break;
+      }
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_add_child(Node* node, std::uint8_t byte, Node* child) noexcept {
+   switch (node->kind) {
+      case NODE4:
+         _insert_sorted(static_cast<Node4*>(node), byte, child);
+         break;
+      case NODE16:
+         _insert_sorted(static_cast<Node16*>(node), byte, child);
+         break;
+      case NODE48: {
+         Node48* n = static_cast<Node48*>(node);
+         std::uint8_t slot = 0;
+         while (n->children[slot].load(std::memory_order_relaxed)) slot++;
+         n->children[slot].store(child, std::memory_order_release);
+         n->index[byte].store(static_cast<std::uint8_t>(slot + 1), std::memory_order_relaxed);
+         n->count.store(n->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+         break;
+      }
+      case NODE256: {
+         Node256* n = static_cast<Node256*>(node);
+         n->children[byte].store(child, std::memory_order_release);
+         n->count.store(n->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+         break;
+      }
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename N>
+void concurrent_trie<Token, Data, Traits, Allocator>::_insert_sorted(N* node, std::uint8_t byte, Node* child) noexcept {
+   std::uint16_t count = node->count.load(std::memory_order_relaxed);
+   std::uint16_t pos = 0;
+   while (pos < count && node->keys[pos].load(std::memory_order_relaxed) < byte) pos++;
+   for (std::uint16_t i = count; i > pos; i--) {
+      node->keys[i].store(node->keys[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      node->children[i].store(node->children[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+   }
+   node->keys[pos].store(byte, std::memory_order_relaxed);
+   node->children[pos].store(child, std::memory_order_release);
+   node->count.store(count + 1, std::memory_order_relaxed);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_remove_child(Node* node, std::uint8_t byte) noexcept {
+   switch (node->kind) {
+      case NODE4:
+         _erase_sorted(static_cast<Node4*>(node), byte);
+         break;
+      case NODE16:
+         _erase_sorted(static_cast<Node16*>(node), byte);
+         break;
+      case NODE48: {
+         Node48* n = static_cast<Node48*>(node);
+         std::uint8_t slot = n->index[byte].load(std::memory_order_relaxed);
+         n->index[byte].store(0, std::memory_order_relaxed);
+         n->children[slot - 1].store(nullptr, std::memory_order_relaxed);
+         n->count.store(n->count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+         break;
+      }
+      case NODE256: {
+         Node256* n = static_cast<Node256*>(node);
+         n->children[byte].store(nullptr, std::memory_order_relaxed);
+         n->count.store(n->count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+         break;
+      }
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename N>
+void concurrent_trie<Token, Data, Traits, Allocator>::_erase_sorted(N* node, std::uint8_t byte) noexcept {
+   std::uint16_t count = node->count.load(std::memory_order_relaxed);
+   std::uint16_t pos = 0;
+   while (node->keys[pos].load(std::memory_order_relaxed) != byte) pos++;
+   for (std::uint16_t i = pos + 1; i < count; i++) {
+      node->keys[i - 1].store(node->keys[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      node->children[i - 1].store(node->children[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+   }
+   node->children[count - 1].store(nullptr, std::memory_order_relaxed);
+   node->count.store(count - 1, std::memory_order_relaxed);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_replace_child(Node* node, std::uint8_t byte, Node* child) noexcept {
+   switch (node->kind) {
+      case NODE4:
+      case NODE16: {
+         std::atomic<std::uint8_t>* keys = node->kind == NODE4 ? static_cast<Node4*>(node)->keys : static_cast<Node16*>(node)->keys;
+         std::atomic<Node*>* children = node->kind == NODE4 ? static_cast<Node4*>(node)->children : static_cast<Node16*>(node)->children;
+         std::uint16_t pos = 0;
+         while (keys[pos].load(std::memory_order_relaxed) != byte) pos++;
+         children[pos].store(child, std::memory_order_release);
+         break;
+      }
+      case NODE48: {
+         Node48* n = static_cast<Node48*>(node);
+         n->children[n->index[byte].load(std::memory_order_relaxed) - 1].store(child, std::memory_order_release);
+         break;
+      }
+      case NODE256:
+         static_cast<Node256*>(node)->children[byte].store(child, std::memory_order_release);
+         break;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Node* concurrent_trie<Token, Data, Traits, Allocator>::_copy(const Node* node, node_kind kind, size_type offset, size_type prefix_len) {
+   Node* copy = _create(kind, prefix_len);
+   std::copy(node->prefix + offset, node->prefix + offset + prefix_len, copy->prefix);
+   copy->value.store(node->value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+   std::vector<Entry> entries;
+   try {
+      _snapshot(node, entries);
+   } catch (...) {
+      _destroy_node(copy);
+      throw;
+   }
+   for (const Entry& entry : entries) _add_child(copy, entry.byte, entry.child);
+   return copy;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Node* concurrent_trie<Token, Data, Traits, Allocator>::_split(const Node* node, size_type matched, const key_type& key, size_type from, Leaf* leaf) {
+   Node* parent = _create(NODE4, matched);
+   Node* rest = nullptr;
+   Node* tail = nullptr;
+   try {
+      rest = _copy(node, node->kind, matched + 1, node->prefix_len - matched - 1);
+      if (from < detail::key_byte_count(key)) tail = _create_tail(key, from + 1, leaf);
+   } catch (...) {
+      if (rest) _destroy_node(rest);
+      _destroy_node(parent);
+      throw;
+   }
+   std::copy(node->prefix, node->prefix + matched, parent->prefix);
+   _add_child(parent, node->prefix[matched], rest);
+   if (tail) {
+      _add_child(parent, detail::key_byte(key, from), tail);
+   } else {
+      parent->value.store(leaf, std::memory_order_relaxed);
+   }
+   return parent;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::Node* concurrent_trie<Token, Data, Traits, Allocator>::_grow(const Node* node, std::uint8_t byte, Node* child) {
+   node_kind kind = node->kind == NODE4 ? NODE16 : node->kind == NODE16 ? NODE48 : NODE256;
+   Node* grown = _copy(node, kind, 0, node->prefix_len);
+   _add_child(grown, byte, child);
+   return grown;
+}
+
+/**
+ * Reclamation
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_reclaim_node(void* context, void* object) {
+   static_cast<concurrent_trie*>(context)->_destroy_node(static_cast<Node*>(object));
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_reclaim_leaf(void* context, void* object) {
+   static_cast<concurrent_trie*>(context)->_destroy_leaf(static_cast<Leaf*>(object));
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_retire_node(epoch_domain::guard& guard, Node* node) noexcept {
+   guard.retire(node, &_reclaim_node, this);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void concurrent_trie<Token, Data, Traits, Allocator>::_retire_leaf(epoch_domain::guard& guard, Leaf* leaf) noexcept {
+   guard.retire(leaf, &_reclaim_leaf, this);
+}
+
+/**
+ * Operations
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::attempt
+concurrent_trie<Token, Data, Traits, Allocator>::_lookup(const key_type& key, Leaf*& leaf) const {
+   const Node* node = root_;
+   std::uint64_t version;
+   if (!_read_lock(node, version)) return RESTART;
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   for (;;) {
+      // labels never change, so only what comes after needs validating
+      size_type matched = _match_prefix(node, key, i);
+      if (matched < node->prefix_len) {
+         leaf = nullptr;
+         return _validate(node, version) ? DONE : RESTART;
+      }
+      i += matched;
+      if (i == n) {
+         leaf = node->value.load(std::memory_order_acquire);
+         return _validate(node, version) ? DONE : RESTART;
+      }
+      const Node* child = _find_child(node, detail::key_byte(key, i++));
+      if (!_validate(node, version)) return RESTART;
+      if (!child) {
+         leaf = nullptr;
+         return DONE;
+      }
+      if (!_read_lock(child, version)) return RESTART;
+      node = child;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::attempt
+concurrent_trie<Token, Data, Traits, Allocator>::_insert(epoch_domain::guard& guard, const key_type& key, const mapped_type& data, bool assign) {
+   Node* parent = nullptr;
+   std::uint64_t parent_version = 0;
+   std::uint8_t parent_byte = 0;
+   Node* node = root_;
+   std::uint64_t version;
+   if (!_read_lock(node, version)) return RESTART;
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   for (;;) {
+      size_type matched = _match_prefix(node, key, i);
+      if (matched < node->prefix_len) {
+         // the root has no label, so there is a parent to swap the split into
+         if (!_upgrade(parent, parent_version)) return RESTART;
+         if (!_upgrade(node, version)) {
+            _unlock(parent);
+            return RESTART;
+         }
+         Node* split;
+         try {
+            Leaf* leaf = _create_leaf(data);
+            try {
+               split = _split(node, matched, key, i + matched, leaf);
+            } catch (...) {
+               _destroy_leaf(leaf);
+               throw;
+            }
+         } catch (...) {
+            _unlock(node);
+            _unlock(parent);
+            throw;
+         }
+         _replace_child(parent, parent_byte, split);
+         _unlock(parent);
+         _unlock_obsolete(node);
+         _retire_node(guard, node);
+         size_.fetch_add(1, std::memory_order_relaxed);
+         return DONE;
+      }
+      i += matched;
+
+      if (i == n) {
+         if (!_upgrade(node, version)) return RESTART;
+         Leaf* old = node->value.load(std::memory_order_relaxed);
+         if (old && !assign) {
+            _unlock(node);
+            return FAILED;
+         }
+         Leaf* leaf;
+         try {
+            leaf = _create_leaf(data);
+         } catch (...) {
+            _unlock(node);
+            throw;
+         }
+         node->value.store(leaf, std::memory_order_release);
+         _unlock(node);
+         if (old) {
+            _retire_leaf(guard, old);
+            return FAILED;
+         }
+         size_.fetch_add(1, std::memory_order_relaxed);
+         return DONE;
+      }
+
+      std::uint8_t byte = detail::key_byte(key, i);
+      Node* child = _find_child(node, byte);
+      if (!_validate(node, version)) return RESTART;
+      if (!child) {
+         // nodes below the root may be full and need replacing
+         bool full = node->count.load(std::memory_order_relaxed) == _capacity(node);
+         if (full && !_upgrade(parent, parent_version)) return RESTART;
+         if (!_upgrade(node, version)) {
+            if (full) _unlock(parent);
+            return RESTART;
+         }
+         Node* grown = nullptr;
+         try {
+            Leaf* leaf = _create_leaf(data);
+            Node* tail;
+            try {
+               tail = _create_tail(key, i + 1, leaf);
+            } catch (...) {
+               _destroy_leaf(leaf);
+               throw;
+            }
+            if (!full) {
+               _add_child(node, byte, tail);
+            } else {
+               try {
+                  grown = _grow(node, byte, tail);
+               } catch (...) {
+                  _destroy_node(tail);
+                  _destroy_leaf(leaf);
+                  throw;
+               }
+            }
+         } catch (...) {
+            _unlock(node);
+            if (full) _unlock(parent);
+            throw;
+         }
+         if (full) {
+            _replace_child(parent, parent_byte, grown);
+            _unlock(parent);
+            _unlock_obsolete(node);
+            _retire_node(guard, node);
+         } else {
+            _unlock(node);
+         }
+         size_.fetch_add(1, std::memory_order_relaxed);
+         return DONE;
+      }
+
+      std::uint64_t child_version;
+      if (!_read_lock(child, child_version)) return RESTART;
+      parent = node;
+      parent_version = version;
+      parent_byte = byte;
+      node = child;
+      version = child_version;
+      i++;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename concurrent_trie<Token, Data, Traits, Allocator>::attempt
+concurrent_trie<Token, Data, Traits, Allocator>::_erase(epoch_domain::guard& guard, const key_type& key) {
+   Node* parent = nullptr;
+   std::uint64_t parent_version = 0;
+   std::uint8_t parent_byte = 0;
+   Node* node = root_;
+   std::uint64_t version;
+   if (!_read_lock(node, version)) return RESTART;
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   for (;;) {
+      size_type matched = _match_prefix(node, key, i);
+      if (matched < node->prefix_len) return _validate(node, version) ? FAILED : RESTART;
+      i += matched;
+      if (i == n) break;
+      std::uint8_t byte = detail::key_byte(key, i++);
+      Node* child = _find_child(node, byte);
+      if (!_validate(node, version)) return RESTART;
+      if (!child) return FAILED;
+      std::uint64_t child_version;
+      if (!_read_lock(child, child_version)) return RESTART;
+      parent = node;
+      parent_version = version;
+      parent_byte = byte;
+      node = child;
+      version = child_version;
+   }
+
+   Leaf* leaf = node->value.load(std::memory_order_relaxed);
+   bool unlink = parent && node->count.load(std::memory_order_relaxed) == 0;
+   if (!leaf) return _validate(node, version) ? FAILED : RESTART;
+   if (unlink) {
+      if (!_upgrade(parent, parent_version)) return RESTART;
+      if (!_upgrade(node, version)) {
+         _unlock(parent);
+         return RESTART;
+      }
+      _remove_child(parent, parent_byte);
+      _unlock(parent);
+      _unlock_obsolete(node);
+      _retire_node(guard, node);
+   } else {
+      // the upgrade fails if what was read above went stale
+      if (!_upgrade(node, version)) return RESTART;
+      node->value.store(nullptr, std::memory_order_relaxed);
+      _unlock(node);
+   }
+   _retire_leaf(guard, leaf);
+   size_.fetch_sub(1, std::memory_order_relaxed);
+   return DONE;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename F>
+bool concurrent_trie<Token, Data, Traits, Allocator>::_scan(std::vector<std::uint8_t> bound, bool inclusive, F f) const {
+   std::vector<std::uint8_t> path;
+   std::vector<Entry> entries;
+   for (;;) {
+      epoch_domain::guard guard(domain_);
+      path.clear();
+      entries.clear();
+      attempt result = _scan_node(root_, path, bound, inclusive, false, entries, f);
+      if (result != RESTART) return result == DONE;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename F>
+typename concurrent_trie<Token, Data, Traits, Allocator>::attempt
+concurrent_trie<Token, Data, Traits, Allocator>::_scan_node(const Node* node, std::vector<std::uint8_t>& path,
+                                                            std::vector<std::uint8_t>& bound, bool& inclusive, bool above,
+                                                            std::vector<Entry>& entries, F& f) const {
+   if (!above) {
+      // path is either a prefix of bound, or decides the whole subtree
+      size_type n = std::min(path.size(), bound.size());
+      size_type lcp = 0;
+      while (lcp < n && path[lcp] == bound[lcp]) lcp++;
+      if (lcp < path.size()) {
+         if (lcp < bound.size() && path[lcp] < bound[lcp]) return DONE;
+         above = true;
+      }
+   }
+
+   // a consistent copy of the node's data and children
+   size_type first = entries.size();
+   const Leaf* leaf;
+   for (;;) {
+      std::uint64_t version;
+      if (!_read_lock(node, version)) return RESTART;
+      leaf = node->value.load(std::memory_order_acquire);
+      _snapshot(node, entries);
+      if (_validate(node, version)) break;
+      entries.resize(first);
+   }
+
+   if (leaf && (above || (inclusive && path.size() == bound.size()))) {
+      bound = path;
+      inclusive = false;
+      if (!f(static_cast<const std::vector<std::uint8_t>&>(path), leaf)) return FAILED;
+   }
+
+   size_type depth = path.size();
+   for (size_type i = first; i < entries.size(); i++) {
+      Entry entry = entries[i];
+      if (!above && depth < bound.size() && entry.byte < bound[depth]) continue;
+      path.push_back(entry.byte);
+      path.insert(path.end(), entry.child->prefix, entry.child->prefix + entry.child->prefix_len);
+      attempt result = _scan_node(entry.child, path, bound, inclusive, above, entries, f);
+      path.resize(depth);
+      if (result != DONE) {
+         entries.resize(first);
+         return result;
+      }
+   }
+   entries.resize(first);
+   return DONE;
+}
+
+} // namespace dsacpp
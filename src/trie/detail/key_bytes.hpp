@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace dsacpp
+{
+
+namespace detail
+{
+
+/**
+ * How the trie family walks a key: each token contributes its unsigned
+ * value, most significant byte first, so byte order and token order agree.
+ * trie, concurrent_trie, frozen_trie, trie_view and double_array_trie all
+ * go through these so their encodings cannot drift apart.
+ */
+
+template<typename Token, typename Traits>
+std::size_t key_byte_count(const std::basic_string<Token, Traits>& key) noexcept {
+   return key.size() * sizeof(Token);
+}
+
+// byte i of key
+template<typename Token, typename Traits>
+std::uint8_t key_byte(const std::basic_string<Token, Traits>& key, std::size_t i) noexcept {
+   constexpr std::size_t TOKEN_BYTES = sizeof(Token);
+   if constexpr (TOKEN_BYTES == 1) {
+      return static_cast<std::uint8_t>(key[i]);
+   } else {
+      auto token = static_cast<std::make_unsigned_t<Token>>(key[i / TOKEN_BYTES]);
+      return static_cast<std::uint8_t>(token >> (8 * (TOKEN_BYTES - 1 - i % TOKEN_BYTES)));
+   }
+}
+
+template<typename Token, typename Traits>
+void key_to_bytes(const std::basic_string<Token, Traits>& key, std::vector<std::uint8_t>& bytes) {
+   std::size_t n = key_byte_count(key);
+   bytes.resize(n);
+   for (std::size_t i = 0; i < n; i++) bytes[i] = key_byte(key, i);
+}
+
+// the inverse of key_to_bytes; bytes holds whole tokens
+template<typename Token, typename Traits>
+void bytes_to_key(const std::vector<std::uint8_t>& bytes, std::basic_string<Token, Traits>& key) {
+   using unsigned_token = std::make_unsigned_t<Token>;
+   constexpr std::size_t TOKEN_BYTES = sizeof(Token);
+   key.resize(bytes.size() / TOKEN_BYTES);
+   for (std::size_t t = 0; t < key.size(); t++) {
+      unsigned_token token = 0;
+      for (std::size_t b = 0; b < TOKEN_BYTES; b++) {
+         token = static_cast<unsigned_token>((token << 8) | bytes[t * TOKEN_BYTES + b]);
+      }
+      key[t] = static_cast<Token>(token);
+   }
+}
+
+} // namespace detail
+
+} // namespace dsacpp
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "detail/key_bytes.hpp"
+#include "trie.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Read-only trie compiled into a double array, made by trie::compile().
+ * Every state of the byte-level trie is a slot holding a base and a
+ * check. The transition from state s on code c lands on slot base[s] + c
+ * and is taken if that slot's check is s. That is two reads from one
+ * 8-byte unit, with no search among siblings. Codes are key bytes plus
+ * one. Code 0 marks the end of a key, and the base of the slot it leads
+ * to is the index of the key's data.
+ *
+ * Compiling places each state's children at the first base whose slots
+ * are all free, walking a list of the free slots from the lowest up; a
+ * slot that keeps failing leaves the list, so building stays about linear
+ * in the number of states at the cost of a few holes. The array is padded
+ * so any base plus any code stays in bounds, which keeps lookups free of
+ * range checks. Besides exact lookups, a text can be matched against every
+ * key that is a prefix of it in one pass: the longest such key, or all of
+ * them shortest first, as a tokenizer does.
+ */
+template<
+   typename Token,
+   typename Data        = void,
+   typename Traits      = std::char_traits<Token>
+>
+class double_array_trie {
+public:
+
+   /**
+    * Type Declarations
+    */
+
+   using token_type        = Token;
+   using key_type          = std::basic_string<Token, Traits>;
+   using data_type         = Data;
+   using mapped_type       = std::conditional_t<std::is_void<Data>::value, trie_no_data, Data>;
+   using traits_type       = Traits;
+   using size_type         = size_t;
+   using difference_type   = std::ptrdiff_t;
+
+   static constexpr size_type npos = static_cast<size_type>(-1);
+
+   /*
+    * Constructors
+   */
+
+   // an empty trie
+   double_array_trie();
+
+   template<typename Allocator>
+   explicit double_array_trie(const trie<Token, Data, Traits, Allocator>& source);
+
+   /**
+    * Lookup
+    */
+
+   bool contains(const key_type& key) const noexcept;
+
+   // key's data, or null if key is not there
+   const mapped_type* find(const key_type& key) const noexcept;
+
+   const mapped_type& at(const key_type& key) const;
+
+   // the length in tokens of the longest key that text has at position
+   // pos, or npos if none; data, if given, is set to that key's data
+   size_type longest_prefix(const key_type& text, size_type pos = 0, const mapped_type** data = nullptr) const noexcept;
+
+   // f(length) for a set, f(length, data) for a map, for every key that
+   // text has at position pos, shortest first, until f returns false; true
+   // if it saw them all
+   template<typename F>
+   bool for_each_common_prefix(const key_type& text, size_type pos, F f) const;
+
+   /**
+    * Getters
+    */
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+   // slots in the double array, used or not
+   size_type slot_count() const noexcept;
+
+   // bytes held by the array and data
+   size_type memory_usage() const noexcept;
+
+private:
+
+   using state_type = std::int32_t;
+
+   static constexpr size_type TOKEN_BYTES = sizeof(Token);
+   static constexpr size_type CODES = 257;
+   static constexpr state_type ROOT = 0;
+   static constexpr state_type NONE = -1;
+   // a free slot that fails this often as a base search start stops being tried
+   static constexpr std::uint8_t MAX_MISSES = 16;
+
+   // the data of a set takes no room
+   using data_list = std::conditional_t<std::is_void<Data>::value, trie_no_data, std::vector<mapped_type>>;
+
+   struct Unit {
+      // first slot of this state's children, or the data index of a key end
+      state_type base;
+      // the state this slot is a child of, NONE if free
+      state_type check;
+   };
+
+   std::vector<Unit> units_;
+   [[no_unique_address]] data_list data_;
+   size_type size_ = 0;
+
+   // the state reached from state on code, or NONE
+   state_type _next(state_type state, size_type code) const noexcept;
+
+   // the state after key's tokens from pos to end, or NONE
+   state_type _walk(const key_type& key, size_type pos, size_type end) const noexcept;
+
+   const mapped_type& _data(state_type end) const noexcept;
+
+   // while compiling: which slots are taken, with the free ones linked in
+   // ascending order so the base search steps over taken runs at once
+   struct Slots {
+      std::vector<bool> used;
+      std::vector<std::uint8_t> misses;
+      std::vector<size_type> next;
+      std::vector<size_type> prev;
+      size_type head = 0;
+      size_type tail = 0;
+   };
+
+   // grow the array to hold slot, keeping room for any code past it
+   void _reserve(Slots& slots, size_type slot);
+
+   void _take(Slots& slots, size_type slot) noexcept;
+
+   // drop a free slot from the list
+   static void _unlink(Slots& slots, size_type slot) noexcept;
+};
+
+/*
+ * Constructors
+*/
+
+template<typename Token, typename Data, typename Traits>
+double_array_trie<Token, Data, Traits>::double_array_trie() :
+   units_(CODES + 1, Unit{ 0, NONE })
+{ }
+
+template<typename Token, typename Data, typename Traits>
+template<typename Allocator>
+double_array_trie<Token, Data, Traits>::double_array_trie(const trie<Token, Data, Traits, Allocator>& source) :
+   size_{ source.size() }
+{
+   using source_type = trie<Token, Data, Traits, Allocator>;
+   using Node = typename source_type::Node;
+
+   // a byte-level state: offset bytes into node's label, or past it
+   struct Pending {
+      state_type state;
+      const Node* node;
+      std::uint32_t offset;
+   };
+
+   if constexpr (!std::is_void<Data>::value) data_.reserve(size_);
+   Slots slots;
+   _reserve(slots, 0);
+   _take(slots, ROOT);
+   size_type last_used = 0;
+
+   std::vector<size_type> codes;
+   std::vector<const Node*> targets;
+   std::deque<Pending> queue{ { ROOT, source.root_, 0 } };
+   while (!queue.empty()) {
+      Pending pending = queue.front();
+      queue.pop_front();
+      const Node* node = pending.node;
+      if (!node) continue;
+
+      // the codes out of this state, ascending; code 0 ends a key
+      codes.clear();
+      targets.clear();
+      if (pending.offset < node->prefix_len) {
+         codes.push_back(size_type{ node->prefix[pending.offset] } + 1);
+         targets.push_back(node);
+      } else {
+         if (node->value) {
+            codes.push_back(0);
+            targets.push_back(nullptr);
+         }
+         int pos = -1;
+         std::uint8_t byte;
+         Node* child;
+         while (source_type::_next_child(node, pos, byte, child)) {
+            codes.push_back(size_type{ byte } + 1);
+            targets.push_back(child);
+         }
+      }
+      if (codes.empty()) continue;
+
+      // first base, from the lowest free slot up, whose slots are all free
+      size_type base = 0;
+      for (size_type slot = slots.head; ; ) {
+         _reserve(slots, slot);
+         size_type next = slots.next[slot];
+         if (slot >= codes[0]) {
+            base = slot - codes[0];
+            bool fits = true;
+            for (size_type code : codes) {
+               if (slots.used[base + code]) {
+                  fits = false;
+                  break;
+               }
+            }
+            if (fits) break;
+            if (++slots.misses[slot] == MAX_MISSES) _unlink(slots, slot);
+         }
+         slot = next;
+      }
+      if (base + CODES > static_cast<size_type>(std::numeric_limits<state_type>::max())) {
+         throw std::length_error("double_array_trie too many states");
+      }
+
+      units_[pending.state].base = static_cast<state_type>(base);
+      for (size_type i = 0; i < codes.size(); i++) {
+         size_type slot = base + codes[i];
+         _take(slots, slot);
+         units_[slot].check = pending.state;
+         last_used = std::max(last_used, slot);
+         if (codes[i] == 0) {
+            if constexpr (!std::is_void<Data>::value) {
+               units_[slot].base = static_cast<state_type>(data_.size());
+               data_.push_back(node->value->data);
+            }
+         } else if (targets[i] == node) {
+            queue.push_back({ static_cast<state_type>(slot), node, pending.offset + 1 });
+         } else {
+            queue.push_back({ static_cast<state_type>(slot), targets[i], 0 });
+         }
+      }
+   }
+
+   // room for any code past the last base; free slots never pass a check
+   units_.resize(last_used + CODES + 1, Unit{ 0, NONE });
+   units_.shrink_to_fit();
+}
+
+/**
+ * Lookup
+ */
+
+template<typename Token, typename Data, typename Traits>
+bool double_array_trie<Token, Data, Traits>::contains(const key_type& key) const noexcept {
+   return find(key) != nullptr;
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename double_array_trie<Token, Data, Traits>::mapped_type* double_array_trie<Token, Data, Traits>::find(const key_type& key) const noexcept {
+   state_type state = _walk(key, 0, key.size());
+   if (state == NONE) return nullptr;
+   state_type end = _next(state, 0);
+   if (end == NONE) return nullptr;
+   return &_data(end);
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename double_array_trie<Token, Data, Traits>::mapped_type& double_array_trie<Token, Data, Traits>::at(const key_type& key) const {
+   const mapped_type* data = find(key);
+   if (!data) throw std::out_of_range("double_array_trie::at key not found");
+   return *data;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename double_array_trie<Token, Data, Traits>::size_type
+double_array_trie<Token, Data, Traits>::longest_prefix(const key_type& text, size_type pos, const mapped_type** data) const noexcept {
+   size_type longest = npos;
+   state_type state = ROOT;
+   state_type last = NONE;
+   for (size_type t = pos; ; t++) {
+      state_type end = _next(state, 0);
+      if (end != NONE) {
+         longest = t - pos;
+         last = end;
+      }
+      if (t >= text.size()) break;
+      for (size_type b = 0; b < TOKEN_BYTES && state != NONE; b++) {
+         state = _next(state, size_type{ detail::key_byte(text, t * TOKEN_BYTES + b) } + 1);
+      }
+      if (state == NONE) break;
+   }
+   if (data && last != NONE) *data = &_data(last);
+   return longest;
+}
+
+template<typename Token, typename Data, typename Traits>
+template<typename F>
+bool double_array_trie<Token, Data, Traits>::for_each_common_prefix(const key_type& text, size_type pos, F f) const {
+   state_type state = ROOT;
+   for (size_type t = pos; ; t++) {
+      // keys end on token boundaries only
+      state_type end = _next(state, 0);
+      if (end != NONE) {
+         if constexpr (std::is_void<Data>::value) {
+            if (!f(t - pos)) return false;
+         } else {
+            if (!f(t - pos, _data(end))) return false;
+         }
+      }
+      if (t >= text.size()) return true;
+      for (size_type b = 0; b < TOKEN_BYTES; b++) {
+         state = _next(state, size_type{ detail::key_byte(text, t * TOKEN_BYTES + b) } + 1);
+         if (state == NONE) return true;
+      }
+   }
+}
+
+/**
+ * Getters
+ */
+
+template<typename Token, typename Data, typename Traits>
+typename double_array_trie<Token, Data, Traits>::size_type double_array_trie<Token, Data, Traits>::size() const noexcept {
+   return size_;
+}
+
+template<typename Token, typename Data, typename Traits>
+bool double_array_trie<Token, Data, Traits>::empty() const noexcept {
+   return size_ == 0;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename double_array_trie<Token, Data, Traits>::size_type double_array_trie<Token, Data, Traits>::slot_count() const noexcept {
+   return units_.size();
+}
+
+template<typename Token, typename Data, typename Traits>
+typename double_array_trie<Token, Data, Traits>::size_type double_array_trie<Token, Data, Traits>::memory_usage() const noexcept {
+   size_type bytes = units_.capacity() * sizeof(Unit);
+   if constexpr (!std::is_void<Data>::value) bytes += data_.capacity() * sizeof(mapped_type);
+   return bytes;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename double_array_trie<Token, Data, Traits>::state_type double_array_trie<Token, Data, Traits>::_next(state_type state, size_type code) const noexcept {
+   const Unit& to = units_[static_cast<size_type>(units_[state].base) + code];
+   return to.check == state ? static_cast<state_type>(&to - units_.data()) : NONE;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename double_array_trie<Token, Data, Traits>::state_type
+double_array_trie<Token, Data, Traits>::_walk(const key_type& key, size_type pos, size_type end) const noexcept {
+   state_type state = ROOT;
+   for (size_type i = pos * TOKEN_BYTES; i < end * TOKEN_BYTES && state != NONE; i++) {
+      state = _next(state, size_type{ detail::key_byte(key, i) } + 1);
+   }
+   return state;
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename double_array_trie<Token, Data, Traits>::mapped_type& double_array_trie<Token, Data, Traits>::_data([[maybe_unused]] state_type end) const noexcept {
+   if constexpr (std::is_void<Data>::value) {
+      return data_;
+   } else {
+      return data_[static_cast<size_type>(units_[end].base)];
+   }
+}
+
+template<typename Token, typename Data, typename Traits>
+void double_array_trie<Token, Data, Traits>::_reserve(Slots& slots, size_type slot) {
+   size_type need = slot + CODES + 1;
+   size_type size = units_.size();
+   if (size >= need) return;
+   size_type grown = std::max(need, size * 2);
+   units_.resize(grown, Unit{ 0, NONE });
+   slots.used.resize(grown, false);
+   slots.misses.resize(grown, 0);
+   slots.next.resize(grown);
+   slots.prev.resize(grown);
+   // the new slots go on the end of the free list, which is never empty
+   // once there are slots: the last is always out of reach of any base
+   for (size_type i = size; i < grown; i++) {
+      slots.prev[i] = i == size ? slots.tail : i - 1;
+      slots.next[i] = i + 1;
+   }
+   if (size == 0) slots.head = 0;
+   else slots.next[slots.tail] = size;
+   slots.tail = grown - 1;
+}
+
+template<typename Token, typename Data, typename Traits>
+void double_array_trie<Token, Data, Traits>::_take(Slots& slots, size_type slot) noexcept {
+   slots.used[slot] = true;
+   if (slots.misses[slot] < MAX_MISSES) _unlink(slots, slot);
+}
+
+template<typename Token, typename Data, typename Traits>
+void double_array_trie<Token, Data, Traits>::_unlink(Slots& slots, size_type slot) noexcept {
+   if (slot == slots.head) slots.head = slots.next[slot];
+   else slots.next[slots.prev[slot]] = slots.next[slot];
+   if (slot == slots.tail) slots.tail = slots.prev[slot];
+   else slots.prev[slots.next[slot]] = slots.prev[slot];
+}
+
+/**
+ * trie::compile
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+double_array_trie<Token, Data, Traits> trie<Token, Data, Traits, Allocator>::compile() const {
+   return double_array_trie<Token, Data, Traits>(*this);
+}
+
+} // namespace dsacpp
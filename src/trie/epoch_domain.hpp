@@ -0,0 +1,228 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../vector/allocator.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Epoch-based reclamation for lock-free readers. Every operation that may
+ * touch shared objects runs under a guard, which pins the epoch current
+ * when it opened. An object unlinked from the shared structure is retired
+ * rather than freed, stamped with the epoch of its retirement, and handed
+ * to its reclaim function once the global epoch has moved two past that
+ * stamp: the epoch only advances when every open guard has seen the
+ * current one, so by then no guard that could have reached the object is
+ * still open.
+ *
+ * Guards take one of a list of records, which grows to the largest number
+ * of guards ever open at once; each record keeps the objects retired
+ * under it and reclaims them as the epoch allows. Records are reused
+ * across threads, and a thread tends to get its last one back. The
+ * destructor reclaims whatever is still retired and must not run while a
+ * guard is open.
+ */
+class epoch_domain {
+   struct Record;
+
+public:
+
+   using reclaim_fn = void (*)(void* context, void* object);
+
+   /**
+    * Critical section over a domain; not to be shared between threads
+    */
+   class guard {
+   public:
+
+      explicit guard(epoch_domain& domain);
+
+      guard(const guard&) = delete;
+      guard& operator=(const guard&) = delete;
+
+      ~guard();
+
+      // object is already unreachable for guards opened from now on
+      void retire(void* object, reclaim_fn reclaim, void* context) noexcept;
+
+   private:
+
+      epoch_domain& domain_;
+      Record* record_;
+   };
+
+   /**
+    * Constructors
+    */
+
+   epoch_domain() noexcept;
+
+   epoch_domain(const epoch_domain&) = delete;
+   epoch_domain& operator=(const epoch_domain&) = delete;
+
+   ~epoch_domain();
+
+private:
+
+   struct Retired {
+      void* object;
+      reclaim_fn reclaim;
+      void* context;
+      std::uint64_t epoch;
+   };
+
+   struct alignas(CACHE_LINE_SIZE) Record {
+      // epoch pinned by the open guard, or QUIESCENT
+      std::atomic<std::uint64_t> epoch{ QUIESCENT };
+      std::atomic<bool> busy{ false };
+      Record* next = nullptr;
+      // only touched by the guard holding the record
+      std::vector<Retired> limbo;
+   };
+
+   // a thread's last record, valid while the domain with that id lives
+   struct Hint {
+      std::uint64_t domain = 0;
+      Record* record = nullptr;
+   };
+
+   static constexpr std::uint64_t QUIESCENT = 0;
+
+   // retirements between attempts to advance the epoch and reclaim
+   static constexpr std::size_t COLLECT_EVERY = 64;
+
+   const std::uint64_t id_;
+   std::atomic<std::uint64_t> epoch_;
+   std::atomic<Record*> records_;
+
+   static std::uint64_t _next_id() noexcept;
+   static Hint& _hint() noexcept;
+
+   Record* _acquire();
+   void _release(Record* record) noexcept;
+
+   // move the epoch on if every open guard has seen it
+   void _try_advance() noexcept;
+
+   // reclaim what record holds that no open guard can reach
+   void _collect(Record* record) noexcept;
+};
+
+inline epoch_domain::guard::guard(epoch_domain& domain) :
+   domain_{ domain },
+   record_{ domain._acquire() }
+{
+   // release, so that an advance reading the new pin is ordered after the
+   // record's previous guard
+   record_->epoch.store(domain_.epoch_.load(std::memory_order_acquire), std::memory_order_release);
+   // the pin must be visible before this guard reads any shared pointer
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline epoch_domain::guard::~guard() {
+   record_->epoch.store(QUIESCENT, std::memory_order_release);
+   domain_._release(record_);
+}
+
+inline void epoch_domain::guard::retire(void* object, reclaim_fn reclaim, void* context) noexcept {
+   // a read-modify-write sees the latest epoch and orders the unlink before
+   // any advance past it; a stale stamp would free the object too early
+   std::uint64_t epoch = domain_.epoch_.fetch_add(0, std::memory_order_acq_rel);
+   try {
+      record_->limbo.push_back({ object, reclaim, context, epoch });
+   } catch (...) {
+      // out of memory: leaking the object is the only safe option left
+      return;
+   }
+   if (record_->limbo.size() % COLLECT_EVERY == 0) {
+      domain_._try_advance();
+      domain_._collect(record_);
+   }
+}
+
+inline epoch_domain::epoch_domain() noexcept :
+   id_{ _next_id() },
+   epoch_{ 1 },
+   records_{ nullptr }
+{ }
+
+inline epoch_domain::~epoch_domain() {
+   Record* record = records_.load(std::memory_order_acquire);
+   while (record) {
+      for (const Retired& retired : record->limbo) {
+         retired.reclaim(retired.context, retired.object);
+      }
+      Record* next = record->next;
+      delete record;
+      record = next;
+   }
+}
+
+inline std::uint64_t epoch_domain::_next_id() noexcept {
+   static std::atomic<std::uint64_t> next{ 1 };
+   return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline epoch_domain::Hint& epoch_domain::_hint() noexcept {
+   thread_local Hint hint;
+   return hint;
+}
+
+inline epoch_domain::Record* epoch_domain::_acquire() {
+   Hint& hint = _hint();
+   if (hint.domain == id_ && !hint.record->busy.exchange(true, std::memory_order_acquire)) {
+      return hint.record;
+   }
+   for (Record* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+      if (!record->busy.load(std::memory_order_relaxed) && !record->busy.exchange(true, std::memory_order_acquire)) {
+         hint = { id_, record };
+         return record;
+      }
+   }
+   Record* record = new Record;
+   record->busy.store(true, std::memory_order_relaxed);
+   Record* head = records_.load(std::memory_order_relaxed);
+   do {
+      record->next = head;
+   } while (!records_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+   hint = { id_, record };
+   return record;
+}
+
+inline void epoch_domain::_release(Record* record) noexcept {
+   record->busy.store(false, std::memory_order_release);
+}
+
+inline void epoch_domain::_try_advance() noexcept {
+   std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+   // pairs with the fence in guard's constructor: a guard either shows up
+   // here or sees every unlink made before this point
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   for (Record* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+      // acquire: reads made under a guard happen before any reclaim past it
+      std::uint64_t pinned = record->epoch.load(std::memory_order_acquire);
+      if (pinned != QUIESCENT && pinned != epoch) return;
+   }
+   epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+inline void epoch_domain::_collect(Record* record) noexcept {
+   std::uint64_t epoch = epoch_.load(std::memory_order_acquire);
+   std::size_t kept = 0;
+   for (std::size_t i = 0; i < record->limbo.size(); i++) {
+      const Retired& retired = record->limbo[i];
+      if (retired.epoch + 2 <= epoch) {
+         retired.reclaim(retired.context, retired.object);
+      } else {
+         record->limbo[kept++] = retired;
+      }
+   }
+   record->limbo.resize(kept);
+}
+
+} // namespace dsacpp
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "detail/key_bytes.hpp"
+#include "trie.hpp"
+#include "../bitset/bit_vector.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Read-only trie in succinct form, made by trie::freeze(). The tree is the
+ * byte-level trie of the keys, one node per distinct key prefix in bytes,
+ * numbered in level order and stored as three packed arrays:
+ *    - the LOUDS bits: "10" for a virtual super-root, then for every node
+ *      a one per child followed by a zero. Node x is the x-th one, and its
+ *      children, numbered consecutively, lie between the x-th and the
+ *      (x + 1)-th zero, which select0 finds.
+ *    - a terminal bit per node, set where a key ends; its rank is the
+ *      index of the key's data
+ *    - the byte labelling the edge into every node but the root, sorted
+ *      among siblings so a child is found by binary search
+ * That comes to about eleven bits per node on top of the data. Labels of
+ * the source trie are expanded a byte per node, so a long unshared key
+ * suffix costs about eleven bits per byte.
+ */
+template<
+   typename Token,
+   typename Data        = void,
+   typename Traits      = std::char_traits<Token>
+>
+class frozen_trie {
+public:
+
+   /**
+    * Type Declarations
+    */
+
+   using token_type        = Token;
+   using key_type          = std::basic_string<Token, Traits>;
+   using data_type         = Data;
+   using mapped_type       = std::conditional_t<std::is_void<Data>::value, trie_no_data, Data>;
+   using traits_type       = Traits;
+   using size_type         = size_t;
+   using difference_type   = std::ptrdiff_t;
+
+   /*
+    * Constructors
+   */
+
+   // an empty trie
+   frozen_trie();
+
+   template<typename Allocator>
+   explicit frozen_trie(const trie<Token, Data, Traits, Allocator>& source);
+
+   /**
+    * Lookup
+    */
+
+   bool contains(const key_type& key) const noexcept;
+
+   // key's data, or null if key is not there
+   const mapped_type* find(const key_type& key) const noexcept;
+
+   const mapped_type& at(const key_type& key) const;
+
+   // f(key) for a set, f(key, data) for a map, over the keys starting with
+   // prefix in key order, until f returns false; true if it saw them all
+   template<typename F>
+   bool for_each_prefix(const key_type& prefix, F f) const;
+
+   /**
+    * Getters
+    */
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+   size_type node_count() const noexcept;
+
+   // bytes held by the bits, labels and data
+   size_type memory_usage() const noexcept;
+
+private:
+
+   static constexpr size_type NONE = static_cast<size_type>(-1);
+
+   // the data of a set takes no room
+   using data_list = std::conditional_t<std::is_void<Data>::value, trie_no_data, std::vector<mapped_type>>;
+
+   // a node's children are the node ids [first, last)
+   struct Range {
+      size_type first;
+      size_type last;
+   };
+
+   bit_vector louds_;
+   bit_vector terminal_;
+   // labels_[x - 1] leads into node x
+   std::vector<std::uint8_t> labels_;
+   [[no_unique_address]] data_list data_;
+   size_type size_ = 0;
+
+   /**
+    * Navigation
+    */
+
+   Range _children(size_type node) const noexcept;
+
+   // the child of node under byte, or NONE
+   size_type _child(size_type node, std::uint8_t byte) const noexcept;
+
+   // the node spelling key's bytes, or NONE
+   size_type _find_node(const key_type& key) const noexcept;
+
+   const mapped_type& _data(size_type node) const noexcept;
+};
+
+/*
+ * Constructors
+*/
+
+template<typename Token, typename Data, typename Traits>
+frozen_trie<Token, Data, Traits>::frozen_trie() {
+   louds_.push_back(true);
+   louds_.push_back(false);
+   louds_.push_back(false);
+   terminal_.push_back(false);
+   louds_.build_index();
+   terminal_.build_index();
+}
+
+template<typename Token, typename Data, typename Traits>
+template<typename Allocator>
+frozen_trie<Token, Data, Traits>::frozen_trie(const trie<Token, Data, Traits, Allocator>& source) :
+   size_{ source.size() }
+{
+   using source_type = trie<Token, Data, Traits, Allocator>;
+   using Node = typename source_type::Node;
+
+   // a byte-level node: offset bytes into node's label, or past it
+   struct Position {
+      const Node* node;
+      std::uint32_t offset;
+   };
+
+   if constexpr (!std::is_void<Data>::value) data_.reserve(size_);
+   louds_.push_back(true);
+   louds_.push_back(false);
+
+   // level order, one byte-level node at a time
+   std::deque<Position> queue{ { source.root_, 0 } };
+   while (!queue.empty()) {
+      Position position = queue.front();
+      queue.pop_front();
+      const Node* node = position.node;
+      bool terminal = node && position.offset == node->prefix_len && node->value;
+      terminal_.push_back(terminal);
+      if constexpr (!std::is_void<Data>::value) {
+         if (terminal) data_.push_back(node->value->data);
+      }
+      if (!node) {
+         louds_.push_back(false);
+      } else if (position.offset < node->prefix_len) {
+         louds_.push_back(true);
+         labels_.push_back(node->prefix[position.offset]);
+         queue.push_back({ node, position.offset + 1 });
+         louds_.push_back(false);
+      } else {
+         int pos = -1;
+         std::uint8_t byte;
+         Node* child;
+         while (source_type::_next_child(node, pos, byte, child)) {
+            louds_.push_back(true);
+            labels_.push_back(byte);
+            queue.push_back({ child, 0 });
+         }
+         louds_.push_back(false);
+      }
+   }
+   louds_.build_index();
+   terminal_.build_index();
+}
+
+/**
+ * Lookup
+ */
+
+template<typename Token, typename Data, typename Traits>
+bool frozen_trie<Token, Data, Traits>::contains(const key_type& key) const noexcept {
+   size_type node = _find_node(key);
+   return node != NONE && terminal_[node];
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename frozen_trie<Token, Data, Traits>::mapped_type* frozen_trie<Token, Data, Traits>::find(const key_type& key) const noexcept {
+   size_type node = _find_node(key);
+   if (node == NONE || !terminal_[node]) return nullptr;
+   return &_data(node);
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename frozen_trie<Token, Data, Traits>::mapped_type& frozen_trie<Token, Data, Traits>::at(const key_type& key) const {
+   const mapped_type* data = find(key);
+   if (!data) throw std::out_of_range("frozen_trie::at key not found");
+   return *data;
+}
+
+template<typename Token, typename Data, typename Traits>
+template<typename F>
+bool frozen_trie<Token, Data, Traits>::for_each_prefix(const key_type& prefix, F f) const {
+   size_type start = _find_node(prefix);
+   if (start == NONE) return true;
+
+   // depth-first in label order is key order; each frame is a node's
+   // children still to visit and the key length in bytes at the node
+   struct Frame {
+      Range children;
+      size_type depth;
+   };
+
+   std::vector<std::uint8_t> bytes;
+   detail::key_to_bytes(prefix, bytes);
+   key_type key;
+   auto visit = [&](size_type node) {
+      if (!terminal_[node]) return true;
+      detail::bytes_to_key(bytes, key);
+      if constexpr (std::is_void<Data>::value) {
+         return static_cast<bool>(f(static_cast<const key_type&>(key)));
+      } else {
+         return static_cast<bool>(f(static_cast<const key_type&>(key), _data(node)));
+      }
+   };
+
+   if (!visit(start)) return false;
+   std::vector<Frame> stack{ { _children(start), bytes.size() } };
+   while (!stack.empty()) {
+      Frame& top = stack.back();
+      if (top.children.first == top.children.last) {
+         stack.pop_back();
+         continue;
+      }
+      size_type node = top.children.first++;
+      bytes.resize(top.depth);
+      bytes.push_back(labels_[node - 1]);
+      if (!visit(node)) return false;
+      stack.push_back({ _children(node), bytes.size() });
+   }
+   return true;
+}
+
+/**
+ * Getters
+ */
+
+template<typename Token, typename Data, typename Traits>
+typename frozen_trie<Token, Data, Traits>::size_type frozen_trie<Token, Data, Traits>::size() const noexcept {
+   return size_;
+}
+
+template<typename Token, typename Data, typename Traits>
+bool frozen_trie<Token, Data, Traits>::empty() const noexcept {
+   return size_ == 0;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename frozen_trie<Token, Data, Traits>::size_type frozen_trie<Token, Data, Traits>::node_count() const noexcept {
+   return terminal_.size();
+}
+
+template<typename Token, typename Data, typename Traits>
+typename frozen_trie<Token, Data, Traits>::size_type frozen_trie<Token, Data, Traits>::memory_usage() const noexcept {
+   size_type bytes = louds_.memory_usage() + terminal_.memory_usage() + labels_.capacity();
+   if constexpr (!std::is_void<Data>::value) bytes += data_.capacity() * sizeof(mapped_type);
+   return bytes;
+}
+
+/**
+ * Navigation
+ */
+
+template<typename Token, typename Data, typename Traits>
+typename frozen_trie<Token, Data, Traits>::Range frozen_trie<Token, Data, Traits>::_children(size_type node) const noexcept {
+   // node's child bits start past its zero; the ones before them are the
+   // nodes numbered below its first child
+   size_type begin = louds_.select0(node) + 1;
+   size_type end = louds_.select0(node + 1);
+   size_type first = begin - node - 1;
+   return { first, first + (end - begin) };
+}
+
+template<typename Token, typename Data, typename Traits>
+typename frozen_trie<Token, Data, Traits>::size_type frozen_trie<Token, Data, Traits>::_child(size_type node, std::uint8_t byte) const noexcept {
+   Range children = _children(node);
+   auto begin = labels_.begin() + static_cast<difference_type>(children.first - 1);
+   auto end = labels_.begin() + static_cast<difference_type>(children.last - 1);
+   auto it = std::lower_bound(begin, end, byte);
+   if (it == end || *it != byte) return NONE;
+   return static_cast<size_type>(it - labels_.begin()) + 1;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename frozen_trie<Token, Data, Traits>::size_type frozen_trie<Token, Data, Traits>::_find_node(const key_type& key) const noexcept {
+   size_type node = 0;
+   size_type n = detail::key_byte_count(key);
+   for (size_type i = 0; i < n && node != NONE; i++) node = _child(node, detail::key_byte(key, i));
+   return node;
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename frozen_trie<Token, Data, Traits>::mapped_type& frozen_trie<Token, Data, Traits>::_data(size_type node) const noexcept {
+   if constexpr (std::is_void<Data>::value) {
+      return data_;
+   } else {
+      return data_[terminal_.rank1(node)];
+   }
+}
+
+/**
+ * trie::freeze
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+frozen_trie<Token, Data, Traits> trie<Token, Data, Traits, Allocator>::freeze() const {
+   return frozen_trie<Token, Data, Traits>(*this);
+}
+
+} // namespace dsacpp
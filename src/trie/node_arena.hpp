@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace dsacpp
+{
+
+/**
+ * Slab arena for the nodes of a linked structure. Blocks are carved off
+ * the front of large slabs in allocation order, so nodes created together
+ * sit together, and a freed block goes onto a free list for its size class
+ * (a multiple of GRANULE) to be handed out again before the slab moves on.
+ * Blocks larger than MAX_SMALL bypass the slabs and come from the
+ * allocator one by one.
+ *
+ * release() returns every slab and large block to the allocator at once,
+ * without looking at what lives in them: objects that need destroying
+ * must be destroyed first. Not thread-safe.
+ */
+template<typename Allocator = std::allocator<std::max_align_t>>
+class node_arena {
+   // every block is a whole number of units, aligned for any scalar
+   using unit = std::max_align_t;
+
+   using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using allocator_type = Allocator;
+   using size_type      = std::size_t;
+
+   static constexpr size_type GRANULE = sizeof(unit);
+   static constexpr size_type SLAB_SIZE = 64 * 1024;
+   static constexpr size_type MAX_SMALL = 4096;
+
+   /**
+    * Constructors
+    */
+
+   explicit node_arena(const allocator_type& alloc = Allocator()) noexcept;
+
+   node_arena(const node_arena&) = delete;
+   node_arena& operator=(const node_arena&) = delete;
+
+   node_arena(node_arena&& other) noexcept;
+
+   ~node_arena() noexcept;
+
+   /**
+    * Blocks
+    */
+
+   // aligned for any scalar type
+   void* allocate(size_type bytes);
+
+   // bytes must be what the block was allocated with
+   void deallocate(void* block, size_type bytes) noexcept;
+
+   // give back every slab and large block
+   void release() noexcept;
+
+   // take over every block of other, whose allocator must compare equal
+   void merge(node_arena& other) noexcept;
+
+   /**
+    * Getters
+    */
+
+   // bytes held in slabs and large blocks
+   size_type reserved() const noexcept;
+
+   allocator_type get_allocator() const noexcept;
+
+   void swap(node_arena& other) noexcept;
+
+private:
+
+   static constexpr size_type SLAB_UNITS = SLAB_SIZE / GRANULE;
+   static constexpr size_type SMALL_UNITS = MAX_SMALL / GRANULE;
+
+   // first units of every slab, linking it to the previous one
+   struct Slab {
+      Slab* next;
+   };
+
+   // first units of every large block, linking it among the others
+   struct Large {
+      Large* prev;
+      Large* next;
+      size_type units;
+   };
+
+   // what a free block holds while on its free list
+   struct Free {
+      Free* next;
+   };
+
+   static constexpr size_type SLAB_HEADER = (sizeof(Slab) + GRANULE - 1) / GRANULE;
+   static constexpr size_type LARGE_HEADER = (sizeof(Large) + GRANULE - 1) / GRANULE;
+
+   static_assert(SMALL_UNITS + SLAB_HEADER <= SLAB_UNITS, "a slab must fit the largest small block");
+
+   [[no_unique_address]] allocator_type alloc_;
+   Slab* slabs_ = nullptr;
+   Large* large_ = nullptr;
+   // the untouched part of the newest slab
+   unit* cursor_ = nullptr;
+   unit* end_ = nullptr;
+   // free_[n - 1] lists the free blocks of n units; allocated with the first slab
+   Free** free_ = nullptr;
+   size_type reserved_ = 0;
+
+   static size_type _units(size_type bytes) noexcept;
+
+   unit* _allocate_units(size_type units);
+   void _deallocate_units(unit* block, size_type units) noexcept;
+
+   Free** _allocate_table();
+   void _deallocate_table(Free** table) noexcept;
+
+   void _push_free(unit* block, size_type units) noexcept;
+
+   // put what is left of a slab on the free lists, in blocks no larger than MAX_SMALL
+   void _push_rest(unit* begin, unit* end) noexcept;
+
+   void _new_slab();
+
+   void* _allocate_large(size_type units);
+   void _deallocate_large(void* block, size_type units) noexcept;
+};
+
+template<typename Allocator>
+node_arena<Allocator>::node_arena(const allocator_type& alloc) noexcept :
+   alloc_{ alloc }
+{ }
+
+template<typename Allocator>
+node_arena<Allocator>::node_arena(node_arena&& other) noexcept :
+   alloc_{ std::move(other.alloc_) },
+   slabs_{ other.slabs_ },
+   large_{ other.large_ },
+   cursor_{ other.cursor_ },
+   end_{ other.end_ },
+   free_{ other.free_ },
+   reserved_{ other.reserved_ }
+{
+   other.slabs_ = nullptr;
+   other.large_ = nullptr;
+   other.cursor_ = nullptr;
+   other.end_ = nullptr;
+   other.free_ = nullptr;
+   other.reserved_ = 0;
+}
+
+template<typename Allocator>
+node_arena<Allocator>::~node_arena() noexcept {
+   release();
+}
+
+/**
+ * Blocks
+ */
+
+template<typename Allocator>
+void* node_arena<Allocator>::allocate(size_type bytes) {
+   size_type units = _units(bytes);
+   if (units > SMALL_UNITS) return _allocate_large(units);
+   if (free_ && free_[units - 1]) {
+      Free* block = free_[units - 1];
+      free_[units - 1] = block->next;
+      return block;
+   }
+   if (static_cast<size_type>(end_ - cursor_) < units) _new_slab();
+   unit* block = cursor_;
+   cursor_ += units;
+   return block;
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::deallocate(void* block, size_type bytes) noexcept {
+   size_type units = _units(bytes);
+   if (units > SMALL_UNITS) {
+      _deallocate_large(block, units);
+   } else {
+      _push_free(static_cast<unit*>(block), units);
+   }
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::release() noexcept {
+   while (slabs_) {
+      Slab* next = slabs_->next;
+      _deallocate_units(reinterpret_cast<unit*>(slabs_), SLAB_UNITS);
+      slabs_ = next;
+   }
+   while (large_) {
+      Large* next = large_->next;
+      _deallocate_units(reinterpret_cast<unit*>(large_), large_->units);
+      large_ = next;
+   }
+   if (free_) _deallocate_table(free_);
+   cursor_ = nullptr;
+   end_ = nullptr;
+   free_ = nullptr;
+   reserved_ = 0;
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::merge(node_arena& other) noexcept {
+   if (other.slabs_) {
+      Slab* last = other.slabs_;
+      while (last->next) last = last->next;
+      last->next = slabs_;
+      slabs_ = other.slabs_;
+   }
+   if (other.large_) {
+      Large* last = other.large_;
+      while (last->next) last = last->next;
+      last->next = large_;
+      if (large_) large_->prev = last;
+      large_ = other.large_;
+   }
+   if (!free_) {
+      free_ = other.free_;
+   } else if (other.free_) {
+      for (size_type i = 0; i < SMALL_UNITS; i++) {
+         while (Free* block = other.free_[i]) {
+            other.free_[i] = block->next;
+            block->next = free_[i];
+            free_[i] = block;
+         }
+      }
+      _deallocate_table(other.free_);
+   }
+   // only slabs come with a table, so free_ is set if there is a rest
+   _push_rest(other.cursor_, other.end_);
+   reserved_ += other.reserved_;
+   other.slabs_ = nullptr;
+   other.large_ = nullptr;
+   other.cursor_ = nullptr;
+   other.end_ = nullptr;
+   other.free_ = nullptr;
+   other.reserved_ = 0;
+}
+
+/**
+ * Getters
+ */
+
+template<typename Allocator>
+typename node_arena<Allocator>::size_type node_arena<Allocator>::reserved() const noexcept {
+   return reserved_;
+}
+
+template<typename Allocator>
+typename node_arena<Allocator>::allocator_type node_arena<Allocator>::get_allocator() const noexcept {
+   return alloc_;
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::swap(node_arena& other) noexcept {
+   std::swap(alloc_, other.alloc_);
+   std::swap(slabs_, other.slabs_);
+   std::swap(large_, other.large_);
+   std::swap(cursor_, other.cursor_);
+   std::swap(end_, other.end_);
+   std::swap(free_, other.free_);
+   std::swap(reserved_, other.reserved_);
+}
+
+template<typename Allocator>
+typename node_arena<Allocator>::size_type node_arena<Allocator>::_units(size_type bytes) noexcept {
+   return bytes == 0 ? 1 : (bytes + GRANULE - 1) / GRANULE;
+}
+
+template<typename Allocator>
+typename node_arena<Allocator>::unit* node_arena<Allocator>::_allocate_units(size_type units) {
+   using unit_allocator = typename alloc_traits::template rebind_alloc<unit>;
+   unit_allocator alloc(alloc_);
+   return std::allocator_traits<unit_allocator>::allocate(alloc, units);
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::_deallocate_units(unit* block, size_type units) noexcept {
+   using unit_allocator = typename alloc_traits::template rebind_alloc<unit>;
+   unit_allocator alloc(alloc_);
+   std::allocator_traits<unit_allocator>::deallocate(alloc, block, units);
+}
+
+template<typename Allocator>
+typename node_arena<Allocator>::Free** node_arena<Allocator>::_allocate_table() {
+   using table_allocator = typename alloc_traits::template rebind_alloc<Free*>;
+   table_allocator alloc(alloc_);
+   return std::allocator_traits<table_allocator>::allocate(alloc, SMALL_UNITS);
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::_deallocate_table(Free** table) noexcept {
+   using table_allocator = typename alloc_traits::template rebind_alloc<Free*>;
+   table_allocator alloc(alloc_);
+   std::allocator_traits<table_allocator>::deallocate(alloc, table, SMALL_UNITS);
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::_push_free(unit* block, size_type units) noexcept {
+   Free* free = new (block) Free{ free_[units - 1] };
+   free_[units - 1] = free;
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::_push_rest(unit* begin, unit* end) noexcept {
+   while (begin != end) {
+      size_type units = std::min(static_cast<size_type>(end - begin), SMALL_UNITS);
+      _push_free(begin, units);
+      begin += units;
+   }
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::_new_slab() {
+   if (!free_) {
+      free_ = _allocate_table();
+      for (size_type i = 0; i < SMALL_UNITS; i++) free_[i] = nullptr;
+   }
+   unit* slab = _allocate_units(SLAB_UNITS);
+   reserved_ += SLAB_SIZE;
+   // what is left of the old slab is still good for smaller blocks
+   _push_rest(cursor_, end_);
+   slabs_ = new (slab) Slab{ slabs_ };
+   cursor_ = slab + SLAB_HEADER;
+   end_ = slab + SLAB_UNITS;
+}
+
+template<typename Allocator>
+void* node_arena<Allocator>::_allocate_large(size_type units) {
+   unit* block = _allocate_units(LARGE_HEADER + units);
+   reserved_ += (LARGE_HEADER + units) * GRANULE;
+   Large* large = new (block) Large{ nullptr, large_, LARGE_HEADER + units };
+   if (large_) large_->prev = large;
+   large_ = large;
+   return block + LARGE_HEADER;
+}
+
+template<typename Allocator>
+void node_arena<Allocator>::_deallocate_large(void* block, size_type units) noexcept {
+   unit* start = static_cast<unit*>(block) - LARGE_HEADER;
+   Large* large = reinterpret_cast<Large*>(start);
+   if (large->prev) large->prev->next = large->next;
+   else large_ = large->next;
+   if (large->next) large->next->prev = large->prev;
+   _deallocate_units(start, LARGE_HEADER + units);
+   reserved_ -= (LARGE_HEADER + units) * GRANULE;
+}
+
+} // namespace dsacpp
@@ -1,14 +1,100 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <new>
+#include <queue>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
-#include <map>
+#include <utility>
+#include <vector>
+
+#include "detail/key_bytes.hpp"
+#include "node_arena.hpp"
+#include "../thread_pool/thread_pool.hpp"
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define DSACPP_TRIE_SSE2 1
+#endif
 
 namespace dsacpp
 {
 
+/**
+ * Stands in for the data of a trie whose Data is void, so that the trie
+ * works as a set: insert(key) and find(key) need no payload.
+ */
+struct trie_no_data { };
+
+template<typename Token, typename Data, typename Traits>
+class frozen_trie;
+
+template<typename Token, typename Data, typename Traits>
+class trie_view;
+
+template<typename Token, typename Data, typename Traits>
+class double_array_trie;
+
+/**
+ * Ordered map (or set, with Data = void) from token strings, laid out as
+ * a path-compressed adaptive radix tree. Keys are walked a byte at a time:
+ * each token contributes its unsigned value, most significant byte first,
+ * so byte order and token order agree.
+ *
+ * Each node carries the label of the edge into it as a byte span, so a
+ * run of single-child nodes collapses into one node and a key's unshared
+ * suffix sits in the node holding its data. Insert splits a label where a
+ * new key leaves it; erase merges a node left with one child and no data
+ * into that child. Every node but the root therefore holds data or
+ * branches at least two ways.
+ *
+ * A node branches on the byte after its label and takes the smallest of
+ * four layouts that fits its fanout:
+ *    - Node4 and Node16: sorted key bytes beside the child pointers;
+ *      Node16 is searched with one SSE2 compare where available
+ *    - Node48: a 256-entry byte index into 48 child slots
+ *    - Node256: a child pointer per byte value
+ * Nodes grow into the next layout when they fill up and shrink back when
+ * erase leaves them sparse.
+ *
+ * Nodes, labels and data all live in a node_arena owned by the trie, so a
+ * trie built in one go is laid out in roughly insertion order and erased
+ * nodes are reused by later inserts. clear() and the destructor hand the
+ * arena's slabs back wholesale; they only walk the tree when Data needs
+ * its destructor run.
+ *
+ * For arithmetic Data every node also records the largest data in its
+ * subtree, kept exact by insert, insert_or_assign and erase, so top_k and
+ * for_each_best visit the keys under a prefix best first and only open the
+ * subtrees that can still beat what they have found. To keep them exact,
+ * at() and iterators give such data out read-only, and operator[] returns
+ * a score_reference that assigns through insert_or_assign.
+ *
+ * Constructing from a range sorted in key order builds the tree bottom-up
+ * in one pass, each node created at its final layout and never searched;
+ * the thread_pool overload also splits the range by the first byte past
+ * the common prefix and builds the parts in parallel.
+ *
+ * freeze() copies the trie into a frozen_trie, a read-only LOUDS encoding
+ * of a few bits per node plus labels and data. compile() copies it into a
+ * double_array_trie, which spends more memory to take each byte of a key
+ * in two array reads.
+ * save() in trie_view.hpp writes it out as a flat image that trie_view
+ * maps and queries in place.
+ *
+ * Iterators are forward iterators in key order. They rebuild the key as
+ * they go, so for a map *it is a pair of references, to the iterator's key
+ * and to the stored data (const for arithmetic data), and the key
+ * reference lasts until the iterator moves. Traits is kept for the key type only; ordering always follows the
+ * tokens' unsigned values.
+ */
 template<
    typename Token,
    typename Data        = void,
@@ -16,6 +102,23 @@ template<
    typename Allocator   = std::allocator<Data>
 >
 class trie {
+   // whether nodes record the largest data below them
+   static constexpr bool SCORED = std::is_arithmetic<Data>::value;
+
+   template<bool Const>
+   class basic_iterator;
+
+   class score_reference;
+
+   template<typename, typename, typename>
+   friend class frozen_trie;
+
+   template<typename, typename, typename>
+   friend class trie_view;
+
+   template<typename, typename, typename>
+   friend class double_array_trie;
+
 public:
 
    /**
@@ -25,26 +128,28 @@ public:
    using token_type        = Token;
    using key_type          = std::basic_string<Token, Traits>;
    using data_type         = Data;
+   using mapped_type       = std::conditional_t<std::is_void<Data>::value, trie_no_data, Data>;
    using traits_type       = Traits;
    using allocator_type    = Allocator;
    using size_type         = size_t;
    using difference_type   = std::ptrdiff_t;
-   
+
    using value_type        = std::conditional_t<
       std::is_void<data_type>::value,
       key_type,
       std::pair<const key_type, data_type>
    >;
 
+   using iterator          = basic_iterator<false>;
+   using const_iterator    = basic_iterator<true>;
 
-   class iterator {
-
-   };
+   // what at(), operator[] and iterators hand out; arithmetic data is
+   // read-only there and assigned through score_reference
+   using mapped_reference  = std::conditional_t<SCORED, const mapped_type&, mapped_type&>;
+   using subscript_type    = std::conditional_t<SCORED, score_reference, mapped_type&>;
 
-   class const_iterator {
+   static_assert(std::is_integral<Token>::value, "trie tokens must be integral");
 
-   };
-   
    /*
     * Constructors
    */
@@ -53,8 +158,10 @@ public:
 
    trie(const trie& other);
 
-   trie(trie&& other);
+   trie(trie&& other) noexcept;
 
+   // a sorted range is built in one pass; from the first key out of order
+   // on, the rest of the range is inserted key by key
    // SNIFAE
    template<
       typename iter,
@@ -67,12 +174,26 @@ public:
    >
    trie(iter begin, iter end, const allocator_type& alloc = Allocator());
 
+   // as above, building the subtrees under the root on pool; a range not
+   // sorted by its first distinguishing byte is built sequentially
+   // SNIFAE
+   template<
+      typename iter,
+      typename = std::enable_if_t<
+                  std::is_base_of<
+                  std::random_access_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value
+      >
+   >
+   trie(thread_pool& pool, iter begin, iter end, const allocator_type& alloc = Allocator());
+
    ~trie() noexcept;
 
    /**
     * Iterators
     */
-   
+
    iterator begin() noexcept;
    const_iterator begin() const noexcept;
    iterator end() noexcept;
@@ -81,72 +202,1713 @@ public:
    /**
     * Modifiers
     */
-   std::pair<iterator, bool> insert(const key_type& key, const data_type& data);
+
+   // leaves an existing key's data untouched, like std::map::insert
+   std::pair<iterator, bool> insert(const key_type& key, const mapped_type& data = mapped_type());
+
+   // overwrites an existing key's data; true if the key was inserted
+   std::pair<iterator, bool> insert_or_assign(const key_type& key, const mapped_type& data);
 
    iterator find(const key_type& key);
    const_iterator find(const key_type& key) const;
 
    size_type erase(const key_type& key);
 
-   data_type& at(const key_type& key);
+   mapped_reference at(const key_type& key);
+   const mapped_type& at(const key_type& key) const;
 
    /**
     * Prefix operations
     */
-   
+
+   // first key not less than prefix, i.e. the first key starting with it if any
    iterator lower_bound(const key_type& prefix);
+   const_iterator lower_bound(const key_type& prefix) const;
 
+   // first key greater than every key starting with prefix
    iterator upper_bound(const key_type& prefix);
+   const_iterator upper_bound(const key_type& prefix) const;
 
+   // every key starting with prefix
    std::pair<iterator, iterator> equal_range(const key_type& prefix);
+   std::pair<const_iterator, const_iterator> equal_range(const key_type& prefix) const;
+
+   // f(key) for a set, f(key, data) for a map, over the keys starting with
+   // prefix in key order, until f returns false; true if it saw them all
+   template<typename F>
+   bool for_each_prefix(const key_type& prefix, F f) const;
+
+   // f(key, data) over the keys starting with prefix, largest data first
+   // (ties in no particular order), until f returns false; true if it saw
+   // them all. Needs arithmetic data.
+   template<typename F>
+   bool for_each_best(const key_type& prefix, F f) const;
+
+   // the k keys starting with prefix with the largest data, largest first
+   std::vector<std::pair<key_type, mapped_type>> top_k(const key_type& prefix, size_type k) const;
 
    /**
     * Getters
     */
-   
+
    size_type size() const noexcept;
    bool empty() const noexcept;
    void clear() noexcept;
 
+   // immutable succinct copy for lookups and prefix scans (frozen_trie.hpp)
+   frozen_trie<Token, Data, Traits> freeze() const;
+
+   // immutable double-array copy for exact and prefix matching (double_array_trie.hpp)
+   double_array_trie<Token, Data, Traits> compile() const;
+
    /**
     * Operators
     */
-   
-   data_type& operator[](const key_type& key);
+
+   subscript_type operator[](const key_type& key);
 
    trie& operator=(const trie& other);
 
-   trie& operator=(trie&& other);
+   trie& operator=(trie&& other) noexcept;
+
+   void swap(trie& other) noexcept;
 
 private:
 
+   using unsigned_token = std::make_unsigned_t<Token>;
+
+   static constexpr size_type TOKEN_BYTES = sizeof(Token);
+
+   enum node_kind : std::uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+   struct no_score { };
+
+   using score_type = std::conditional_t<SCORED, mapped_type, no_score>;
+
+   struct Leaf {
+      mapped_type data;
+   };
+
+   // header shared by every node
    struct Node {
-      std::conditional_t<
-         std::is_void<data_type>::value,
-         bool,
-         data_type
-      > data_or_flag;
-      bool is_terminal = std::is_void<data_type>::value;
-      std::map<token_type, Node*> children;
+      node_kind kind;
+      std::uint16_t count = 0;
+      // label of the edge into this node, after the parent's branch byte
+      std::uint32_t prefix_len = 0;
+      std::uint8_t* prefix = nullptr;
+      // data of the key that ends at this node, if any
+      Leaf* value = nullptr;
+      // largest data in this node's subtree, value included
+      [[no_unique_address]] score_type best{};
 
-      Node(const allocator_type& alloc);
+      explicit Node(node_kind k) noexcept : kind{ k } { }
+   };
+
+   struct Node4 : Node {
+      std::uint8_t keys[4] = {};
+      Node* children[4] = {};
+
+      Node4() noexcept : Node(NODE4) { }
+   };
+
+   struct Node16 : Node {
+      std::uint8_t keys[16] = {};
+      Node* children[16] = {};
+
+      Node16() noexcept : Node(NODE16) { }
+   };
 
-      ~Node() noexcept;
+   struct Node48 : Node {
+      // slot + 1 of each byte's child, 0 for none
+      std::uint8_t index[256] = {};
+      Node* children[48] = {};
+
+      Node48() noexcept : Node(NODE48) { }
+   };
+
+   struct Node256 : Node {
+      Node* children[256] = {};
+
+      Node256() noexcept : Node(NODE256) { }
    };
 
-   using node_allocator_type = typename std::allocator_traits<allocator_type>::
-      template rebind_alloc<Node>;
-   
+   // a step of an iterator's path: the node, the position of the child it
+   // went down into (see _next_child) and the key length in bytes at node
+   struct Frame {
+      Node* node;
+      int pos;
+      size_type depth;
+   };
+
+   // shrink a node once erase leaves it with this many children
+   static constexpr std::uint16_t NODE16_SHRINK = 3;
+   static constexpr std::uint16_t NODE48_SHRINK = 12;
+   static constexpr std::uint16_t NODE256_SHRINK = 40;
+
+   using alloc_traits = std::allocator_traits<allocator_type>;
+   using arena_type = node_arena<allocator_type>;
+
+   static_assert(alignof(Leaf) <= arena_type::GRANULE, "over-aligned trie data is not supported");
+
    Node* root_ = nullptr;
    size_type size_ = 0;
-   allocator_type alloc_;
-   node_allocator_type node_alloc_;
+   arena_type arena_;
+
+   /**
+    * Node management
+    */
+
+   template<typename N>
+   N* _create_node();
+
+   template<typename N>
+   void _free_node(N* node) noexcept;
+
+   // frees the node and its label, not its children or data
+   void _destroy_node(Node* node) noexcept;
+
+   std::uint8_t* _allocate_prefix(size_type len);
+   void _free_prefix(std::uint8_t* prefix, size_type len) noexcept;
+
+   // node labelled with key's bytes from position from on, holding data
+   Node* _create_tail(const key_type& key, size_type from, const mapped_type& data);
+
+   // how many bytes of node's label match key from position from on
+   static size_type _match_prefix(const Node* node, const key_type& key, size_type from) noexcept;
+
+   // insert data for key under a new node that takes the first matched
+   // bytes of node's label; key continues, or ends, at byte from
+   void _split(Node*& node, size_type matched, const key_type& key, size_type from, const mapped_type& data);
+
+   // fold a node without data and with a single child into that child
+   void _merge(Node*& node) noexcept;
+
+   Leaf* _create_leaf(const mapped_type& data);
+   void _destroy_leaf(Leaf* leaf) noexcept;
+
+   // slot holding the child for byte, or null
+   static Node** _find_child(Node* node, std::uint8_t byte) noexcept;
+
+   // add a child under a byte node does not have yet, growing node if full
+   void _add_child(Node*& node, std::uint8_t byte, Node* child);
+
+   // drop the child under byte, shrinking node if it got sparse
+   void _remove_child(Node*& node, std::uint8_t byte) noexcept;
+
+   template<typename From, typename To>
+   void _copy_children(const From* from, To* to) noexcept;
+
+   // the next child after position pos in key order; positions are array
+   // indices in Node4/16, byte values in Node48/256, and -1 before the first
+   static bool _next_child(const Node* node, int& pos, std::uint8_t& byte, Node*& child) noexcept;
+
+   // position just before the first child whose byte is not less than byte
+   static int _position_before(const Node* node, std::uint8_t byte) noexcept;
+
+   Node* _find_node(const key_type& key) const noexcept;
+
+   Node* _clone(const Node* node);
+
+   // hand node's subtree back to the arena's free lists
+   void _clear_node(Node* node) noexcept;
+
+   // run the destructor of every data under node, freeing nothing
+   void _destroy_data(Node* node) noexcept;
+
+   // the slots holding the nodes on key's path, root first; false if key
+   // is not in the trie
+   bool _find_path(const key_type& key, std::vector<Node**>& refs) const;
+
+   /**
+    * Scores
+    */
+
+   // a node reached by for_each_best, through byte from steps[parent]
+   struct Step {
+      Node* node;
+      size_type parent;
+      std::uint8_t byte;
+   };
 
-   Node* _create_node();
-   void _destroy_node();
+   // a subtree to open, or with exact set the data at the step's node
+   struct Candidate {
+      mapped_type score;
+      size_type step;
+      bool exact;
 
-   Node* _find_node(const key_type& key);
-   void _clear_node(Node* node);
+      // the queue's top is the largest score, exact data before subtrees
+      bool operator<(const Candidate& other) const noexcept {
+         return score < other.score || (score == other.score && !exact && other.exact);
+      }
+   };
+
+   // raise the scores along key's path to data
+   void _raise(const key_type& key, const mapped_type& data) noexcept;
+
+   // recompute node's score from its data and children; true if it changed
+   static bool _rescore(Node* node) noexcept;
+
+   // recompute the scores of the nodes in refs[0, count), bottom up; the
+   // last one may be a different node than before
+   static void _rescore_path(Node** const* refs, size_type count) noexcept;
+
+   // the key spelled by the steps from the root to steps[step]
+   static void _spell(const std::vector<Step>& steps, size_type step, key_type& key);
+
+   /**
+    * Bulk build
+    */
+
+   // a node on the path to the last key built that may still gain children:
+   // its label ends at key byte depth, and its children so far are the
+   // tail of the child list from first on
+   struct Pending {
+      size_type depth;
+      Leaf* value;
+      size_type first;
+   };
+
+   using child_list = std::vector<std::pair<std::uint8_t, Node*>>;
+
+   template<typename V>
+   static decltype(auto) _key_of(const V& value) noexcept;
+
+   template<typename V>
+   static decltype(auto) _data_of(const V& value);
+
+   static size_type _common_prefix(const key_type& a, const key_type& b) noexcept;
+
+   // build an empty trie from [begin, end), whatever its order
+   template<typename It>
+   void _assign(It begin, It end);
+
+   // build an empty trie from the sorted run at the front of [begin, end),
+   // leaving begin at the first key out of order
+   template<typename It>
+   void _build(It& begin, It end);
+
+   // create pending's node, labelled with key's bytes from start on and
+   // taking its children off the end of children; leaves room there for
+   // the caller to add the node without allocating
+   Node* _close(const Pending& pending, size_type start, const key_type& key, child_list& children);
+
+   // build an empty trie from [begin, end) on pool; false, with the trie
+   // still empty, if the range is not split up by its first distinguishing
+   // byte the way a sorted one is
+   template<typename It>
+   bool _build_parallel(thread_pool& pool, It begin, It end);
+
+   // position it at key, or just past the keys starting with it
+   template<typename It>
+   void _seek(It& it, const key_type& key, bool past_prefix) const;
 };
 
-}
\ No newline at end of file
+/**
+ * Forward iterator over a trie in key order. It keeps the path from the
+ * root as a stack of (node, child position) frames plus the key spelled
+ * by that path.
+ */
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<bool Const>
+class trie<Token, Data, Traits, Allocator>::basic_iterator {
+public:
+   using mapped_reference  = std::conditional_t<Const || SCORED, const mapped_type&, mapped_type&>;
+   using pair_reference    = std::pair<const key_type&, mapped_reference>;
+
+   // what operator-> returns for a map: the pair, held by value
+   struct arrow_proxy {
+      pair_reference ref;
+      const pair_reference* operator->() const noexcept { return &ref; }
+   };
+
+   using value_type        = typename trie::value_type;
+   using reference         = std::conditional_t<std::is_void<Data>::value, const key_type&, pair_reference>;
+   using pointer           = std::conditional_t<std::is_void<Data>::value, const key_type*, arrow_proxy>;
+   using difference_type   = std::ptrdiff_t;
+   using iterator_category = std::forward_iterator_tag;
+
+   basic_iterator() = default;
+
+   // iterator to const_iterator
+   template<bool C, typename = std::enable_if_t<Const && !C>>
+   basic_iterator(const basic_iterator<C>& other) :
+      stack_{ other.stack_ }, key_{ other.key_ }, depth_{ other.depth_ } { }
+
+   // dereference and pointer access
+   reference operator*() const {
+      if constexpr (std::is_void<Data>::value) {
+         return key_;
+      } else {
+         return reference{ key_, stack_.back().node->value->data };
+      }
+   }
+
+   pointer operator->() const {
+      if constexpr (std::is_void<Data>::value) {
+         return &key_;
+      } else {
+         return arrow_proxy{ **this };
+      }
+   }
+
+   // increment
+   basic_iterator& operator++() { _advance(); return *this; }
+   basic_iterator operator++(int) { auto tmp = *this; _advance(); return tmp; }
+
+   // comparisons; the node a key ends at identifies the key
+   bool operator==(const basic_iterator& other) const noexcept {
+      return stack_.empty() ? other.stack_.empty()
+                            : !other.stack_.empty() && stack_.back().node == other.stack_.back().node;
+   }
+   bool operator!=(const basic_iterator& other) const noexcept { return !(*this == other); }
+
+private:
+   friend class trie;
+
+   template<bool C>
+   friend class basic_iterator;
+
+   std::vector<Frame> stack_;
+   key_type key_;
+   // length of key_ in bytes
+   size_type depth_ = 0;
+
+   void _push_byte(std::uint8_t byte) {
+      size_type shift = 8 * (TOKEN_BYTES - 1 - depth_ % TOKEN_BYTES);
+      unsigned_token bits = static_cast<unsigned_token>(static_cast<unsigned_token>(byte) << shift);
+      if (depth_ % TOKEN_BYTES == 0) {
+         key_.push_back(static_cast<Token>(bits));
+      } else {
+         key_.back() = static_cast<Token>(static_cast<unsigned_token>(key_.back()) | bits);
+      }
+      depth_++;
+   }
+
+   void _pop_byte() noexcept {
+      depth_--;
+      size_type shift = 8 * (TOKEN_BYTES - 1 - depth_ % TOKEN_BYTES);
+      if (depth_ % TOKEN_BYTES == 0) {
+         key_.pop_back();
+      } else {
+         unsigned_token mask = static_cast<unsigned_token>(static_cast<unsigned_token>(0xff) << shift);
+         key_.back() = static_cast<Token>(static_cast<unsigned_token>(key_.back()) & static_cast<unsigned_token>(~mask));
+      }
+   }
+
+   // enter node, through byte unless it is the root, extending the key by
+   // the byte and the node's label
+   void _enter(Node* node, const std::uint8_t* byte) {
+      if (byte) _push_byte(*byte);
+      for (std::uint32_t i = 0; i < node->prefix_len; i++) _push_byte(node->prefix[i]);
+      stack_.push_back(Frame{ node, -1, depth_ });
+   }
+
+   void _pop() noexcept {
+      stack_.pop_back();
+      size_type depth = stack_.empty() ? 0 : stack_.back().depth;
+      while (depth_ > depth) _pop_byte();
+   }
+
+   // move to the next node holding data, or to end
+   void _advance() {
+      while (!stack_.empty()) {
+         Frame& top = stack_.back();
+         std::uint8_t byte;
+         Node* child;
+         if (trie::_next_child(top.node, top.pos, byte, child)) {
+            _enter(child, &byte);
+            if (child->value) return;
+         } else {
+            _pop();
+         }
+      }
+   }
+};
+
+/**
+ * What operator[] returns for arithmetic data. It reads as the data and
+ * writes through insert_or_assign, so the scores above the key follow
+ * every change. It holds its own copy of the key.
+ */
+template<typename Token, typename Data, typename Traits, typename Allocator>
+class trie<Token, Data, Traits, Allocator>::score_reference {
+public:
+   score_reference(const score_reference&) = default;
+
+   operator const mapped_type&() const noexcept { return *data_; }
+
+   score_reference& operator=(const mapped_type& data) {
+      // a key erased meanwhile comes back in a new leaf
+      if (trie_->insert_or_assign(key_, data).second) data_ = &trie_->_find_node(key_)->value->data;
+      return *this;
+   }
+
+   // assigns the data, as t[a] = t[b] should
+   score_reference& operator=(const score_reference& other) {
+      return *this = static_cast<const mapped_type&>(other);
+   }
+
+   score_reference& operator+=(const mapped_type& d) { return *this = static_cast<mapped_type>(*data_ + d); }
+   score_reference& operator-=(const mapped_type& d) { return *this = static_cast<mapped_type>(*data_ - d); }
+   score_reference& operator++() { return *this += mapped_type(1); }
+   score_reference& operator--() { return *this -= mapped_type(1); }
+
+private:
+   friend class trie;
+
+   score_reference(trie* t, const key_type& key, mapped_type* data) :
+      trie_{ t }, key_{ key }, data_{ data } { }
+
+   trie* trie_;
+   key_type key_;
+   mapped_type* data_;
+};
+
+/**
+ * Constructors
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+trie<Token, Data, Traits, Allocator>::trie(const allocator_type& alloc) noexcept :
+   arena_{ alloc }
+{ }
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+trie<Token, Data, Traits, Allocator>::trie(const trie& other) :
+   size_{ other.size_ },
+   arena_{ alloc_traits::select_on_container_copy_construction(other.arena_.get_allocator()) }
+{
+   if (other.root_) root_ = _clone(other.root_);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+trie<Token, Data, Traits, Allocator>::trie(trie&& other) noexcept :
+   root_{ other.root_ },
+   size_{ other.size_ },
+   arena_{ std::move(other.arena_) }
+{
+   other.root_ = nullptr;
+   other.size_ = 0;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename iter, typename>
+trie<Token, Data, Traits, Allocator>::trie(iter begin, iter end, const allocator_type& alloc) :
+   arena_{ alloc }
+{ _assign(begin, end); }
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename iter, typename>
+trie<Token, Data, Traits, Allocator>::trie(thread_pool& pool, iter begin, iter end, const allocator_type& alloc) :
+   arena_{ alloc }
+{
+   if (!_build_parallel(pool, begin, end)) _assign(begin, end);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+trie<Token, Data, Traits, Allocator>::~trie() noexcept {
+   clear();
+}
+
+/**
+ * Iterators
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::iterator trie<Token, Data, Traits, Allocator>::begin() noexcept {
+   iterator it;
+   if (root_) {
+      it._enter(root_, nullptr);
+      if (!root_->value) it._advance();
+   }
+   return it;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::const_iterator trie<Token, Data, Traits, Allocator>::begin() const noexcept {
+   return const_cast<trie*>(this)->begin();
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::iterator trie<Token, Data, Traits, Allocator>::end() noexcept {
+   return iterator{};
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::const_iterator trie<Token, Data, Traits, Allocator>::end() const noexcept {
+   return const_iterator{};
+}
+
+/**
+ * Modifiers
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::pair<typename trie<Token, Data, Traits, Allocator>::iterator, bool>
+trie<Token, Data, Traits, Allocator>::insert(const key_type& key, const mapped_type& data) {
+   size_type n = detail::key_byte_count(key);
+   Node** ref = &root_;
+   size_type i = 0;
+   // every new node is fully built before it is linked in
+   while (*ref) {
+      Node* node = *ref;
+      size_type matched = _match_prefix(node, key, i);
+      if (matched < node->prefix_len) {
+         _split(*ref, matched, key, i + matched, data);
+         break;
+      }
+      i += matched;
+      if (i == n) {
+         if (node->value) return { find(key), false };
+         node->value = _create_leaf(data);
+         break;
+      }
+      std::uint8_t byte = detail::key_byte(key, i);
+      Node** child = _find_child(node, byte);
+      if (!child) {
+         Node* tail = _create_tail(key, i + 1, data);
+         try {
+            _add_child(*ref, byte, tail);
+         } catch (...) {
+            _clear_node(tail);
+            throw;
+         }
+         break;
+      }
+      ref = child;
+      i++;
+   }
+   if (!*ref) *ref = _create_tail(key, 0, data);
+   size_++;
+   if constexpr (SCORED) _raise(key, data);
+   return { find(key), true };
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::pair<typename trie<Token, Data, Traits, Allocator>::iterator, bool>
+trie<Token, Data, Traits, Allocator>::insert_or_assign(const key_type& key, const mapped_type& data) {
+   std::vector<Node**> refs;
+   if (!_find_path(key, refs)) return insert(key, data);
+   (*refs.back())->value->data = data;
+   if constexpr (SCORED) _rescore_path(refs.data(), refs.size());
+   return { find(key), false };
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::iterator trie<Token, Data, Traits, Allocator>::find(const key_type& key) {
+   Node* node = _find_node(key);
+   if (!node || !node->value) return iterator{};
+   iterator it;
+   _seek(it, key, false);
+   return it;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::const_iterator trie<Token, Data, Traits, Allocator>::find(const key_type& key) const {
+   return const_cast<trie*>(this)->find(key);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::size_type trie<Token, Data, Traits, Allocator>::erase(const key_type& key) {
+   std::vector<Node**> refs;
+   if (!_find_path(key, refs)) return 0;
+   Node* node = *refs.back();
+   _destroy_leaf(node->value);
+   node->value = nullptr;
+   size_--;
+
+   // the slots in refs[0, path) still hold the nodes on the path
+   size_type path = refs.size();
+   Node** ref = refs.back();
+   if (node->count == 0) {
+      if (path == 1) {
+         _destroy_node(node);
+         root_ = nullptr;
+         return 1;
+      }
+      std::uint8_t byte = detail::key_byte(key, detail::key_byte_count(key) - node->prefix_len - 1);
+      _destroy_node(node);
+      ref = refs[--path - 1];
+      _remove_child(*ref, byte);
+      node = *ref;
+      if (node->count == 0 && !node->value) {
+         // only the root may get here
+         _destroy_node(node);
+         root_ = nullptr;
+         return 1;
+      }
+   }
+   if (node->count == 1 && !node->value) _merge(*ref);
+   if constexpr (SCORED) _rescore_path(refs.data(), path);
+   return 1;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::mapped_reference trie<Token, Data, Traits, Allocator>::at(const key_type& key) {
+   Node* node = _find_node(key);
+   if (!node || !node->value) {
+      throw std::out_of_range("trie::at key not found");
+   }
+   return node->value->data;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+const typename trie<Token, Data, Traits, Allocator>::mapped_type& trie<Token, Data, Traits, Allocator>::at(const key_type& key) const {
+   return const_cast<trie*>(this)->at(key);
+}
+
+/**
+ * Prefix operations
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::iterator trie<Token, Data, Traits, Allocator>::lower_bound(const key_type& prefix) {
+   iterator it;
+   _seek(it, prefix, false);
+   return it;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::const_iterator trie<Token, Data, Traits, Allocator>::lower_bound(const key_type& prefix) const {
+   const_iterator it;
+   _seek(it, prefix, false);
+   return it;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::iterator trie<Token, Data, Traits, Allocator>::upper_bound(const key_type& prefix) {
+   iterator it;
+   _seek(it, prefix, true);
+   return it;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::const_iterator trie<Token, Data, Traits, Allocator>::upper_bound(const key_type& prefix) const {
+   const_iterator it;
+   _seek(it, prefix, true);
+   return it;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::pair<typename trie<Token, Data, Traits, Allocator>::iterator, typename trie<Token, Data, Traits, Allocator>::iterator>
+trie<Token, Data, Traits, Allocator>::equal_range(const key_type& prefix) {
+   return { lower_bound(prefix), upper_bound(prefix) };
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::pair<typename trie<Token, Data, Traits, Allocator>::const_iterator, typename trie<Token, Data, Traits, Allocator>::const_iterator>
+trie<Token, Data, Traits, Allocator>::equal_range(const key_type& prefix) const {
+   return { lower_bound(prefix), upper_bound(prefix) };
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename F>
+bool trie<Token, Data, Traits, Allocator>::for_each_prefix(const key_type& prefix, F f) const {
+   const_iterator end = upper_bound(prefix);
+   for (const_iterator it = lower_bound(prefix); it != end; ++it) {
+      if constexpr (std::is_void<Data>::value) {
+         if (!f(*it)) return false;
+      } else {
+         auto&& entry = *it;
+         if (!f(entry.first, entry.second)) return false;
+      }
+   }
+   return true;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename F>
+bool trie<Token, Data, Traits, Allocator>::for_each_best(const key_type& prefix, F f) const {
+   static_assert(SCORED, "for_each_best needs arithmetic trie data");
+   if (!root_) return true;
+
+   // down to the node whose subtree holds the keys starting with prefix
+   std::vector<Step> steps{ { root_, 0, 0 } };
+   size_type n = detail::key_byte_count(prefix);
+   size_type i = 0;
+   for (;;) {
+      Node* node = steps.back().node;
+      size_type matched = _match_prefix(node, prefix, i);
+      if (i + matched == n) break;
+      if (matched < node->prefix_len) return true;
+      i += matched;
+      std::uint8_t byte = detail::key_byte(prefix, i++);
+      Node** child = _find_child(node, byte);
+      if (!child) return true;
+      steps.push_back({ *child, steps.size() - 1, byte });
+   }
+
+   // a subtree is opened only once its score tops everything found so far
+   std::priority_queue<Candidate> queue;
+   queue.push({ steps.back().node->best, steps.size() - 1, false });
+   key_type key;
+   while (!queue.empty()) {
+      Candidate top = queue.top();
+      queue.pop();
+      Node* node = steps[top.step].node;
+      if (top.exact) {
+         _spell(steps, top.step, key);
+         if (!f(static_cast<const key_type&>(key), static_cast<const mapped_type&>(node->value->data))) return false;
+         continue;
+      }
+      if (node->value) queue.push({ node->value->data, top.step, true });
+      int pos = -1;
+      std::uint8_t byte;
+      Node* child;
+      while (_next_child(node, pos, byte, child)) {
+         steps.push_back({ child, top.step, byte });
+         queue.push({ child->best, steps.size() - 1, false });
+      }
+   }
+   return true;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::vector<std::pair<typename trie<Token, Data, Traits, Allocator>::key_type, typename trie<Token, Data, Traits, Allocator>::mapped_type>>
+trie<Token, Data, Traits, Allocator>::top_k(const key_type& prefix, size_type k) const {
+   std::vector<std::pair<key_type, mapped_type>> best;
+   if (k == 0) return best;
+   for_each_best(prefix, [&best, k](const key_type& key, const mapped_type& data) {
+      best.emplace_back(key, data);
+      return best.size() < k;
+   });
+   return best;
+}
+
+/**
+ * Getters
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::size_type trie<Token, Data, Traits, Allocator>::size() const noexcept {
+   return size_;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool trie<Token, Data, Traits, Allocator>::empty() const noexcept {
+   return size_ == 0;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::clear() noexcept {
+   if constexpr (!std::is_trivially_destructible<mapped_type>::value) {
+      if (root_) _destroy_data(root_);
+   }
+   arena_.release();
+   root_ = nullptr;
+   size_ = 0;
+}
+
+/**
+ * Operators
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::subscript_type trie<Token, Data, Traits, Allocator>::operator[](const key_type& key) {
+   Node* node = _find_node(key);
+   if (!node || !node->value) {
+      insert(key, mapped_type());
+      node = _find_node(key);
+   }
+   if constexpr (SCORED) {
+      return score_reference{ this, key, &node->value->data };
+   } else {
+      return node->value->data;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+trie<Token, Data, Traits, Allocator>& trie<Token, Data, Traits, Allocator>::operator=(const trie& other) {
+   if (this != &other) {
+      trie tmp(other);
+      swap(tmp);
+   }
+   return *this;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+trie<Token, Data, Traits, Allocator>& trie<Token, Data, Traits, Allocator>::operator=(trie&& other) noexcept {
+   trie tmp(std::move(other));
+   swap(tmp);
+   return *this;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::swap(trie& other) noexcept {
+   std::swap(root_, other.root_);
+   std::swap(size_, other.size_);
+   arena_.swap(other.arena_);
+}
+
+/**
+ * Node management
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename N>
+N* trie<Token, Data, Traits, Allocator>::_create_node() {
+   return new (arena_.allocate(sizeof(N))) N();
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename N>
+void trie<Token, Data, Traits, Allocator>::_free_node(N* node) noexcept {
+   node->~N();
+   arena_.deallocate(node, sizeof(N));
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_destroy_node(Node* node) noexcept {
+   _free_prefix(node->prefix, node->prefix_len);
+   switch (node->kind) {
+      case NODE4:   _free_node(static_cast<Node4*>(node)); break;
+      case NODE16:  _free_node(static_cast<Node16*>(node)); break;
+      case NODE48:  _free_node(static_cast<Node48*>(node)); break;
+      case NODE256: _free_node(static_cast<Node256*>(node)); break;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+std::uint8_t* trie<Token, Data, Traits, Allocator>::_allocate_prefix(size_type len) {
+   if (len == 0) return nullptr;
+   return static_cast<std::uint8_t*>(arena_.allocate(len));
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_free_prefix(std::uint8_t* prefix, size_type len) noexcept {
+   if (prefix) arena_.deallocate(prefix, len);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::Node*
+trie<Token, Data, Traits, Allocator>::_create_tail(const key_type& key, size_type from, const mapped_type& data) {
+   size_type len = detail::key_byte_count(key) - from;
+   Node4* node = _create_node<Node4>();
+   try {
+      node->prefix = _allocate_prefix(len);
+      node->prefix_len = static_cast<std::uint32_t>(len);
+      node->value = _create_leaf(data);
+   } catch (...) {
+      _destroy_node(node);
+      throw;
+   }
+   for (size_type i = 0; i < len; i++) node->prefix[i] = detail::key_byte(key, from + i);
+   if constexpr (SCORED) node->best = data;
+   return node;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::size_type
+trie<Token, Data, Traits, Allocator>::_match_prefix(const Node* node, const key_type& key, size_type from) noexcept {
+   size_type n = detail::key_byte_count(key) - from;
+   size_type len = node->prefix_len < n ? node->prefix_len : n;
+   size_type i = 0;
+   while (i < len && node->prefix[i] == detail::key_byte(key, from + i)) i++;
+   return i;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_split(Node*& node, size_type matched, const key_type& key, size_type from, const mapped_type& data) {
+   bool ends = from == detail::key_byte_count(key);
+   size_type rest = node->prefix_len - matched - 1;
+   Node4* parent = _create_node<Node4>();
+   std::uint8_t* rest_prefix = nullptr;
+   Node* tail = nullptr;
+   try {
+      parent->prefix = _allocate_prefix(matched);
+      parent->prefix_len = static_cast<std::uint32_t>(matched);
+      rest_prefix = _allocate_prefix(rest);
+      if (ends) {
+         parent->value = _create_leaf(data);
+      } else {
+         tail = _create_tail(key, from + 1, data);
+      }
+   } catch (...) {
+      _free_prefix(rest_prefix, rest);
+      _destroy_node(parent);
+      throw;
+   }
+
+   // nothing below allocates: the new Node4 has room for both children
+   std::uint8_t byte = node->prefix[matched];
+   for (size_type i = 0; i < matched; i++) parent->prefix[i] = node->prefix[i];
+   for (size_type i = 0; i < rest; i++) rest_prefix[i] = node->prefix[matched + 1 + i];
+   _free_prefix(node->prefix, node->prefix_len);
+   node->prefix = rest_prefix;
+   node->prefix_len = static_cast<std::uint32_t>(rest);
+
+   // insert raises the score to data afterwards
+   parent->best = node->best;
+   Node* split = parent;
+   _add_child(split, byte, node);
+   if (tail) _add_child(split, detail::key_byte(key, from), tail);
+   node = split;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_merge(Node*& node) noexcept {
+   int pos = -1;
+   std::uint8_t byte;
+   Node* child;
+   _next_child(node, pos, byte, child);
+   size_type len = node->prefix_len + 1 + child->prefix_len;
+   std::uint8_t* prefix;
+   try {
+      prefix = _allocate_prefix(len);
+   } catch (...) {
+      // the node just stays, an extra step on the way to child
+      return;
+   }
+   std::uint8_t* out = prefix;
+   for (std::uint32_t i = 0; i < node->prefix_len; i++) *out++ = node->prefix[i];
+   *out++ = byte;
+   for (std::uint32_t i = 0; i < child->prefix_len; i++) *out++ = child->prefix[i];
+   _free_prefix(child->prefix, child->prefix_len);
+   child->prefix = prefix;
+   child->prefix_len = static_cast<std::uint32_t>(len);
+   _destroy_node(node);
+   node = child;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::Leaf* trie<Token, Data, Traits, Allocator>::_create_leaf(const mapped_type& data) {
+   void* leaf = arena_.allocate(sizeof(Leaf));
+   try {
+      return new (leaf) Leaf{ data };
+   } catch (...) {
+      arena_.deallocate(leaf, sizeof(Leaf));
+      throw;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_destroy_leaf(Leaf* leaf) noexcept {
+   leaf->~Leaf();
+   arena_.deallocate(leaf, sizeof(Leaf));
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::Node** trie<Token, Data, Traits, Allocator>::_find_child(Node* node, std::uint8_t byte) noexcept {
+   switch (node->kind) {
+      case NODE4: {
+         Node4* n = static_cast<Node4*>(node);
+         for (std::uint16_t i = 0; i < n->count; i++) {
+            if (n->keys[i] == byte) return &n->children[i];
+         }
+         return nullptr;
+      }
+      case NODE16: {
+         Node16* n = static_cast<Node16*>(node);
+#ifdef DSACPP_TRIE_SSE2
+         __m128i hits = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+         unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits)) & ((1u << n->count) - 1);
+         return mask ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+         for (std::uint16_t i = 0; i < n->count; i++) {
+            if (n->keys[i] == byte) return &n->children[i];
+         }
+         return nullptr;
+#endif
+      }
+      case NODE48: {
+         Node48* n = static_cast<Node48*>(node);
+         return n->index[byte] ? &n->children[n->index[byte] - 1] : nullptr;
+      }
+      case NODE256: {
+         Node256* n = static_cast<Node256*>(node);
+         return n->children[byte] ? &n->children[byte] : nullptr;
+      }
+   }
+   return nullptr;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename From, typename To>
+void trie<Token, Data, Traits, Allocator>::_copy_children(const From* from, To* to) noexcept {
+   to->count = from->count;
+   to->prefix_len = from->prefix_len;
+   to->prefix = from->prefix;
+   to->value = from->value;
+   to->best = from->best;
+   if constexpr (std::is_same<To, Node256>::value) {
+      // Node48 -> Node256
+      for (int b = 0; b < 256; b++) {
+         if (from->index[b]) to->children[b] = from->children[from->index[b] - 1];
+      }
+   } else if constexpr (std::is_same<To, Node48>::value && std::is_same<From, Node256>::value) {
+      std::uint8_t slot = 0;
+      for (int b = 0; b < 256; b++) {
+         if (!from->children[b]) continue;
+         to->children[slot] = from->children[b];
+         to->index[b] = ++slot;
+      }
+   } else if constexpr (std::is_same<To, Node48>::value) {
+      // Node16 -> Node48
+      for (std::uint16_t i = 0; i < from->count; i++) {
+         to->children[i] = from->children[i];
+         to->index[from->keys[i]] = static_cast<std::uint8_t>(i + 1);
+      }
+   } else if constexpr (std::is_same<From, Node48>::value) {
+      // Node48 -> Node16
+      std::uint16_t i = 0;
+      for (int b = 0; b < 256; b++) {
+         if (!from->index[b]) continue;
+         to->keys[i] = static_cast<std::uint8_t>(b);
+         to->children[i++] = from->children[from->index[b] - 1];
+      }
+   } else {
+      // between the sorted layouts
+      for (std::uint16_t i = 0; i < from->count; i++) {
+         to->keys[i] = from->keys[i];
+         to->children[i] = from->children[i];
+      }
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_add_child(Node*& node, std::uint8_t byte, Node* child) {
+   switch (node->kind) {
+      case NODE4:
+      case NODE16: {
+         std::uint16_t capacity = node->kind == NODE4 ? 4 : 16;
+         if (node->count == capacity) {
+            if (node->kind == NODE4) {
+               Node16* grown = _create_node<Node16>();
+               _copy_children(static_cast<Node4*>(node), grown);
+               _free_node(static_cast<Node4*>(node));
+               node = grown;
+            } else {
+               Node48* grown = _create_node<Node48>();
+               _copy_children(static_cast<Node16*>(node), grown);
+               _free_node(static_cast<Node16*>(node));
+               node = grown;
+            }
+            _add_child(node, byte, child);
+            return;
+         }
+         std::uint8_t* keys = node->kind == NODE4 ? static_cast<Node4*>(node)->keys : static_cast<Node16*>(node)->keys;
+         Node** children = node->kind == NODE4 ? static_cast<Node4*>(node)->children : static_cast<Node16*>(node)->children;
+         std::uint16_t i = node->count;
+         for (; i > 0 && keys[i - 1] > byte; i--) {
+            keys[i] = keys[i - 1];
+            children[i] = children[i - 1];
+         }
+         keys[i] = byte;
+         children[i] = child;
+         node->count++;
+         return;
+      }
+      case NODE48: {
+         Node48* n = static_cast<Node48*>(node);
+         if (n->count == 48) {
+            Node256* grown = _create_node<Node256>();
+            _copy_children(n, grown);
+            _free_node(n);
+            node = grown;
+            _add_child(node, byte, child);
+            return;
+         }
+         std::uint8_t slot = 0;
+         while (n->children[slot]) slot++;
+         n->children[slot] = child;
+         n->index[byte] = static_cast<std::uint8_t>(slot + 1);
+         n->count++;
+         return;
+      }
+      case NODE256: {
+         static_cast<Node256*>(node)->children[byte] = child;
+         node->count++;
+         return;
+      }
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_remove_child(Node*& node, std::uint8_t byte) noexcept {
+   switch (node->kind) {
+      case NODE4:
+      case NODE16: {
+         std::uint8_t* keys = node->kind == NODE4 ? static_cast<Node4*>(node)->keys : static_cast<Node16*>(node)->keys;
+         Node** children = node->kind == NODE4 ? static_cast<Node4*>(node)->children : static_cast<Node16*>(node)->children;
+         std::uint16_t i = 0;
+         while (keys[i] != byte) i++;
+         for (node->count--; i < node->count; i++) {
+            keys[i] = keys[i + 1];
+            children[i] = children[i + 1];
+         }
+         break;
+      }
+      case NODE48: {
+         Node48* n = static_cast<Node48*>(node);
+         n->children[n->index[byte] - 1] = nullptr;
+         n->index[byte] = 0;
+         n->count--;
+         break;
+      }
+      case NODE256: {
+         static_cast<Node256*>(node)->children[byte] = nullptr;
+         node->count--;
+         break;
+      }
+   }
+
+   // a failed allocation only means the node stays in its larger layout
+   try {
+      if (node->kind == NODE16 && node->count <= NODE16_SHRINK) {
+         Node4* shrunk = _create_node<Node4>();
+         _copy_children(static_cast<Node16*>(node), shrunk);
+         _free_node(static_cast<Node16*>(node));
+         node = shrunk;
+      } else if (node->kind == NODE48 && node->count <= NODE48_SHRINK) {
+         Node16* shrunk = _create_node<Node16>();
+         _copy_children(static_cast<Node48*>(node), shrunk);
+         _free_node(static_cast<Node48*>(node));
+         node = shrunk;
+      } else if (node->kind == NODE256 && node->count <= NODE256_SHRINK) {
+         Node48* shrunk = _create_node<Node48>();
+         _copy_children(static_cast<Node256*>(node), shrunk);
+         _free_node(static_cast<Node256*>(node));
+         node = shrunk;
+      }
+   } catch (...) { }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool trie<Token, Data, Traits, Allocator>::_next_child(const Node* node, int& pos, std::uint8_t& byte, Node*& child) noexcept {
+   switch (node->kind) {
+      case NODE4:
+      case NODE16: {
+         if (pos + 1 >= node->count) return false;
+         pos++;
+         if (node->kind == NODE4) {
+            byte = static_cast<const Node4*>(node)->keys[pos];
+            child = static_cast<const Node4*>(node)->children[pos];
+         } else {
+            byte = static_cast<const Node16*>(node)->keys[pos];
+            child = static_cast<const Node16*>(node)->children[pos];
+         }
+         return true;
+      }
+      case NODE48: {
+         const Node48* n = static_cast<const Node48*>(node);
+         for (int b = pos + 1; b < 256; b++) {
+            if (n->index[b]) {
+               pos = b;
+               byte = static_cast<std::uint8_t>(b);
+               child = n->children[n->index[b] - 1];
+               return true;
+            }
+         }
+         return false;
+      }
+      case NODE256: {
+         const Node256* n = static_cast<const Node256*>(node);
+         for (int b = pos + 1; b < 256; b++) {
+            if (n->children[b]) {
+               pos = b;
+               byte = static_cast<std::uint8_t>(b);
+               child = n->children[b];
+               return true;
+            }
+         }
+         return false;
+      }
+   }
+   return false;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+int trie<Token, Data, Traits, Allocator>::_position_before(const Node* node, std::uint8_t byte) noexcept {
+   if (node->kind == NODE4 || node->kind == NODE16) {
+      const std::uint8_t* keys = node->kind == NODE4 ? static_cast<const Node4*>(node)->keys
+                                                     : static_cast<const Node16*>(node)->keys;
+      int i = 0;
+      while (i < node->count && keys[i] < byte) i++;
+      return i - 1;
+   }
+   return static_cast<int>(byte) - 1;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::Node* trie<Token, Data, Traits, Allocator>::_find_node(const key_type& key) const noexcept {
+   Node* node = root_;
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   while (node) {
+      size_type matched = _match_prefix(node, key, i);
+      if (matched < node->prefix_len) return nullptr;
+      i += matched;
+      if (i == n) return node;
+      Node** child = _find_child(node, detail::key_byte(key, i++));
+      node = child ? *child : nullptr;
+   }
+   return nullptr;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::Node* trie<Token, Data, Traits, Allocator>::_clone(const Node* node) {
+   Node* copy;
+   switch (node->kind) {
+      case NODE4: {
+         Node4* n = _create_node<Node4>();
+         for (int i = 0; i < 4; i++) n->keys[i] = static_cast<const Node4*>(node)->keys[i];
+         copy = n;
+         break;
+      }
+      case NODE16: {
+         Node16* n = _create_node<Node16>();
+         for (int i = 0; i < 16; i++) n->keys[i] = static_cast<const Node16*>(node)->keys[i];
+         copy = n;
+         break;
+      }
+      case NODE48: {
+         Node48* n = _create_node<Node48>();
+         for (int i = 0; i < 256; i++) n->index[i] = static_cast<const Node48*>(node)->index[i];
+         copy = n;
+         break;
+      }
+      default:
+         copy = _create_node<Node256>();
+         break;
+   }
+   // children are filled in one by one, so a throw leaves a clearable node
+   try {
+      copy->prefix = _allocate_prefix(node->prefix_len);
+      copy->prefix_len = node->prefix_len;
+      copy->best = node->best;
+      for (std::uint32_t i = 0; i < node->prefix_len; i++) copy->prefix[i] = node->prefix[i];
+      if (node->value) copy->value = _create_leaf(node->value->data);
+      int pos = -1;
+      std::uint8_t byte;
+      Node* child;
+      while (_next_child(node, pos, byte, child)) {
+         Node* cloned = _clone(child);
+         switch (copy->kind) {
+            case NODE4:   static_cast<Node4*>(copy)->children[pos] = cloned; break;
+            case NODE16:  static_cast<Node16*>(copy)->children[pos] = cloned; break;
+            case NODE48:  static_cast<Node48*>(copy)->children[static_cast<const Node48*>(node)->index[pos] - 1] = cloned; break;
+            case NODE256: static_cast<Node256*>(copy)->children[pos] = cloned; break;
+         }
+         copy->count++;
+      }
+   } catch (...) {
+      _clear_node(copy);
+      throw;
+   }
+   return copy;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_clear_node(Node* node) noexcept {
+   int pos = -1;
+   std::uint8_t byte;
+   Node* child;
+   while (_next_child(node, pos, byte, child)) {
+      if (child) _clear_node(child);
+   }
+   if (node->value) _destroy_leaf(node->value);
+   _destroy_node(node);
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_destroy_data(Node* node) noexcept {
+   int pos = -1;
+   std::uint8_t byte;
+   Node* child;
+   while (_next_child(node, pos, byte, child)) {
+      _destroy_data(child);
+   }
+   if (node->value) node->value->~Leaf();
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool trie<Token, Data, Traits, Allocator>::_find_path(const key_type& key, std::vector<Node**>& refs) const {
+   if (!root_) return false;
+   refs.push_back(const_cast<Node**>(&root_));
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   for (;;) {
+      Node* node = *refs.back();
+      size_type matched = _match_prefix(node, key, i);
+      if (matched < node->prefix_len) return false;
+      i += matched;
+      if (i == n) return node->value != nullptr;
+      Node** child = _find_child(node, detail::key_byte(key, i));
+      if (!child) return false;
+      refs.push_back(child);
+      i++;
+   }
+}
+
+/**
+ * Scores
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_raise(const key_type& key, const mapped_type& data) noexcept {
+   Node* node = root_;
+   size_type n = detail::key_byte_count(key);
+   size_type i = node->prefix_len;
+   for (;;) {
+      if (node->best < data) node->best = data;
+      if (i == n) return;
+      node = *_find_child(node, detail::key_byte(key, i));
+      i += 1 + node->prefix_len;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+bool trie<Token, Data, Traits, Allocator>::_rescore(Node* node) noexcept {
+   mapped_type best = node->value ? node->value->data : std::numeric_limits<mapped_type>::lowest();
+   int pos = -1;
+   std::uint8_t byte;
+   Node* child;
+   while (_next_child(node, pos, byte, child)) {
+      if (best < child->best) best = child->best;
+   }
+   bool changed = best != node->best;
+   node->best = best;
+   return changed;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_rescore_path(Node** const* refs, size_type count) noexcept {
+   for (size_type i = count; i-- > 0; ) {
+      // an unchanged score stops the climb, unless the node is new to its slot
+      if (!_rescore(*refs[i]) && i + 1 < count) return;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void trie<Token, Data, Traits, Allocator>::_spell(const std::vector<Step>& steps, size_type step, key_type& key) {
+   size_type bytes = 0;
+   for (size_type s = step; ; s = steps[s].parent) {
+      bytes += steps[s].node->prefix_len;
+      if (s == 0) break;
+      bytes++;
+   }
+   key.assign(bytes / TOKEN_BYTES, Token());
+   // fill from the back, walking up from the step
+   size_type at = bytes;
+   auto put = [&key, &at](std::uint8_t byte) {
+      at--;
+      size_type shift = 8 * (TOKEN_BYTES - 1 - at % TOKEN_BYTES);
+      unsigned_token bits = static_cast<unsigned_token>(static_cast<unsigned_token>(byte) << shift);
+      key[at / TOKEN_BYTES] = static_cast<Token>(static_cast<unsigned_token>(key[at / TOKEN_BYTES]) | bits);
+   };
+   for (size_type s = step; ; s = steps[s].parent) {
+      const Node* node = steps[s].node;
+      for (std::uint32_t i = node->prefix_len; i-- > 0; ) put(node->prefix[i]);
+      if (s == 0) break;
+      put(steps[s].byte);
+   }
+}
+
+/**
+ * Bulk build
+ */
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename V>
+decltype(auto) trie<Token, Data, Traits, Allocator>::_key_of(const V& value) noexcept {
+   if constexpr (std::is_void<Data>::value) {
+      return (value);
+   } else {
+      return (value.first);
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename V>
+decltype(auto) trie<Token, Data, Traits, Allocator>::_data_of(const V& value) {
+   if constexpr (std::is_void<Data>::value) {
+      (void)value;
+      return mapped_type();
+   } else {
+      return (value.second);
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::size_type
+trie<Token, Data, Traits, Allocator>::_common_prefix(const key_type& a, const key_type& b) noexcept {
+   size_type n = std::min(detail::key_byte_count(a), detail::key_byte_count(b));
+   size_type i = 0;
+   while (i < n && detail::key_byte(a, i) == detail::key_byte(b, i)) i++;
+   return i;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename It>
+void trie<Token, Data, Traits, Allocator>::_assign(It begin, It end) {
+   try {
+      _build(begin, end);
+      for (; begin != end; ++begin) {
+         insert(_key_of(*begin), _data_of(*begin));
+      }
+   } catch (...) {
+      clear();
+      throw;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename It>
+void trie<Token, Data, Traits, Allocator>::_build(It& begin, It end) {
+   // the nodes on the path to the last key, root first; a node is closed
+   // once a key leaves its subtree, which in sorted order is for good
+   std::vector<Pending> path;
+   child_list children;
+   key_type last;
+   try {
+      for (; begin != end; ++begin) {
+         key_type key(_key_of(*begin));
+         size_type n = detail::key_byte_count(key);
+         if (path.empty()) {
+            path.push_back({ n, nullptr, 0 });
+         } else {
+            size_type shared = _common_prefix(key, last);
+            if (shared == n) {
+               // a duplicate keeps the first data, as insert does
+               if (n == detail::key_byte_count(last)) continue;
+               break;
+            }
+            if (shared < detail::key_byte_count(last) && detail::key_byte(key, shared) < detail::key_byte(last, shared)) break;
+
+            while (!path.empty() && path.back().depth > shared) {
+               size_type parent = path.size() > 1 ? std::max(path[path.size() - 2].depth, shared) : shared;
+               Node* node = _close(path.back(), parent + 1, last, children);
+               path.pop_back();
+               children.emplace_back(detail::key_byte(last, parent), node);
+            }
+            // key branches off inside a label: the node closed last gets a new parent
+            if (path.empty() || path.back().depth < shared) {
+               path.push_back({ shared, nullptr, children.size() - 1 });
+            }
+            path.push_back({ n, nullptr, children.size() });
+         }
+         path.back().value = _create_leaf(_data_of(*begin));
+         size_++;
+         last.swap(key);
+      }
+
+      while (path.size() > 1) {
+         size_type parent = path[path.size() - 2].depth;
+         Node* node = _close(path.back(), parent + 1, last, children);
+         path.pop_back();
+         children.emplace_back(detail::key_byte(last, parent), node);
+      }
+      if (!path.empty()) root_ = _close(path.back(), 0, last, children);
+   } catch (...) {
+      if constexpr (!std::is_trivially_destructible<mapped_type>::value) {
+         for (auto& child : children) _destroy_data(child.second);
+         for (auto& pending : path) {
+            if (pending.value) pending.value->~Leaf();
+         }
+      }
+      throw;
+   }
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+typename trie<Token, Data, Traits, Allocator>::Node*
+trie<Token, Data, Traits, Allocator>::_close(const Pending& pending, size_type start, const key_type& key, child_list& children) {
+   children.reserve(pending.first + 1);
+   size_type count = children.size() - pending.first;
+   Node* node;
+   if (count <= 4) {
+      node = _create_node<Node4>();
+   } else if (count <= 16) {
+      node = _create_node<Node16>();
+   } else if (count <= 48) {
+      node = _create_node<Node48>();
+   } else {
+      node = _create_node<Node256>();
+   }
+   size_type len = pending.depth - start;
+   try {
+      node->prefix = _allocate_prefix(len);
+   } catch (...) {
+      _destroy_node(node);
+      throw;
+   }
+   node->prefix_len = static_cast<std::uint32_t>(len);
+   for (size_type i = 0; i < len; i++) node->prefix[i] = detail::key_byte(key, start + i);
+
+   // children come in key order, so every layout is filled front to back
+   for (size_type i = 0; i < count; i++) {
+      std::uint8_t byte = children[pending.first + i].first;
+      Node* child = children[pending.first + i].second;
+      switch (node->kind) {
+         case NODE4:
+            static_cast<Node4*>(node)->keys[i] = byte;
+            static_cast<Node4*>(node)->children[i] = child;
+            break;
+         case NODE16:
+            static_cast<Node16*>(node)->keys[i] = byte;
+            static_cast<Node16*>(node)->children[i] = child;
+            break;
+         case NODE48:
+            static_cast<Node48*>(node)->index[byte] = static_cast<std::uint8_t>(i + 1);
+            static_cast<Node48*>(node)->children[i] = child;
+            break;
+         case NODE256:
+            static_cast<Node256*>(node)->children[byte] = child;
+            break;
+      }
+   }
+   node->count = static_cast<std::uint16_t>(count);
+   node->value = pending.value;
+   if constexpr (SCORED) _rescore(node);
+   children.resize(pending.first);
+   return node;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename It>
+bool trie<Token, Data, Traits, Allocator>::_build_parallel(thread_pool& pool, It begin, It end) {
+   if (end - begin < 2) return false;
+   key_type first(_key_of(*begin));
+   size_type depth = _common_prefix(first, _key_of(*(end - 1)));
+
+   // keys equal to the common prefix sort first and become the root's data
+   It lo = begin;
+   for (; lo != end; ++lo) {
+      const key_type& key = _key_of(*lo);
+      if (detail::key_byte_count(key) > depth) break;
+      if (detail::key_byte_count(key) < depth || _common_prefix(key, first) < depth) return false;
+   }
+   if (lo == end) return false;
+
+   // the rest splits into runs by the byte after the common prefix
+   std::vector<It> bounds{ lo };
+   int previous = -1;
+   while (bounds.back() != end) {
+      const key_type& key = _key_of(*bounds.back());
+      if (detail::key_byte_count(key) <= depth || detail::key_byte(key, depth) <= previous) return false;
+      std::uint8_t byte = detail::key_byte(key, depth);
+      previous = byte;
+      bounds.push_back(std::partition_point(bounds.back(), end, [depth, byte](const auto& value) {
+         const key_type& k = _key_of(value);
+         return detail::key_byte_count(k) <= depth || detail::key_byte(k, depth) <= byte;
+      }));
+   }
+
+   size_type parts = bounds.size() - 1;
+   std::vector<trie> subs;
+   subs.reserve(parts);
+   for (size_type i = 0; i < parts; i++) subs.emplace_back(arena_.get_allocator());
+   std::vector<Node*> roots(parts);
+   std::atomic<bool> split{ true };
+   task_group group(pool);
+   for (size_type i = 0; i < parts; i++) {
+      group.run([&subs, &bounds, &first, &split, depth, i] {
+         // the binary search above trusted the order; check it held
+         std::uint8_t byte = detail::key_byte(_key_of(*bounds[i]), depth);
+         for (It it = bounds[i]; it != bounds[i + 1]; ++it) {
+            const key_type& key = _key_of(*it);
+            if (detail::key_byte_count(key) <= depth || detail::key_byte(key, depth) != byte || _common_prefix(key, first) < depth) {
+               split.store(false, std::memory_order_relaxed);
+               return;
+            }
+         }
+         subs[i]._assign(bounds[i], bounds[i + 1]);
+      });
+   }
+   group.wait();
+   if (!split.load(std::memory_order_relaxed)) return false;
+
+   for (size_type i = 0; i < parts; i++) {
+      roots[i] = subs[i].root_;
+      size_ += subs[i].size_;
+      subs[i].root_ = nullptr;
+      subs[i].size_ = 0;
+      arena_.merge(subs[i].arena_);
+   }
+   Leaf* value = nullptr;
+   try {
+      if (lo != begin) {
+         value = _create_leaf(_data_of(*begin));
+         size_++;
+      }
+      if (parts == 1 && !value) {
+         root_ = roots[0];
+         return true;
+      }
+      // each part's root is labelled with the common prefix and its byte,
+      // which the new root and its branch now spell
+      child_list children;
+      children.reserve(parts);
+      for (Node* node : roots) {
+         size_type len = node->prefix_len - depth - 1;
+         std::uint8_t* prefix = _allocate_prefix(len);
+         std::uint8_t byte = node->prefix[depth];
+         for (size_type i = 0; i < len; i++) prefix[i] = node->prefix[depth + 1 + i];
+         _free_prefix(node->prefix, node->prefix_len);
+         node->prefix = prefix;
+         node->prefix_len = static_cast<std::uint32_t>(len);
+         children.emplace_back(byte, node);
+      }
+      root_ = _close(Pending{ depth, value, 0 }, 0, first, children);
+   } catch (...) {
+      if constexpr (!std::is_trivially_destructible<mapped_type>::value) {
+         for (Node* node : roots) _destroy_data(node);
+         if (value) value->~Leaf();
+      }
+      arena_.release();
+      size_ = 0;
+      throw;
+   }
+   return true;
+}
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+template<typename It>
+void trie<Token, Data, Traits, Allocator>::_seek(It& it, const key_type& key, bool past_prefix) const {
+   if (!root_) return;
+   it._enter(root_, nullptr);
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   for (;;) {
+      Frame& top = it.stack_.back();
+      size_type matched = _match_prefix(top.node, key, i);
+      if (i + matched == n) {
+         // every key under this node starts with key
+         if (past_prefix) {
+            it._pop();
+            it._advance();
+         } else if (!top.node->value) {
+            it._advance();
+         }
+         return;
+      }
+      if (matched < top.node->prefix_len) {
+         // key leaves the label: the whole subtree sorts before or after it
+         if (top.node->prefix[matched] < detail::key_byte(key, i + matched)) {
+            it._pop();
+            it._advance();
+         } else if (!top.node->value) {
+            it._advance();
+         }
+         return;
+      }
+      i += matched;
+      std::uint8_t byte = detail::key_byte(key, i);
+      Node** child = _find_child(top.node, byte);
+      if (!child) {
+         // key is absent: the answer is the first key past where it would be
+         top.pos = _position_before(top.node, byte);
+         it._advance();
+         return;
+      }
+      top.pos = _position_before(top.node, byte) + 1;
+      it._enter(*child, &byte);
+      i++;
+   }
+}
+
+} // namespace dsacpp
+
+#include "frozen_trie.hpp"
+#include "double_array_trie.hpp"
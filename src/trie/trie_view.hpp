@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail/key_bytes.hpp"
+#include "trie.hpp"
+#include "../vector/vector_view.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * On-disk trie format (POSIX only). A file is a 64-byte header followed,
+ * at data_offset, by an image of the trie's nodes in post-order, children
+ * before their parent, so every subtree is one contiguous run. Nodes refer
+ * to their children by offset from the start of the image, never by
+ * address, so the image works wherever it is mapped. Each node starts on
+ * a TRIE_FILE_NODE_ALIGNMENT boundary with a trie_file_node, followed by
+ *    - the image offsets of its children, as uint64_t
+ *    - its data, if a key ends there, aligned for Data (nothing for a set)
+ *    - the children's branch bytes, sorted
+ *    - its label
+ * Files are written in the host byte order and rejected on a host with the
+ * other one. Only trivially copyable Data can be stored.
+ */
+struct trie_file_header {
+   char magic[8];                // TRIE_FILE_MAGIC
+   std::uint32_t version;        // TRIE_FILE_VERSION
+   std::uint32_t byte_order;     // TRIE_FILE_BYTE_ORDER as written by the host
+   std::uint16_t token_size;     // sizeof(Token)
+   std::uint16_t data_align;     // alignof(Data), 0 for a set
+   std::uint32_t data_size;      // sizeof(Data), 0 for a set
+   std::uint64_t count;          // number of keys
+   std::uint64_t data_offset;    // file offset of the node image
+   std::uint64_t image_bytes;    // size of the node image
+   std::uint64_t root;           // image offset of the root, TRIE_FILE_NO_ROOT if empty
+   std::uint64_t checksum;       // checksum64 of the node image
+};
+
+static_assert(sizeof(trie_file_header) == 64, "trie_file_header must stay 64 bytes");
+
+struct trie_file_node {
+   std::uint32_t prefix_len;     // label bytes
+   std::uint16_t count;          // children
+   std::uint8_t has_value;       // whether a key ends here
+   std::uint8_t reserved;
+};
+
+inline constexpr char TRIE_FILE_MAGIC[8] = { 'D', 'S', 'A', 'T', 'R', 'I', 'E', '\0' };
+inline constexpr std::uint32_t TRIE_FILE_VERSION = 1;
+inline constexpr std::uint32_t TRIE_FILE_BYTE_ORDER = 0x01020304;
+inline constexpr std::size_t TRIE_FILE_ALIGNMENT = 64;
+inline constexpr std::size_t TRIE_FILE_NODE_ALIGNMENT = 8;
+inline constexpr std::uint64_t TRIE_FILE_NO_ROOT = ~std::uint64_t{ 0 };
+
+/**
+ * Write t to path in the trie file format. The image is laid out in
+ * memory, then goes out with the header in a single writev into a
+ * temporary file that is renamed over path, as save does for vectors.
+ */
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void save(const trie<Token, Data, Traits, Allocator>& t, const std::string& path);
+
+/**
+ * Read-only, zero-copy view of a trie file. The file is mapped, not read,
+ * so opening costs a few system calls whatever the size, and processes
+ * mapping the same file share its pages through the page cache. Lookups
+ * walk the image in place: at each node the label is compared, then the
+ * next byte is binary searched among the children's.
+ *
+ * Opening checks the header only. The checksum covers the whole image, so
+ * checking it reads the whole file; pass verify_checksum to pay that at
+ * open, or call verify() later. A corrupt image that gets past the header
+ * checks is only caught by the checksum.
+ */
+template<
+   typename Token,
+   typename Data        = void,
+   typename Traits      = std::char_traits<Token>
+>
+class trie_view {
+public:
+
+   /**
+    * Type Declarations
+    */
+
+   using token_type        = Token;
+   using key_type          = std::basic_string<Token, Traits>;
+   using data_type         = Data;
+   using mapped_type       = std::conditional_t<std::is_void<Data>::value, trie_no_data, Data>;
+   using traits_type       = Traits;
+   using size_type         = size_t;
+   using difference_type   = std::ptrdiff_t;
+
+   static_assert(std::is_trivially_copyable<mapped_type>::value, "trie files hold trivially copyable data only");
+   static_assert(alignof(mapped_type) <= TRIE_FILE_ALIGNMENT, "trie files align data to at most TRIE_FILE_ALIGNMENT");
+
+   /*
+    * Constructors
+   */
+
+   trie_view() noexcept;
+
+   explicit trie_view(const std::string& path, bool verify_checksum = false);
+
+   trie_view(const trie_view&) = delete;
+   trie_view& operator=(const trie_view&) = delete;
+
+   trie_view(trie_view&& other) noexcept;
+   trie_view& operator=(trie_view&& other) noexcept;
+
+   ~trie_view() noexcept;
+
+   /**
+    * Lookup
+    */
+
+   bool contains(const key_type& key) const noexcept;
+
+   // key's data in the mapping, or null if key is not there
+   const mapped_type* find(const key_type& key) const noexcept;
+
+   const mapped_type& at(const key_type& key) const;
+
+   // f(key) for a set, f(key, data) for a map, over the keys starting with
+   // prefix in key order, until f returns false; true if it saw them all
+   template<typename F>
+   bool for_each_prefix(const key_type& prefix, F f) const;
+
+   /**
+    * Getters
+    */
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+   const trie_file_header& header() const noexcept;
+
+   // recompute the checksum over the mapped image
+   bool verify() const noexcept;
+
+   void swap(trie_view& other) noexcept;
+
+private:
+
+   template<typename T, typename D, typename Tr, typename A>
+   friend void save(const trie<T, D, Tr, A>& t, const std::string& path);
+
+   static constexpr size_type DATA_SIZE = std::is_void<Data>::value ? 0 : sizeof(mapped_type);
+   static constexpr size_type DATA_ALIGN = std::is_void<Data>::value ? 1 : alignof(mapped_type);
+   static constexpr size_type NODE_ALIGN = std::max(TRIE_FILE_NODE_ALIGNMENT, DATA_ALIGN);
+   static constexpr std::uint64_t NONE = TRIE_FILE_NO_ROOT;
+
+   // the parts of the node at some offset
+   struct Node {
+      const trie_file_node* head;
+      const std::uint64_t* children;
+      const mapped_type* value;
+      const std::uint8_t* bytes;
+      const std::uint8_t* prefix;
+   };
+
+   void* map_;
+   size_type map_bytes_;
+   const unsigned char* image_;
+   const trie_file_header* header_;
+
+   /**
+    * Image layout
+    */
+
+   static size_type _align(size_type offset, size_type alignment) noexcept;
+
+   // where each part of a node with count children starts, relative to the node
+   static size_type _value_at(size_type count) noexcept;
+   static size_type _bytes_at(size_type count, bool has_value) noexcept;
+
+   Node _node(std::uint64_t offset) const noexcept;
+
+   // the child of node under byte, or NONE
+   static std::uint64_t _child(const Node& node, std::uint8_t byte) noexcept;
+
+   // the node holding key's data, or NONE
+   std::uint64_t _find_node(const key_type& key) const noexcept;
+
+   // the node whose subtree holds the keys starting with prefix, or NONE,
+   // with bytes set to the key bytes spelled down to it
+   std::uint64_t _find_prefix(const key_type& prefix, std::vector<std::uint8_t>& bytes) const;
+
+   static const mapped_type& _data(const Node& node) noexcept;
+
+   // append node to image, after its children at the given offsets; returns its offset
+   template<typename TrieNode>
+   static std::uint64_t _write_node(std::vector<unsigned char>& image, const TrieNode* node,
+                                    const std::vector<std::pair<std::uint8_t, std::uint64_t>>& children,
+                                    size_type first);
+
+   // lay out source's nodes; returns the root's offset
+   template<typename Allocator>
+   static std::uint64_t _write_image(const trie<Token, Data, Traits, Allocator>& source, std::vector<unsigned char>& image);
+
+   void _unmap() noexcept;
+};
+
+template<typename Token, typename Data, typename Traits, typename Allocator>
+void save(const trie<Token, Data, Traits, Allocator>& t, const std::string& path) {
+   using view_type = trie_view<Token, Data, Traits>;
+
+   std::vector<unsigned char> image;
+   std::uint64_t root = view_type::_write_image(t, image);
+
+   // the header is padded out to the first aligned offset
+   alignas(TRIE_FILE_ALIGNMENT) unsigned char head[TRIE_FILE_ALIGNMENT] = {};
+   trie_file_header header{};
+   std::memcpy(header.magic, TRIE_FILE_MAGIC, sizeof(header.magic));
+   header.version = TRIE_FILE_VERSION;
+   header.byte_order = TRIE_FILE_BYTE_ORDER;
+   header.token_size = static_cast<std::uint16_t>(sizeof(Token));
+   header.data_align = static_cast<std::uint16_t>(view_type::DATA_SIZE ? view_type::DATA_ALIGN : 0);
+   header.data_size = static_cast<std::uint32_t>(view_type::DATA_SIZE);
+   header.count = t.size();
+   header.data_offset = sizeof(head);
+   header.image_bytes = image.size();
+   header.root = root;
+   header.checksum = detail::checksum64(image.data(), image.size());
+   std::memcpy(head, &header, sizeof(header));
+
+   iovec parts[2] = {
+      { head, sizeof(head) },
+      { image.data(), image.size() },
+   };
+   detail::replace_file(path, parts, image.empty() ? 1 : 2);
+}
+
+/*
+ * Constructors
+*/
+
+template<typename Token, typename Data, typename Traits>
+trie_view<Token, Data, Traits>::trie_view() noexcept :
+   map_{ nullptr },
+   map_bytes_{ 0 },
+   image_{ nullptr },
+   header_{ nullptr }
+{ }
+
+template<typename Token, typename Data, typename Traits>
+trie_view<Token, Data, Traits>::trie_view(const std::string& path, bool verify_checksum) : trie_view() {
+   map_ = detail::map_file(path, sizeof(trie_file_header), "trie", map_bytes_);
+
+   const trie_file_header& h = *static_cast<const trie_file_header*>(map_);
+   const char* problem = nullptr;
+   if (std::memcmp(h.magic, TRIE_FILE_MAGIC, sizeof(h.magic)) != 0) {
+      problem = "bad magic";
+   } else if (h.version != TRIE_FILE_VERSION) {
+      problem = "unsupported version";
+   } else if (h.byte_order != TRIE_FILE_BYTE_ORDER) {
+      problem = "written with the other byte order";
+   } else if (h.token_size != sizeof(Token) || h.data_size != DATA_SIZE
+              || h.data_align != (DATA_SIZE ? DATA_ALIGN : 0)) {
+      problem = "token or data type does not match";
+   } else if (h.data_offset % TRIE_FILE_ALIGNMENT != 0 || h.data_offset > map_bytes_
+              || h.image_bytes > map_bytes_ - h.data_offset
+              || (h.root == NONE ? h.count != 0 : h.root >= h.image_bytes || h.root % NODE_ALIGN != 0)) {
+      problem = "truncated or corrupt layout";
+   }
+   if (!problem) {
+      header_ = &h;
+      image_ = static_cast<const unsigned char*>(map_) + h.data_offset;
+      if (verify_checksum && !verify()) problem = "checksum mismatch";
+   }
+   if (problem) {
+      _unmap();
+      detail::throw_format_error(problem, path, "trie");
+   }
+}
+
+template<typename Token, typename Data, typename Traits>
+trie_view<Token, Data, Traits>::trie_view(trie_view&& other) noexcept : trie_view() {
+   swap(other);
+}
+
+template<typename Token, typename Data, typename Traits>
+trie_view<Token, Data, Traits>& trie_view<Token, Data, Traits>::operator=(trie_view&& other) noexcept {
+   if (this != &other) {
+      _unmap();
+      swap(other);
+   }
+   return *this;
+}
+
+template<typename Token, typename Data, typename Traits>
+trie_view<Token, Data, Traits>::~trie_view() noexcept {
+   _unmap();
+}
+
+/**
+ * Lookup
+ */
+
+template<typename Token, typename Data, typename Traits>
+bool trie_view<Token, Data, Traits>::contains(const key_type& key) const noexcept {
+   return _find_node(key) != NONE;
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename trie_view<Token, Data, Traits>::mapped_type* trie_view<Token, Data, Traits>::find(const key_type& key) const noexcept {
+   std::uint64_t offset = _find_node(key);
+   if (offset == NONE) return nullptr;
+   return &_data(_node(offset));
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename trie_view<Token, Data, Traits>::mapped_type& trie_view<Token, Data, Traits>::at(const key_type& key) const {
+   const mapped_type* data = find(key);
+   if (!data) throw std::out_of_range("trie_view::at key not found");
+   return *data;
+}
+
+template<typename Token, typename Data, typename Traits>
+template<typename F>
+bool trie_view<Token, Data, Traits>::for_each_prefix(const key_type& prefix, F f) const {
+   std::vector<std::uint8_t> bytes;
+   std::uint64_t start = _find_prefix(prefix, bytes);
+   if (start == NONE) return true;
+
+   // each frame is a node, its next child to visit and the key length in
+   // bytes at the node; children are stored in key order
+   struct Frame {
+      Node node;
+      size_type next;
+      size_type depth;
+   };
+
+   key_type key;
+   auto visit = [&](const Node& node) {
+      if (!node.head->has_value) return true;
+      detail::bytes_to_key(bytes, key);
+      if constexpr (std::is_void<Data>::value) {
+         return static_cast<bool>(f(static_cast<const key_type&>(key)));
+      } else {
+         return static_cast<bool>(f(static_cast<const key_type&>(key), _data(node)));
+      }
+   };
+
+   Node node = _node(start);
+   if (!visit(node)) return false;
+   std::vector<Frame> stack{ { node, 0, bytes.size() } };
+   while (!stack.empty()) {
+      Frame& top = stack.back();
+      if (top.next == top.node.head->count) {
+         stack.pop_back();
+         continue;
+      }
+      size_type i = top.next++;
+      Node child = _node(top.node.children[i]);
+      bytes.resize(top.depth);
+      bytes.push_back(top.node.bytes[i]);
+      bytes.insert(bytes.end(), child.prefix, child.prefix + child.head->prefix_len);
+      if (!visit(child)) return false;
+      stack.push_back({ child, 0, bytes.size() });
+   }
+   return true;
+}
+
+/**
+ * Getters
+ */
+
+template<typename Token, typename Data, typename Traits>
+typename trie_view<Token, Data, Traits>::size_type trie_view<Token, Data, Traits>::size() const noexcept {
+   return header_ ? static_cast<size_type>(header_->count) : 0;
+}
+
+template<typename Token, typename Data, typename Traits>
+bool trie_view<Token, Data, Traits>::empty() const noexcept {
+   return size() == 0;
+}
+
+template<typename Token, typename Data, typename Traits>
+const trie_file_header& trie_view<Token, Data, Traits>::header() const noexcept {
+   assert(header_ && "trie_view::header on an empty view");
+   return *header_;
+}
+
+template<typename Token, typename Data, typename Traits>
+bool trie_view<Token, Data, Traits>::verify() const noexcept {
+   if (!header_) return true;
+   return detail::checksum64(image_, header_->image_bytes) == header_->checksum;
+}
+
+template<typename Token, typename Data, typename Traits>
+void trie_view<Token, Data, Traits>::swap(trie_view& other) noexcept {
+   std::swap(map_, other.map_);
+   std::swap(map_bytes_, other.map_bytes_);
+   std::swap(image_, other.image_);
+   std::swap(header_, other.header_);
+}
+
+/**
+ * Image layout
+ */
+
+template<typename Token, typename Data, typename Traits>
+typename trie_view<Token, Data, Traits>::size_type trie_view<Token, Data, Traits>::_align(size_type offset, size_type alignment) noexcept {
+   return (offset + alignment - 1) / alignment * alignment;
+}
+
+template<typename Token, typename Data, typename Traits>
+typename trie_view<Token, Data, Traits>::size_type trie_view<Token, Data, Traits>::_value_at(size_type count) noexcept {
+   return _align(sizeof(trie_file_node) + count * sizeof(std::uint64_t), DATA_ALIGN);
+}
+
+template<typename Token, typename Data, typename Traits>
+typename trie_view<Token, Data, Traits>::size_type trie_view<Token, Data, Traits>::_bytes_at(size_type count, bool has_value) noexcept {
+   return has_value ? _value_at(count) + DATA_SIZE : sizeof(trie_file_node) + count * sizeof(std::uint64_t);
+}
+
+template<typename Token, typename Data, typename Traits>
+typename trie_view<Token, Data, Traits>::Node trie_view<Token, Data, Traits>::_node(std::uint64_t offset) const noexcept {
+   const unsigned char* at = image_ + offset;
+   const trie_file_node* head = reinterpret_cast<const trie_file_node*>(at);
+   const std::uint8_t* bytes = at + _bytes_at(head->count, head->has_value);
+   return {
+      head,
+      reinterpret_cast<const std::uint64_t*>(at + sizeof(trie_file_node)),
+      reinterpret_cast<const mapped_type*>(at + _value_at(head->count)),
+      bytes,
+      bytes + head->count
+   };
+}
+
+template<typename Token, typename Data, typename Traits>
+std::uint64_t trie_view<Token, Data, Traits>::_child(const Node& node, std::uint8_t byte) noexcept {
+   const std::uint8_t* end = node.bytes + node.head->count;
+   const std::uint8_t* it = std::lower_bound(node.bytes, end, byte);
+   if (it == end || *it != byte) return NONE;
+   return node.children[it - node.bytes];
+}
+
+template<typename Token, typename Data, typename Traits>
+std::uint64_t trie_view<Token, Data, Traits>::_find_node(const key_type& key) const noexcept {
+   if (!header_ || header_->root == NONE) return NONE;
+   std::uint64_t offset = header_->root;
+   size_type n = detail::key_byte_count(key);
+   size_type i = 0;
+   for (;;) {
+      Node node = _node(offset);
+      std::uint32_t len = node.head->prefix_len;
+      if (n - i < len) return NONE;
+      for (std::uint32_t j = 0; j < len; j++) {
+         if (node.prefix[j] != detail::key_byte(key, i + j)) return NONE;
+      }
+      i += len;
+      if (i == n) return node.head->has_value ? offset : NONE;
+      offset = _child(node, detail::key_byte(key, i++));
+      if (offset == NONE) return NONE;
+   }
+}
+
+template<typename Token, typename Data, typename Traits>
+std::uint64_t trie_view<Token, Data, Traits>::_find_prefix(const key_type& prefix, std::vector<std::uint8_t>& bytes) const {
+   if (!header_ || header_->root == NONE) return NONE;
+   std::uint64_t offset = header_->root;
+   detail::key_to_bytes(prefix, bytes);
+   size_type n = bytes.size();
+   size_type i = 0;
+   for (;;) {
+      Node node = _node(offset);
+      // the prefix may end inside the label, which the keys below share
+      size_type len = node.head->prefix_len;
+      size_type matched = std::min(len, n - i);
+      for (size_type j = 0; j < matched; j++) {
+         if (node.prefix[j] != bytes[i + j]) return NONE;
+      }
+      if (i + matched == n) {
+         bytes.insert(bytes.end(), node.prefix + matched, node.prefix + len);
+         return offset;
+      }
+      i += len;
+      offset = _child(node, bytes[i++]);
+      if (offset == NONE) return NONE;
+   }
+}
+
+template<typename Token, typename Data, typename Traits>
+const typename trie_view<Token, Data, Traits>::mapped_type& trie_view<Token, Data, Traits>::_data(const Node& node) noexcept {
+   if constexpr (std::is_void<Data>::value) {
+      static const mapped_type none{};
+      (void)node;
+      return none;
+   } else {
+      return *node.value;
+   }
+}
+
+template<typename Token, typename Data, typename Traits>
+template<typename TrieNode>
+std::uint64_t trie_view<Token, Data, Traits>::_write_node(std::vector<unsigned char>& image, const TrieNode* node,
+                                                          const std::vector<std::pair<std::uint8_t, std::uint64_t>>& children,
+                                                          size_type first) {
+   size_type count = children.size() - first;
+   bool has_value = node->value != nullptr;
+   size_type bytes_at = _bytes_at(count, has_value);
+   size_type offset = image.size();
+   image.resize(offset + _align(bytes_at + count + node->prefix_len, NODE_ALIGN));
+   unsigned char* at = image.data() + offset;
+
+   trie_file_node head{};
+   head.prefix_len = node->prefix_len;
+   head.count = static_cast<std::uint16_t>(count);
+   head.has_value = has_value;
+   std::memcpy(at, &head, sizeof(head));
+   for (size_type i = 0; i < count; i++) {
+      std::memcpy(at + sizeof(head) + i * sizeof(std::uint64_t), &children[first + i].second, sizeof(std::uint64_t));
+      at[bytes_at + i] = children[first + i].first;
+   }
+   if constexpr (!std::is_void<Data>::value) {
+      if (has_value) std::memcpy(at + _value_at(count), &node->value->data, DATA_SIZE);
+   }
+   if (node->prefix_len) std::memcpy(at + bytes_at + count, node->prefix, node->prefix_len);
+   return offset;
+}
+
+template<typename Token, typename Data, typename Traits>
+template<typename Allocator>
+std::uint64_t trie_view<Token, Data, Traits>::_write_image(const trie<Token, Data, Traits, Allocator>& source, std::vector<unsigned char>& image) {
+   using source_type = trie<Token, Data, Traits, Allocator>;
+   using TrieNode = typename source_type::Node;
+
+   if (!source.root_) return NONE;
+
+   // post-order: a node goes out once all its children have, their
+   // (byte, offset) pairs collected at the tail of children from first on
+   struct Frame {
+      const TrieNode* node;
+      int pos;
+      size_type first;
+      std::uint8_t byte;
+   };
+
+   std::vector<std::pair<std::uint8_t, std::uint64_t>> children;
+   std::vector<Frame> stack{ { source.root_, -1, 0, 0 } };
+   std::uint64_t offset = NONE;
+   while (!stack.empty()) {
+      Frame& top = stack.back();
+      std::uint8_t byte;
+      TrieNode* child;
+      if (source_type::_next_child(top.node, top.pos, byte, child)) {
+         stack.push_back({ child, -1, children.size(), byte });
+         continue;
+      }
+      offset = _write_node(image, top.node, children, top.first);
+      children.resize(top.first);
+      std::uint8_t into = top.byte;
+      stack.pop_back();
+      if (!stack.empty()) children.emplace_back(into, offset);
+   }
+   return offset;
+}
+
+template<typename Token, typename Data, typename Traits>
+void trie_view<Token, Data, Traits>::_unmap() noexcept {
+   if (map_) {
+      ::munmap(map_, map_bytes_);
+   }
+   map_ = nullptr;
+   map_bytes_ = 0;
+   image_ = nullptr;
+   header_ = nullptr;
+}
+
+} // namespace dsacpp
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#if defined(__GLIBC__) || defined(__linux__) || defined(__FreeBSD__)
+#include <malloc.h>
+#define DSACPP_MALLOC_USABLE_SIZE(p) ::malloc_usable_size(p)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define DSACPP_MALLOC_USABLE_SIZE(p) ::malloc_size(p)
+#endif
+
+namespace dsacpp
+{
+
+/**
+ * Size of a cache line on the targets we care about; the unit for padding
+ * data that different threads write to.
+ */
+inline constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * T padded out to its own cache line(s), so neighbouring elements of a
+ * container (e.g. per-thread counters) never share a line.
+ */
+template<typename T>
+struct alignas(CACHE_LINE_SIZE) cache_padded {
+   T value;
+
+   T& operator*() noexcept { return value; }
+   const T& operator*() const noexcept { return value; }
+
+   T* operator->() noexcept { return &value; }
+   const T* operator->() const noexcept { return &value; }
+};
+
+/**
+ * Pointer and element count actually obtained by allocate_at_least.
+ */
+template<typename Pointer>
+struct allocation_result {
+   Pointer ptr;
+   std::size_t count;
+};
+
+/**
+ * Default allocator for vector. Backed by malloc so that allocate_at_least
+ * can report the usable size of the block, letting containers grow into
+ * the allocator's size-class slack instead of wasting it.
+ *
+ * Blocks are aligned to the larger of Align and alignof(T); anything above
+ * malloc's own guarantee goes through aligned_alloc instead. Align must be
+ * a power of two, e.g. 64 for aligned AVX-512 loads.
+ */
+template<typename T, std::size_t Align = alignof(T)>
+class allocator {
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using value_type                             = T;
+   using pointer                                = T*;
+   using size_type                              = std::size_t;
+   using difference_type                        = std::ptrdiff_t;
+   using propagate_on_container_move_assignment = std::true_type;
+   using is_always_equal                        = std::true_type;
+
+   template<typename U>
+   struct rebind { using other = allocator<U, Align>; };
+
+   static constexpr std::size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+   /**
+    * Constructors
+    */
+
+   allocator() noexcept = default;
+
+   template<typename U>
+   allocator(const allocator<U, Align>&) noexcept { }
+
+   /**
+    * Allocation
+    */
+
+   pointer allocate(size_type n);
+
+   // may hand back more than n elements; count says how many fit
+   allocation_result<pointer> allocate_at_least(size_type n);
+
+   void deallocate(pointer p, size_type n) noexcept;
+
+   template<typename U>
+   bool operator==(const allocator<U, Align>&) const noexcept { return true; }
+
+   template<typename U>
+   bool operator!=(const allocator<U, Align>&) const noexcept { return false; }
+
+private:
+
+   static_assert((Align & (Align - 1)) == 0, "allocator alignment must be a power of two");
+
+   static constexpr bool OVER_ALIGNED = alignment > alignof(std::max_align_t);
+};
+
+template<typename T, std::size_t Align>
+typename allocator<T, Align>::pointer allocator<T, Align>::allocate(size_type n) {
+   if (n > (static_cast<size_type>(-1) - alignment) / sizeof(T)) {
+      throw std::bad_alloc();
+   }
+   void* p;
+   if constexpr (OVER_ALIGNED) {
+      // aligned_alloc wants a size that is a multiple of the alignment
+      size_type bytes = (n * sizeof(T) + alignment - 1) / alignment * alignment;
+      p = std::aligned_alloc(alignment, bytes);
+   } else {
+      p = std::malloc(n * sizeof(T));
+   }
+   if (!p) {
+      throw std::bad_alloc();
+   }
+   return static_cast<pointer>(p);
+}
+
+template<typename T, std::size_t Align>
+allocation_result<typename allocator<T, Align>::pointer> allocator<T, Align>::allocate_at_least(size_type n) {
+   pointer p = allocate(n);
+#ifdef DSACPP_MALLOC_USABLE_SIZE
+   size_type usable = DSACPP_MALLOC_USABLE_SIZE(p) / sizeof(T);
+   return { p, usable > n ? usable : n };
+#else
+   return { p, n };
+#endif
+}
+
+template<typename T, std::size_t Align>
+void allocator<T, Align>::deallocate(pointer p, size_type) noexcept {
+   std::free(p);
+}
+
+} // namespace dsacpp
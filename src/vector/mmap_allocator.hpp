@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "vector.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Allocator for very large vectors (POSIX only). Each allocation reserves
+ * a virtual range of at least reserve_bytes without committing it, and only
+ * the pages covering the requested capacity are made accessible. vector
+ * grows such a buffer in place through expand() and hands pages back to the
+ * kernel through shrink(), so growth never copies and the resident set
+ * tracks the data actually written.
+ *
+ * A small header in front of the data records the reservation, so any
+ * mmap_allocator can release any block and instances always compare equal.
+ */
+template<typename T>
+class mmap_allocator {
+public:
+
+   /**
+    * Type declarations
+    */
+
+   using value_type                             = T;
+   using pointer                                = T*;
+   using size_type                              = std::size_t;
+   using difference_type                        = std::ptrdiff_t;
+   using propagate_on_container_move_assignment = std::true_type;
+   using propagate_on_container_swap            = std::true_type;
+   using is_always_equal                        = std::true_type;
+
+   template<typename U>
+   struct rebind { using other = mmap_allocator<U>; };
+
+   // 64 GiB of address space; nothing is committed until it is used
+   static constexpr size_type DEFAULT_RESERVE_BYTES = size_type{ 1 } << 36;
+
+   /**
+    * Constructors
+    */
+
+   explicit mmap_allocator(size_type reserve_bytes = DEFAULT_RESERVE_BYTES, bool huge_pages = true) noexcept;
+
+   template<typename U>
+   mmap_allocator(const mmap_allocator<U>& other) noexcept;
+
+   /**
+    * Allocation
+    */
+
+   pointer allocate(size_type n);
+
+   // rounds n up to the committed pages
+   allocation_result<pointer> allocate_at_least(size_type n);
+
+   void deallocate(pointer p, size_type n) noexcept;
+
+   // commit more of the reservation; false if new_n does not fit in it
+   bool expand(pointer p, size_type old_n, size_type new_n) noexcept;
+
+   // return the pages past new_n to the kernel, keeping the reservation
+   bool shrink(pointer p, size_type old_n, size_type new_n) noexcept;
+
+   /**
+    * Getters
+    */
+
+   size_type reserve_bytes() const noexcept;
+   bool huge_pages() const noexcept;
+
+   template<typename U>
+   bool operator==(const mmap_allocator<U>&) const noexcept { return true; }
+
+   template<typename U>
+   bool operator!=(const mmap_allocator<U>&) const noexcept { return false; }
+
+private:
+
+   template<typename U>
+   friend class mmap_allocator;
+
+   struct Header {
+      size_type reserved;     // bytes mapped, header included
+      size_type committed;    // bytes accessible, header included
+   };
+
+   size_type reserve_bytes_;
+   bool huge_pages_;
+
+   static size_type _page_size() noexcept;
+   static size_type _round_up(size_type bytes) noexcept;
+
+   // data starts one page into the mapping so it stays page aligned
+   static size_type _header_bytes() noexcept;
+   static Header* _header(pointer p) noexcept;
+};
+
+template<typename T>
+using mmap_vector = vector<T, mmap_allocator<T>>;
+
+template<typename T>
+mmap_allocator<T>::mmap_allocator(size_type reserve_bytes, bool huge_pages) noexcept :
+   reserve_bytes_{ reserve_bytes },
+   huge_pages_{ huge_pages }
+{ }
+
+template<typename T>
+template<typename U>
+mmap_allocator<T>::mmap_allocator(const mmap_allocator<U>& other) noexcept :
+   reserve_bytes_{ other.reserve_bytes_ },
+   huge_pages_{ other.huge_pages_ }
+{ }
+
+template<typename T>
+typename mmap_allocator<T>::pointer mmap_allocator<T>::allocate(size_type n) {
+   static_assert(alignof(T) <= 4096, "mmap_allocator aligns data to the page size");
+   if (n > (~size_type{ 0 } - _header_bytes()) / sizeof(T)) {
+      throw std::bad_alloc();
+   }
+   size_type committed = _round_up(_header_bytes() + n * sizeof(T));
+   size_type reserved = _round_up(_header_bytes() + reserve_bytes_);
+   if (reserved < committed) reserved = committed;
+
+   void* base = ::mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+   if (base == MAP_FAILED) {
+      throw std::bad_alloc();
+   }
+   if (::mprotect(base, committed, PROT_READ | PROT_WRITE) != 0) {
+      ::munmap(base, reserved);
+      throw std::bad_alloc();
+   }
+#ifdef MADV_HUGEPAGE
+   if (huge_pages_) {
+      ::madvise(base, reserved, MADV_HUGEPAGE);
+   }
+#endif
+   Header* header = static_cast<Header*>(base);
+   header->reserved = reserved;
+   header->committed = committed;
+   return reinterpret_cast<pointer>(static_cast<unsigned char*>(base) + _header_bytes());
+}
+
+template<typename T>
+allocation_result<typename mmap_allocator<T>::pointer> mmap_allocator<T>::allocate_at_least(size_type n) {
+   pointer p = allocate(n);
+   return { p, (_header(p)->committed - _header_bytes()) / sizeof(T) };
+}
+
+template<typename T>
+void mmap_allocator<T>::deallocate(pointer p, size_type) noexcept {
+   if (!p) return;
+   Header* header = _header(p);
+   ::munmap(header, header->reserved);
+}
+
+template<typename T>
+bool mmap_allocator<T>::expand(pointer p, size_type, size_type new_n) noexcept {
+   Header* header = _header(p);
+   if (new_n > (header->reserved - _header_bytes()) / sizeof(T)) return false;
+   size_type needed = _round_up(_header_bytes() + new_n * sizeof(T));
+   if (needed > header->committed) {
+      unsigned char* base = reinterpret_cast<unsigned char*>(header);
+      if (::mprotect(base + header->committed, needed - header->committed, PROT_READ | PROT_WRITE) != 0) {
+         return false;
+      }
+      header->committed = needed;
+   }
+   return true;
+}
+
+template<typename T>
+bool mmap_allocator<T>::shrink(pointer p, size_type, size_type new_n) noexcept {
+   Header* header = _header(p);
+   size_type keep = _round_up(_header_bytes() + new_n * sizeof(T));
+   if (keep < header->committed) {
+      unsigned char* base = reinterpret_cast<unsigned char*>(header);
+      ::madvise(base + keep, header->committed - keep, MADV_DONTNEED);
+      ::mprotect(base + keep, header->committed - keep, PROT_NONE);
+      header->committed = keep;
+   }
+   return true;
+}
+
+template<typename T>
+typename mmap_allocator<T>::size_type mmap_allocator<T>::reserve_bytes() const noexcept {
+   return reserve_bytes_;
+}
+
+template<typename T>
+bool mmap_allocator<T>::huge_pages() const noexcept {
+   return huge_pages_;
+}
+
+template<typename T>
+typename mmap_allocator<T>::size_type mmap_allocator<T>::_page_size() noexcept {
+   static const size_type page_size = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+   return page_size;
+}
+
+template<typename T>
+typename mmap_allocator<T>::size_type mmap_allocator<T>::_round_up(size_type bytes) noexcept {
+   size_type page = _page_size();
+   return (bytes + page - 1) / page * page;
+}
+
+template<typename T>
+typename mmap_allocator<T>::size_type mmap_allocator<T>::_header_bytes() noexcept {
+   return _page_size();
+}
+
+template<typename T>
+typename mmap_allocator<T>::Header* mmap_allocator<T>::_header(pointer p) noexcept {
+   return reinterpret_cast<Header*>(reinterpret_cast<unsigned char*>(p) - _header_bytes());
+}
+
+} // namespace dsacpp
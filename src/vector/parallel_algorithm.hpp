@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "vector.hpp"
+#include "../thread_pool/thread_pool.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Parallel algorithms over vector's contiguous storage, run on a
+ * thread_pool (thread_pool::shared() when none is given). Work is split in
+ * halves recursively down to a grain of elements, so idle workers balance
+ * the load by stealing the larger, older halves.
+ *
+ * reduce() and inclusive_scan() regroup op, so it must be associative.
+ * The output vectors of transform(), inclusive_scan() and the scratch
+ * buffer of sort() are resized, which needs a default-constructible type.
+ */
+namespace parallel
+{
+
+// elements below which a range is not split further
+constexpr std::size_t MIN_GRAIN = 2048;
+
+template<typename T, typename A, typename G, typename F>
+void for_each(thread_pool& pool, vector<T, A, G>& v, F f);
+
+template<typename T, typename A, typename G, typename F>
+void for_each(vector<T, A, G>& v, F f);
+
+// out[i] = f(in[i]); out may be in
+template<typename T, typename A1, typename G1, typename U, typename A2, typename G2, typename F>
+void transform(thread_pool& pool, const vector<T, A1, G1>& in, vector<U, A2, G2>& out, F f);
+
+template<typename T, typename A1, typename G1, typename U, typename A2, typename G2, typename F>
+void transform(const vector<T, A1, G1>& in, vector<U, A2, G2>& out, F f);
+
+template<typename T, typename A, typename G, typename Op = std::plus<>>
+T reduce(thread_pool& pool, const vector<T, A, G>& v, T init, Op op = Op());
+
+template<typename T, typename A, typename G, typename Op = std::plus<>>
+T reduce(const vector<T, A, G>& v, T init, Op op = Op());
+
+// out[i] = in[0] op ... op in[i]; out may be in
+template<typename T, typename A1, typename G1, typename A2, typename G2, typename Op = std::plus<>>
+void inclusive_scan(thread_pool& pool, const vector<T, A1, G1>& in, vector<T, A2, G2>& out, Op op = Op());
+
+template<typename T, typename A1, typename G1, typename A2, typename G2, typename Op = std::plus<>>
+void inclusive_scan(const vector<T, A1, G1>& in, vector<T, A2, G2>& out, Op op = Op());
+
+// chunks sorted in parallel, then merged pairwise with a parallel merge
+template<typename T, typename A, typename G, typename Compare = std::less<>>
+void sort(thread_pool& pool, vector<T, A, G>& v, Compare comp = Compare());
+
+template<typename T, typename A, typename G, typename Compare = std::less<>>
+void sort(vector<T, A, G>& v, Compare comp = Compare());
+
+namespace detail
+{
+
+// about eight tasks per worker, but never below MIN_GRAIN elements
+inline std::size_t grain(const thread_pool& pool, std::size_t n) noexcept {
+   std::size_t g = n / (pool.size() * 8);
+   return g > MIN_GRAIN ? g : MIN_GRAIN;
+}
+
+// f(begin, end) over [begin, end) in pieces of at most grain
+template<typename F>
+void split(thread_pool& pool, std::size_t begin, std::size_t end, std::size_t grain, F& f) {
+   if (end - begin <= grain) {
+      if (begin != end) f(begin, end);
+      return;
+   }
+   std::size_t mid = begin + (end - begin) / 2;
+   task_group group(pool);
+   group.run([&pool, mid, end, grain, &f] { split(pool, mid, end, grain, f); });
+   split(pool, begin, mid, grain, f);
+   group.wait();
+}
+
+// [begin, end) of the i-th of count near-equal chunks of n
+inline std::size_t chunk_bound(std::size_t n, std::size_t count, std::size_t i) noexcept {
+   return n * i / count;
+}
+
+// stable merge of [a, a_end) and [b, b_end) moved into out
+template<typename T, typename Compare>
+void merge(thread_pool& pool, T* a, T* a_end, T* b, T* b_end, T* out, Compare& comp, std::size_t grain) {
+   std::size_t na = static_cast<std::size_t>(a_end - a);
+   std::size_t nb = static_cast<std::size_t>(b_end - b);
+   if (na + nb <= grain) {
+      std::merge(std::make_move_iterator(a), std::make_move_iterator(a_end),
+                 std::make_move_iterator(b), std::make_move_iterator(b_end), out, comp);
+      return;
+   }
+   // split the longer run at its middle and the other where that pivot lands
+   T* a_mid;
+   T* b_mid;
+   if (na >= nb) {
+      a_mid = a + na / 2;
+      b_mid = std::lower_bound(b, b_end, *a_mid, comp);
+   } else {
+      b_mid = b + nb / 2;
+      a_mid = std::upper_bound(a, a_end, *b_mid, comp);
+   }
+   T* out_mid = out + (a_mid - a) + (b_mid - b);
+   task_group group(pool);
+   group.run([&pool, a_mid, a_end, b_mid, b_end, out_mid, &comp, grain] {
+      merge(pool, a_mid, a_end, b_mid, b_end, out_mid, comp, grain);
+   });
+   merge(pool, a, a_mid, b, b_mid, out, comp, grain);
+   group.wait();
+}
+
+} // namespace detail
+
+template<typename T, typename A, typename G, typename F>
+void for_each(thread_pool& pool, vector<T, A, G>& v, F f) {
+   T* p = v.data();
+   auto body = [p, &f](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) f(p[i]);
+   };
+   detail::split(pool, 0, v.size(), detail::grain(pool, v.size()), body);
+}
+
+template<typename T, typename A, typename G, typename F>
+void for_each(vector<T, A, G>& v, F f) {
+   for_each(thread_pool::shared(), v, std::move(f));
+}
+
+template<typename T, typename A1, typename G1, typename U, typename A2, typename G2, typename F>
+void transform(thread_pool& pool, const vector<T, A1, G1>& in, vector<U, A2, G2>& out, F f) {
+   out.resize(in.size());
+   const T* src = in.data();
+   U* dst = out.data();
+   auto body = [src, dst, &f](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) dst[i] = f(src[i]);
+   };
+   detail::split(pool, 0, in.size(), detail::grain(pool, in.size()), body);
+}
+
+template<typename T, typename A1, typename G1, typename U, typename A2, typename G2, typename F>
+void transform(const vector<T, A1, G1>& in, vector<U, A2, G2>& out, F f) {
+   transform(thread_pool::shared(), in, out, std::move(f));
+}
+
+template<typename T, typename A, typename G, typename Op>
+T reduce(thread_pool& pool, const vector<T, A, G>& v, T init, Op op) {
+   std::size_t n = v.size();
+   if (n == 0) return init;
+   std::size_t chunks = (n + detail::grain(pool, n) - 1) / detail::grain(pool, n);
+   const T* p = v.data();
+   vector<T> partials(chunks, p[0]);
+   auto body = [&](std::size_t first, std::size_t last) {
+      for (std::size_t c = first; c < last; c++) {
+         std::size_t begin = detail::chunk_bound(n, chunks, c);
+         std::size_t end = detail::chunk_bound(n, chunks, c + 1);
+         T acc = p[begin];
+         for (std::size_t i = begin + 1; i < end; i++) acc = op(std::move(acc), p[i]);
+         partials[c] = std::move(acc);
+      }
+   };
+   detail::split(pool, 0, chunks, 1, body);
+   for (std::size_t c = 0; c < chunks; c++) {
+      init = op(std::move(init), partials[c]);
+   }
+   return init;
+}
+
+template<typename T, typename A, typename G, typename Op>
+T reduce(const vector<T, A, G>& v, T init, Op op) {
+   return reduce(thread_pool::shared(), v, std::move(init), std::move(op));
+}
+
+template<typename T, typename A1, typename G1, typename A2, typename G2, typename Op>
+void inclusive_scan(thread_pool& pool, const vector<T, A1, G1>& in, vector<T, A2, G2>& out, Op op) {
+   std::size_t n = in.size();
+   out.resize(n);
+   if (n == 0) return;
+   std::size_t chunks = (n + detail::grain(pool, n) - 1) / detail::grain(pool, n);
+   const T* src = in.data();
+   T* dst = out.data();
+
+   // pass one totals each chunk, a serial pass turns the totals into carries
+   vector<T> carries(chunks, src[0]);
+   auto total = [&](std::size_t first, std::size_t last) {
+      for (std::size_t c = first; c < last; c++) {
+         std::size_t begin = detail::chunk_bound(n, chunks, c);
+         std::size_t end = detail::chunk_bound(n, chunks, c + 1);
+         T acc = src[begin];
+         for (std::size_t i = begin + 1; i < end; i++) acc = op(std::move(acc), src[i]);
+         carries[c] = std::move(acc);
+      }
+   };
+   detail::split(pool, 0, chunks, 1, total);
+   for (std::size_t c = 1; c < chunks; c++) {
+      carries[c] = op(carries[c - 1], carries[c]);
+   }
+
+   // pass two rescans every chunk seeded with the carry of those before it
+   auto scan = [&](std::size_t first, std::size_t last) {
+      for (std::size_t c = first; c < last; c++) {
+         std::size_t begin = detail::chunk_bound(n, chunks, c);
+         std::size_t end = detail::chunk_bound(n, chunks, c + 1);
+         T acc = c == 0 ? src[begin] : op(carries[c - 1], src[begin]);
+         dst[begin] = acc;
+         for (std::size_t i = begin + 1; i < end; i++) {
+            acc = op(std::move(acc), src[i]);
+            dst[i] = acc;
+         }
+      }
+   };
+   detail::split(pool, 0, chunks, 1, scan);
+}
+
+template<typename T, typename A1, typename G1, typename A2, typename G2, typename Op>
+void inclusive_scan(const vector<T, A1, G1>& in, vector<T, A2, G2>& out, Op op) {
+   inclusive_scan(thread_pool::shared(), in, out, std::move(op));
+}
+
+template<typename T, typename A, typename G, typename Compare>
+void sort(thread_pool& pool, vector<T, A, G>& v, Compare comp) {
+   std::size_t n = v.size();
+   std::size_t grain = detail::grain(pool, n);
+   T* p = v.data();
+   if (pool.size() == 1 || n <= 2 * grain) {
+      std::sort(p, p + n, comp);
+      return;
+   }
+
+   // a power of two of runs, a few per worker, each at least a grain long
+   std::size_t runs = 1;
+   while (runs < pool.size() * 2 && n / (runs * 2) >= grain) runs *= 2;
+   auto sort_runs = [&](std::size_t first, std::size_t last) {
+      for (std::size_t r = first; r < last; r++) {
+         std::sort(p + detail::chunk_bound(n, runs, r), p + detail::chunk_bound(n, runs, r + 1), comp);
+      }
+   };
+   detail::split(pool, 0, runs, 1, sort_runs);
+
+   vector<T> buffer(n);
+   T* src = p;
+   T* dst = buffer.data();
+   for (std::size_t width = 1; width < runs; width *= 2) {
+      auto merge_pairs = [&](std::size_t first, std::size_t last) {
+         for (std::size_t pair = first; pair < last; pair++) {
+            std::size_t lo = detail::chunk_bound(n, runs, pair * 2 * width);
+            std::size_t mid = detail::chunk_bound(n, runs, pair * 2 * width + width);
+            std::size_t hi = detail::chunk_bound(n, runs, pair * 2 * width + 2 * width);
+            detail::merge(pool, src + lo, src + mid, src + mid, src + hi, dst + lo, comp, grain);
+         }
+      };
+      detail::split(pool, 0, runs / (2 * width), 1, merge_pairs);
+      std::swap(src, dst);
+   }
+
+   if (src != p) {
+      auto move_back = [src, p](std::size_t begin, std::size_t end) {
+         std::move(src + begin, src + end, p + begin);
+      };
+      detail::split(pool, 0, n, grain, move_back);
+   }
+}
+
+template<typename T, typename A, typename G, typename Compare>
+void sort(vector<T, A, G>& v, Compare comp) {
+   sort(thread_pool::shared(), v, std::move(comp));
+}
+
+} // namespace parallel
+
+} // namespace dsacpp
@@ -0,0 +1,1271 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "vector.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DSACPP_SIMD_X86 1
+#define DSACPP_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#else
+#define DSACPP_SIMD_X86 0
+#endif
+
+namespace dsacpp
+{
+
+/**
+ * Vectorized scans over arithmetic vectors. Kernels for int32_t, float and
+ * uint8_t (plus same-width types for equality searches) are selected at run
+ * time from SSE2, AVX2 and AVX-512 builds; every other element type, and
+ * every non-x86 target, takes the scalar path.
+ *
+ * Floating point reductions reassociate, so accumulate() on floats may
+ * differ from a sequential sum in the last bits, and minmax() leaves the
+ * result unspecified when the data contains NaN.
+ */
+namespace simd
+{
+
+enum class level { scalar, sse2, avx2, avx512 };
+
+enum class compare { equal, not_equal, less, less_equal, greater, greater_equal };
+
+// best level this CPU supports
+level detected_level() noexcept;
+
+// level used by the algorithms below, detected_level() unless lowered
+level active_level() noexcept;
+
+// force a lower level, e.g. to compare kernels; clamped to detected_level()
+void set_active_level(level requested) noexcept;
+
+/**
+ * Algorithms
+ */
+
+template<typename T, typename A, typename G>
+typename vector<T, A, G>::const_iterator find(const vector<T, A, G>& v, const T& value);
+
+template<typename T, typename A, typename G>
+std::size_t count(const vector<T, A, G>& v, const T& value);
+
+// sums into a widened type: int64_t for signed, uint64_t for unsigned, T for floats
+template<typename T, typename A, typename G>
+auto accumulate(const vector<T, A, G>& v);
+
+// throws std::out_of_range on an empty vector
+template<typename T, typename A, typename G>
+std::pair<T, T> minmax(const vector<T, A, G>& v);
+
+template<typename T, typename A1, typename G1, typename A2, typename G2>
+bool equal(const vector<T, A1, G1>& a, const vector<T, A2, G2>& b);
+
+// first occurrence of needle in haystack, or haystack.end()
+template<typename A1, typename G1, typename A2, typename G2>
+typename vector<std::uint8_t, A1, G1>::const_iterator search(
+   const vector<std::uint8_t, A1, G1>& haystack,
+   const vector<std::uint8_t, A2, G2>& needle);
+
+// append every x with (x op threshold) to out, returning how many were appended
+template<typename T, typename A1, typename G1, typename A2, typename G2>
+std::size_t filter(const vector<T, A1, G1>& in, compare op, const T& threshold, vector<T, A2, G2>& out);
+
+// the same scans over any contiguous range, e.g. a column_span of soa_vector
+
+template<typename T>
+const T* find(const T* first, const T* last, const T& value);
+
+template<typename T>
+std::size_t count(const T* first, const T* last, const T& value);
+
+template<typename T>
+auto accumulate(const T* first, const T* last);
+
+// throws std::out_of_range on an empty range
+template<typename T>
+std::pair<T, T> minmax(const T* first, const T* last);
+
+namespace detail
+{
+
+template<typename T>
+using sum_t = std::conditional_t<
+   std::is_floating_point<T>::value,
+   T,
+   std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>
+>;
+
+template<typename T>
+inline bool apply(compare op, const T& x, const T& threshold) noexcept {
+   switch (op) {
+      case compare::equal:          return x == threshold;
+      case compare::not_equal:      return x != threshold;
+      case compare::less:           return x < threshold;
+      case compare::less_equal:     return x <= threshold;
+      case compare::greater:        return x > threshold;
+      case compare::greater_equal:  return x >= threshold;
+   }
+   return false;
+}
+
+inline std::atomic<level>& active() noexcept {
+   static std::atomic<level> current{ detected_level() };
+   return current;
+}
+
+/**
+ * Scalar kernels
+ */
+
+template<typename T>
+inline std::size_t find_scalar(const T* p, std::size_t n, T value) noexcept {
+   for (std::size_t i = 0; i < n; i++) {
+      if (p[i] == value) return i;
+   }
+   return n;
+}
+
+template<typename T>
+inline std::size_t count_scalar(const T* p, std::size_t n, T value) noexcept {
+   std::size_t total = 0;
+   for (std::size_t i = 0; i < n; i++) {
+      total += p[i] == value;
+   }
+   return total;
+}
+
+template<typename T>
+inline sum_t<T> sum_scalar(const T* p, std::size_t n) noexcept {
+   sum_t<T> total = 0;
+   for (std::size_t i = 0; i < n; i++) {
+      total += p[i];
+   }
+   return total;
+}
+
+template<typename T>
+inline std::pair<T, T> minmax_scalar(const T* p, std::size_t n) noexcept {
+   T lo = p[0];
+   T hi = p[0];
+   for (std::size_t i = 1; i < n; i++) {
+      lo = p[i] < lo ? p[i] : lo;
+      hi = hi < p[i] ? p[i] : hi;
+   }
+   return { lo, hi };
+}
+
+inline std::size_t search_scalar(const std::uint8_t* p, std::size_t n, const std::uint8_t* needle, std::size_t m) noexcept {
+   for (std::size_t i = 0; i + m <= n; i++) {
+      if (p[i] == needle[0] && std::memcmp(p + i + 1, needle + 1, m - 1) == 0) return i;
+   }
+   return n;
+}
+
+// branch-free compaction, also the tail of every vector filter
+template<typename T>
+inline std::size_t filter_scalar(const T* p, std::size_t n, compare op, T threshold, T* out) noexcept {
+   std::size_t k = 0;
+   for (std::size_t i = 0; i < n; i++) {
+      out[k] = p[i];
+      k += apply(op, p[i], threshold);
+   }
+   return k;
+}
+
+#if DSACPP_SIMD_X86
+
+/**
+ * SSE2 kernels
+ */
+
+DSACPP_TARGET("sse2") inline std::size_t find_u8_sse2(const std::uint8_t* p, std::size_t n, std::uint8_t value) noexcept {
+   const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, needle)));
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("sse2") inline std::size_t find_i32_sse2(const std::int32_t* p, std::size_t n, std::int32_t value) noexcept {
+   const __m128i needle = _mm_set1_epi32(value);
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, needle))));
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("sse2") inline std::size_t find_f32_sse2(const float* p, std::size_t n, float value) noexcept {
+   const __m128 needle = _mm_set1_ps(value);
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(p + i), needle)));
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("sse2") inline std::size_t count_u8_sse2(const std::uint8_t* p, std::size_t n, std::uint8_t value) noexcept {
+   const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+   const __m128i zero = _mm_setzero_si128();
+   std::size_t total = 0;
+   std::size_t i = 0;
+   while (i + 16 <= n) {
+      // byte lanes count down from 0 and would wrap after 255 blocks
+      std::size_t blocks = (n - i) / 16 < 255 ? (n - i) / 16 : 255;
+      __m128i lanes = zero;
+      for (std::size_t b = 0; b < blocks; b++, i += 16) {
+         __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+         lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(x, needle));
+      }
+      alignas(16) std::uint64_t sums[2];
+      _mm_store_si128(reinterpret_cast<__m128i*>(sums), _mm_sad_epu8(lanes, zero));
+      total += sums[0] + sums[1];
+   }
+   return total + count_scalar(p + i, n - i, value);
+}
+
+// matching lanes are -1, so subtracting counts per lane without a popcount
+DSACPP_TARGET("sse2") inline std::size_t count_lanes_sse2(__m128i lanes) noexcept {
+   alignas(16) std::uint32_t counts[4];
+   _mm_store_si128(reinterpret_cast<__m128i*>(counts), lanes);
+   return std::size_t{ counts[0] } + counts[1] + counts[2] + counts[3];
+}
+
+DSACPP_TARGET("sse2") inline std::size_t count_i32_sse2(const std::int32_t* p, std::size_t n, std::int32_t value) noexcept {
+   const __m128i needle = _mm_set1_epi32(value);
+   __m128i lanes = _mm_setzero_si128();
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      lanes = _mm_sub_epi32(lanes, _mm_cmpeq_epi32(x, needle));
+   }
+   return count_lanes_sse2(lanes) + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("sse2") inline std::size_t count_f32_sse2(const float* p, std::size_t n, float value) noexcept {
+   const __m128 needle = _mm_set1_ps(value);
+   __m128i lanes = _mm_setzero_si128();
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      lanes = _mm_sub_epi32(lanes, _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(p + i), needle)));
+   }
+   return count_lanes_sse2(lanes) + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("sse2") inline std::uint64_t sum_u8_sse2(const std::uint8_t* p, std::size_t n) noexcept {
+   const __m128i zero = _mm_setzero_si128();
+   __m128i acc = zero;
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(x, zero));
+   }
+   alignas(16) std::uint64_t sums[2];
+   _mm_store_si128(reinterpret_cast<__m128i*>(sums), acc);
+   return sums[0] + sums[1] + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("sse2") inline std::int64_t sum_i32_sse2(const std::int32_t* p, std::size_t n) noexcept {
+   __m128i acc = _mm_setzero_si128();
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      __m128i sign = _mm_srai_epi32(x, 31);
+      acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, sign));
+      acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(x, sign));
+   }
+   alignas(16) std::int64_t sums[2];
+   _mm_store_si128(reinterpret_cast<__m128i*>(sums), acc);
+   return sums[0] + sums[1] + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("sse2") inline float sum_f32_sse2(const float* p, std::size_t n) noexcept {
+   __m128 acc0 = _mm_setzero_ps();
+   __m128 acc1 = _mm_setzero_ps();
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      acc0 = _mm_add_ps(acc0, _mm_loadu_ps(p + i));
+      acc1 = _mm_add_ps(acc1, _mm_loadu_ps(p + i + 4));
+   }
+   alignas(16) float sums[4];
+   _mm_store_ps(sums, _mm_add_ps(acc0, acc1));
+   return (sums[0] + sums[1]) + (sums[2] + sums[3]) + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("sse2") inline std::pair<std::uint8_t, std::uint8_t> minmax_u8_sse2(const std::uint8_t* p, std::size_t n) noexcept {
+   if (n < 16) return minmax_scalar(p, n);
+   __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+   __m128i hi = lo;
+   std::size_t i = 16;
+   for (; i + 16 <= n; i += 16) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      lo = _mm_min_epu8(lo, x);
+      hi = _mm_max_epu8(hi, x);
+   }
+   // fold the ragged tail in by rescanning the last full block
+   __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n - 16));
+   lo = _mm_min_epu8(lo, x);
+   hi = _mm_max_epu8(hi, x);
+   alignas(16) std::uint8_t los[16];
+   alignas(16) std::uint8_t his[16];
+   _mm_store_si128(reinterpret_cast<__m128i*>(los), lo);
+   _mm_store_si128(reinterpret_cast<__m128i*>(his), hi);
+   return { minmax_scalar(los, 16).first, minmax_scalar(his, 16).second };
+}
+
+DSACPP_TARGET("sse2") inline std::pair<std::int32_t, std::int32_t> minmax_i32_sse2(const std::int32_t* p, std::size_t n) noexcept {
+   if (n < 4) return minmax_scalar(p, n);
+   __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+   __m128i hi = lo;
+   for (std::size_t i = 4; i < n; i += 4) {
+      std::size_t at = i + 4 <= n ? i : n - 4;
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + at));
+      // SSE2 has no pminsd/pmaxsd; select through the compare mask
+      __m128i lt = _mm_cmplt_epi32(x, lo);
+      lo = _mm_or_si128(_mm_and_si128(lt, x), _mm_andnot_si128(lt, lo));
+      __m128i gt = _mm_cmpgt_epi32(x, hi);
+      hi = _mm_or_si128(_mm_and_si128(gt, x), _mm_andnot_si128(gt, hi));
+   }
+   alignas(16) std::int32_t los[4];
+   alignas(16) std::int32_t his[4];
+   _mm_store_si128(reinterpret_cast<__m128i*>(los), lo);
+   _mm_store_si128(reinterpret_cast<__m128i*>(his), hi);
+   return { minmax_scalar(los, 4).first, minmax_scalar(his, 4).second };
+}
+
+DSACPP_TARGET("sse2") inline std::pair<float, float> minmax_f32_sse2(const float* p, std::size_t n) noexcept {
+   if (n < 4) return minmax_scalar(p, n);
+   __m128 lo = _mm_loadu_ps(p);
+   __m128 hi = lo;
+   for (std::size_t i = 4; i < n; i += 4) {
+      __m128 x = _mm_loadu_ps(p + (i + 4 <= n ? i : n - 4));
+      lo = _mm_min_ps(lo, x);
+      hi = _mm_max_ps(hi, x);
+   }
+   alignas(16) float los[4];
+   alignas(16) float his[4];
+   _mm_store_ps(los, lo);
+   _mm_store_ps(his, hi);
+   return { minmax_scalar(los, 4).first, minmax_scalar(his, 4).second };
+}
+
+DSACPP_TARGET("sse2") inline bool equal_f32_sse2(const float* a, const float* b, std::size_t n) noexcept {
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      if (_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i))) != 0xF) return false;
+   }
+   for (; i < n; i++) {
+      if (!(a[i] == b[i])) return false;
+   }
+   return true;
+}
+
+DSACPP_TARGET("sse2") inline std::size_t search_sse2(const std::uint8_t* p, std::size_t n, const std::uint8_t* needle, std::size_t m) noexcept {
+   // compare the first and last needle byte at once, verify candidates with memcmp
+   const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+   const __m128i last = _mm_set1_epi8(static_cast<char>(needle[m - 1]));
+   std::size_t i = 0;
+   for (; i + m - 1 + 16 <= n; i += 16) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + m - 1));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+      while (mask) {
+         std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(mask));
+         if (std::memcmp(p + at + 1, needle + 1, m - 2) == 0) return at;
+         mask &= mask - 1;
+      }
+   }
+   std::size_t rest = search_scalar(p + i, n - i, needle, m);
+   return rest == n - i ? n : i + rest;
+}
+
+DSACPP_TARGET("sse2") inline __m128i cmp_i32_sse2(__m128i x, __m128i t, compare op) noexcept {
+   switch (op) {
+      case compare::equal:          return _mm_cmpeq_epi32(x, t);
+      case compare::not_equal:      return _mm_xor_si128(_mm_cmpeq_epi32(x, t), _mm_set1_epi32(-1));
+      case compare::less:           return _mm_cmplt_epi32(x, t);
+      case compare::less_equal:     return _mm_xor_si128(_mm_cmpgt_epi32(x, t), _mm_set1_epi32(-1));
+      case compare::greater:        return _mm_cmpgt_epi32(x, t);
+      case compare::greater_equal:  return _mm_xor_si128(_mm_cmplt_epi32(x, t), _mm_set1_epi32(-1));
+   }
+   return _mm_setzero_si128();
+}
+
+DSACPP_TARGET("sse2") inline __m128 cmp_f32_sse2(__m128 x, __m128 t, compare op) noexcept {
+   switch (op) {
+      case compare::equal:          return _mm_cmpeq_ps(x, t);
+      case compare::not_equal:      return _mm_cmpneq_ps(x, t);
+      case compare::less:           return _mm_cmplt_ps(x, t);
+      case compare::less_equal:     return _mm_cmple_ps(x, t);
+      case compare::greater:        return _mm_cmpgt_ps(x, t);
+      case compare::greater_equal:  return _mm_cmpge_ps(x, t);
+   }
+   return _mm_setzero_ps();
+}
+
+template<typename T>
+inline std::size_t compact_bits(const T* p, unsigned mask, T* out) noexcept {
+   std::size_t k = 0;
+   while (mask) {
+      out[k++] = p[__builtin_ctz(mask)];
+      mask &= mask - 1;
+   }
+   return k;
+}
+
+DSACPP_TARGET("sse2") inline std::size_t filter_i32_sse2(const std::int32_t* p, std::size_t n, compare op, std::int32_t threshold, std::int32_t* out) noexcept {
+   const __m128i t = _mm_set1_epi32(threshold);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(cmp_i32_sse2(x, t, op))));
+      k += compact_bits(p + i, mask, out + k);
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+DSACPP_TARGET("sse2") inline std::size_t filter_f32_sse2(const float* p, std::size_t n, compare op, float threshold, float* out) noexcept {
+   const __m128 t = _mm_set1_ps(threshold);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      unsigned mask = static_cast<unsigned>(_mm_movemask_ps(cmp_f32_sse2(_mm_loadu_ps(p + i), t, op)));
+      k += compact_bits(p + i, mask, out + k);
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+DSACPP_TARGET("sse2") inline __m128i cmp_u8_sse2(__m128i x, __m128i t, compare op) noexcept {
+   // unsigned byte order through min/max: x <= t iff min(x, t) == x
+   const __m128i ones = _mm_set1_epi8(-1);
+   __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(x, t), x);
+   __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(x, t), x);
+   switch (op) {
+      case compare::equal:          return _mm_cmpeq_epi8(x, t);
+      case compare::not_equal:      return _mm_xor_si128(_mm_cmpeq_epi8(x, t), ones);
+      case compare::less:           return _mm_xor_si128(ge, ones);
+      case compare::less_equal:     return le;
+      case compare::greater:        return _mm_xor_si128(le, ones);
+      case compare::greater_equal:  return ge;
+   }
+   return _mm_setzero_si128();
+}
+
+DSACPP_TARGET("sse2") inline std::size_t filter_u8_sse2(const std::uint8_t* p, std::size_t n, compare op, std::uint8_t threshold, std::uint8_t* out) noexcept {
+   const __m128i t = _mm_set1_epi8(static_cast<char>(threshold));
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      k += compact_bits(p + i, static_cast<unsigned>(_mm_movemask_epi8(cmp_u8_sse2(x, t, op))), out + k);
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+/**
+ * AVX2 kernels
+ */
+
+// lane permutations that pack the set lanes of an 8-bit mask to the front
+struct compress_table_8x32 {
+   alignas(32) std::uint32_t lanes[256][8];
+
+   constexpr compress_table_8x32() : lanes{} {
+      for (unsigned mask = 0; mask < 256; mask++) {
+         unsigned k = 0;
+         for (unsigned lane = 0; lane < 8; lane++) {
+            if (mask & (1u << lane)) lanes[mask][k++] = lane;
+         }
+         while (k < 8) lanes[mask][k++] = 0;
+      }
+   }
+};
+
+inline constexpr compress_table_8x32 COMPRESS_8X32{};
+
+DSACPP_TARGET("avx2") inline std::size_t find_u8_avx2(const std::uint8_t* p, std::size_t n, std::uint8_t value) noexcept {
+   const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+   std::size_t i = 0;
+   for (; i + 32 <= n; i += 32) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, needle)));
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_u8_sse2(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx2") inline std::size_t find_i32_avx2(const std::int32_t* p, std::size_t n, std::int32_t value) noexcept {
+   const __m256i needle = _mm256_set1_epi32(value);
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, needle))));
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx2") inline std::size_t find_f32_avx2(const float* p, std::size_t n, float value) noexcept {
+   const __m256 needle = _mm256_set1_ps(value);
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p + i), needle, _CMP_EQ_OQ)));
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx2") inline std::size_t count_u8_avx2(const std::uint8_t* p, std::size_t n, std::uint8_t value) noexcept {
+   const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+   const __m256i zero = _mm256_setzero_si256();
+   __m256i totals = zero;
+   std::size_t i = 0;
+   while (i + 32 <= n) {
+      std::size_t blocks = (n - i) / 32 < 255 ? (n - i) / 32 : 255;
+      __m256i lanes = zero;
+      for (std::size_t b = 0; b < blocks; b++, i += 32) {
+         __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+         lanes = _mm256_sub_epi8(lanes, _mm256_cmpeq_epi8(x, needle));
+      }
+      totals = _mm256_add_epi64(totals, _mm256_sad_epu8(lanes, zero));
+   }
+   alignas(32) std::uint64_t sums[4];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(sums), totals);
+   return static_cast<std::size_t>(sums[0] + sums[1] + sums[2] + sums[3]) + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx2,popcnt") inline std::size_t count_i32_avx2(const std::int32_t* p, std::size_t n, std::int32_t value) noexcept {
+   const __m256i needle = _mm256_set1_epi32(value);
+   std::size_t total = 0;
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      total += static_cast<std::size_t>(_mm_popcnt_u32(
+         static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, needle))))));
+   }
+   return total + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx2,popcnt") inline std::size_t count_f32_avx2(const float* p, std::size_t n, float value) noexcept {
+   const __m256 needle = _mm256_set1_ps(value);
+   std::size_t total = 0;
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      total += static_cast<std::size_t>(_mm_popcnt_u32(
+         static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p + i), needle, _CMP_EQ_OQ)))));
+   }
+   return total + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx2") inline std::uint64_t sum_u8_avx2(const std::uint8_t* p, std::size_t n) noexcept {
+   const __m256i zero = _mm256_setzero_si256();
+   __m256i acc = zero;
+   std::size_t i = 0;
+   for (; i + 32 <= n; i += 32) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(x, zero));
+   }
+   alignas(32) std::uint64_t sums[4];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(sums), acc);
+   return sums[0] + sums[1] + sums[2] + sums[3] + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("avx2") inline std::int64_t sum_i32_avx2(const std::int32_t* p, std::size_t n) noexcept {
+   __m256i acc0 = _mm256_setzero_si256();
+   __m256i acc1 = _mm256_setzero_si256();
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))));
+      acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 4))));
+   }
+   alignas(32) std::int64_t sums[4];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(sums), _mm256_add_epi64(acc0, acc1));
+   return sums[0] + sums[1] + sums[2] + sums[3] + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("avx2") inline float sum_f32_avx2(const float* p, std::size_t n) noexcept {
+   __m256 acc0 = _mm256_setzero_ps();
+   __m256 acc1 = _mm256_setzero_ps();
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(p + i));
+      acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(p + i + 8));
+   }
+   alignas(32) float sums[8];
+   _mm256_store_ps(sums, _mm256_add_ps(acc0, acc1));
+   return ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]))
+      + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("avx2") inline std::pair<std::uint8_t, std::uint8_t> minmax_u8_avx2(const std::uint8_t* p, std::size_t n) noexcept {
+   if (n < 32) return minmax_u8_sse2(p, n);
+   __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+   __m256i hi = lo;
+   for (std::size_t i = 32; i < n; i += 32) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + (i + 32 <= n ? i : n - 32)));
+      lo = _mm256_min_epu8(lo, x);
+      hi = _mm256_max_epu8(hi, x);
+   }
+   alignas(32) std::uint8_t los[32];
+   alignas(32) std::uint8_t his[32];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(los), lo);
+   _mm256_store_si256(reinterpret_cast<__m256i*>(his), hi);
+   return { minmax_scalar(los, 32).first, minmax_scalar(his, 32).second };
+}
+
+DSACPP_TARGET("avx2") inline std::pair<std::int32_t, std::int32_t> minmax_i32_avx2(const std::int32_t* p, std::size_t n) noexcept {
+   if (n < 8) return minmax_scalar(p, n);
+   __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+   __m256i hi = lo;
+   for (std::size_t i = 8; i < n; i += 8) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + (i + 8 <= n ? i : n - 8)));
+      lo = _mm256_min_epi32(lo, x);
+      hi = _mm256_max_epi32(hi, x);
+   }
+   alignas(32) std::int32_t los[8];
+   alignas(32) std::int32_t his[8];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(los), lo);
+   _mm256_store_si256(reinterpret_cast<__m256i*>(his), hi);
+   return { minmax_scalar(los, 8).first, minmax_scalar(his, 8).second };
+}
+
+DSACPP_TARGET("avx2") inline std::pair<float, float> minmax_f32_avx2(const float* p, std::size_t n) noexcept {
+   if (n < 8) return minmax_scalar(p, n);
+   __m256 lo = _mm256_loadu_ps(p);
+   __m256 hi = lo;
+   for (std::size_t i = 8; i < n; i += 8) {
+      __m256 x = _mm256_loadu_ps(p + (i + 8 <= n ? i : n - 8));
+      lo = _mm256_min_ps(lo, x);
+      hi = _mm256_max_ps(hi, x);
+   }
+   alignas(32) float los[8];
+   alignas(32) float his[8];
+   _mm256_store_ps(los, lo);
+   _mm256_store_ps(his, hi);
+   return { minmax_scalar(los, 8).first, minmax_scalar(his, 8).second };
+}
+
+DSACPP_TARGET("avx2") inline bool equal_f32_avx2(const float* a, const float* b, std::size_t n) noexcept {
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), _CMP_EQ_OQ)) != 0xFF) return false;
+   }
+   return equal_f32_sse2(a + i, b + i, n - i);
+}
+
+DSACPP_TARGET("avx2") inline std::size_t search_avx2(const std::uint8_t* p, std::size_t n, const std::uint8_t* needle, std::size_t m) noexcept {
+   const __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+   const __m256i last = _mm256_set1_epi8(static_cast<char>(needle[m - 1]));
+   std::size_t i = 0;
+   for (; i + m - 1 + 32 <= n; i += 32) {
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + m - 1));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+      while (mask) {
+         std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(mask));
+         if (std::memcmp(p + at + 1, needle + 1, m - 2) == 0) return at;
+         mask &= mask - 1;
+      }
+   }
+   std::size_t rest = search_sse2(p + i, n - i, needle, m);
+   return rest == n - i ? n : i + rest;
+}
+
+DSACPP_TARGET("avx2") inline __m256i cmp_i32_avx2(__m256i x, __m256i t, compare op) noexcept {
+   const __m256i ones = _mm256_set1_epi32(-1);
+   switch (op) {
+      case compare::equal:          return _mm256_cmpeq_epi32(x, t);
+      case compare::not_equal:      return _mm256_xor_si256(_mm256_cmpeq_epi32(x, t), ones);
+      case compare::less:           return _mm256_cmpgt_epi32(t, x);
+      case compare::less_equal:     return _mm256_xor_si256(_mm256_cmpgt_epi32(x, t), ones);
+      case compare::greater:        return _mm256_cmpgt_epi32(x, t);
+      case compare::greater_equal:  return _mm256_xor_si256(_mm256_cmpgt_epi32(t, x), ones);
+   }
+   return _mm256_setzero_si256();
+}
+
+DSACPP_TARGET("avx2") inline __m256 cmp_f32_avx2(__m256 x, __m256 t, compare op) noexcept {
+   switch (op) {
+      case compare::equal:          return _mm256_cmp_ps(x, t, _CMP_EQ_OQ);
+      case compare::not_equal:      return _mm256_cmp_ps(x, t, _CMP_NEQ_UQ);
+      case compare::less:           return _mm256_cmp_ps(x, t, _CMP_LT_OQ);
+      case compare::less_equal:     return _mm256_cmp_ps(x, t, _CMP_LE_OQ);
+      case compare::greater:        return _mm256_cmp_ps(x, t, _CMP_GT_OQ);
+      case compare::greater_equal:  return _mm256_cmp_ps(x, t, _CMP_GE_OQ);
+   }
+   return _mm256_setzero_ps();
+}
+
+// out needs 8 writable slots past the last kept element; filter() sizes it for that
+DSACPP_TARGET("avx2,popcnt") inline std::size_t filter_i32_avx2(const std::int32_t* p, std::size_t n, compare op, std::int32_t threshold, std::int32_t* out) noexcept {
+   const __m256i t = _mm256_set1_epi32(threshold);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(cmp_i32_avx2(x, t, op))));
+      __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPRESS_8X32.lanes[mask]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k), _mm256_permutevar8x32_epi32(x, perm));
+      k += static_cast<std::size_t>(_mm_popcnt_u32(mask));
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+DSACPP_TARGET("avx2,popcnt") inline std::size_t filter_f32_avx2(const float* p, std::size_t n, compare op, float threshold, float* out) noexcept {
+   const __m256 t = _mm256_set1_ps(threshold);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256 x = _mm256_loadu_ps(p + i);
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(cmp_f32_avx2(x, t, op)));
+      __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPRESS_8X32.lanes[mask]));
+      _mm256_storeu_ps(out + k, _mm256_permutevar8x32_ps(x, perm));
+      k += static_cast<std::size_t>(_mm_popcnt_u32(mask));
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+DSACPP_TARGET("avx2") inline std::size_t filter_u8_avx2(const std::uint8_t* p, std::size_t n, compare op, std::uint8_t threshold, std::uint8_t* out) noexcept {
+   const __m256i t = _mm256_set1_epi8(static_cast<char>(threshold));
+   const __m256i ones = _mm256_set1_epi8(-1);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 32 <= n; i += 32) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+      __m256i le = _mm256_cmpeq_epi8(_mm256_min_epu8(x, t), x);
+      __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(x, t), x);
+      __m256i m;
+      switch (op) {
+         case compare::equal:          m = _mm256_cmpeq_epi8(x, t); break;
+         case compare::not_equal:      m = _mm256_xor_si256(_mm256_cmpeq_epi8(x, t), ones); break;
+         case compare::less:           m = _mm256_xor_si256(ge, ones); break;
+         case compare::less_equal:     m = le; break;
+         case compare::greater:        m = _mm256_xor_si256(le, ones); break;
+         default:                      m = ge; break;
+      }
+      k += compact_bits(p + i, static_cast<unsigned>(_mm256_movemask_epi8(m)), out + k);
+   }
+   return k + filter_u8_sse2(p + i, n - i, op, threshold, out + k);
+}
+
+/**
+ * AVX-512 kernels (F + BW)
+ */
+
+// GCC 12's AVX-512 headers self-initialize their undefined vectors (PR105593)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+DSACPP_TARGET("avx512f,avx512bw") inline std::size_t find_u8_avx512(const std::uint8_t* p, std::size_t n, std::uint8_t value) noexcept {
+   const __m512i needle = _mm512_set1_epi8(static_cast<char>(value));
+   std::size_t i = 0;
+   for (; i + 64 <= n; i += 64) {
+      __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p + i), needle);
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctzll(mask));
+   }
+   if (i < n) {
+      __mmask64 live = _cvtu64_mask64(~0ull >> (64 - (n - i)));
+      __mmask64 mask = _mm512_mask_cmpeq_epi8_mask(live, _mm512_maskz_loadu_epi8(live, p + i), needle);
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctzll(mask));
+   }
+   return n;
+}
+
+DSACPP_TARGET("avx512f") inline std::size_t find_i32_avx512(const std::int32_t* p, std::size_t n, std::int32_t value) noexcept {
+   const __m512i needle = _mm512_set1_epi32(value);
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(p + i), needle);
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   if (i < n) {
+      __mmask16 live = static_cast<__mmask16>((1u << (n - i)) - 1);
+      __mmask16 mask = _mm512_mask_cmpeq_epi32_mask(live, _mm512_maskz_loadu_epi32(live, p + i), needle);
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return n;
+}
+
+DSACPP_TARGET("avx512f") inline std::size_t find_f32_avx512(const float* p, std::size_t n, float value) noexcept {
+   const __m512 needle = _mm512_set1_ps(value);
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(p + i), needle, _CMP_EQ_OQ);
+      if (mask) return i + static_cast<std::size_t>(__builtin_ctz(mask));
+   }
+   return i + find_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx512f,avx512bw,popcnt") inline std::size_t count_u8_avx512(const std::uint8_t* p, std::size_t n, std::uint8_t value) noexcept {
+   const __m512i needle = _mm512_set1_epi8(static_cast<char>(value));
+   std::size_t total = 0;
+   std::size_t i = 0;
+   for (; i + 64 <= n; i += 64) {
+      total += static_cast<std::size_t>(_mm_popcnt_u64(_cvtmask64_u64(_mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p + i), needle))));
+   }
+   return total + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx512f,popcnt") inline std::size_t count_i32_avx512(const std::int32_t* p, std::size_t n, std::int32_t value) noexcept {
+   const __m512i needle = _mm512_set1_epi32(value);
+   std::size_t total = 0;
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      total += static_cast<std::size_t>(_mm_popcnt_u32(_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(p + i), needle)));
+   }
+   return total + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx512f,popcnt") inline std::size_t count_f32_avx512(const float* p, std::size_t n, float value) noexcept {
+   const __m512 needle = _mm512_set1_ps(value);
+   std::size_t total = 0;
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      total += static_cast<std::size_t>(_mm_popcnt_u32(_mm512_cmp_ps_mask(_mm512_loadu_ps(p + i), needle, _CMP_EQ_OQ)));
+   }
+   return total + count_scalar(p + i, n - i, value);
+}
+
+DSACPP_TARGET("avx512f,avx512bw") inline std::uint64_t sum_u8_avx512(const std::uint8_t* p, std::size_t n) noexcept {
+   const __m512i zero = _mm512_setzero_si512();
+   __m512i acc = zero;
+   std::size_t i = 0;
+   for (; i + 64 <= n; i += 64) {
+      acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_loadu_si512(p + i), zero));
+   }
+   alignas(64) std::uint64_t sums[8];
+   _mm512_store_si512(sums, acc);
+   return sum_scalar(sums, 8) + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("avx512f") inline std::int64_t sum_i32_avx512(const std::int32_t* p, std::size_t n) noexcept {
+   __m512i acc0 = _mm512_setzero_si512();
+   __m512i acc1 = _mm512_setzero_si512();
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i))));
+      acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 8))));
+   }
+   alignas(64) std::int64_t sums[8];
+   _mm512_store_si512(sums, _mm512_add_epi64(acc0, acc1));
+   std::int64_t total = 0;
+   for (std::int64_t s : sums) total += s;
+   return total + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("avx512f") inline float sum_f32_avx512(const float* p, std::size_t n) noexcept {
+   __m512 acc0 = _mm512_setzero_ps();
+   __m512 acc1 = _mm512_setzero_ps();
+   std::size_t i = 0;
+   for (; i + 32 <= n; i += 32) {
+      acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(p + i));
+      acc1 = _mm512_add_ps(acc1, _mm512_loadu_ps(p + i + 16));
+   }
+   alignas(64) float sums[16];
+   _mm512_store_ps(sums, _mm512_add_ps(acc0, acc1));
+   return sum_scalar(sums, 16) + sum_scalar(p + i, n - i);
+}
+
+DSACPP_TARGET("avx512f,avx512bw") inline std::pair<std::uint8_t, std::uint8_t> minmax_u8_avx512(const std::uint8_t* p, std::size_t n) noexcept {
+   if (n < 64) return minmax_scalar(p, n);
+   __m512i lo = _mm512_loadu_si512(p);
+   __m512i hi = lo;
+   for (std::size_t i = 64; i < n; i += 64) {
+      __m512i x = _mm512_loadu_si512(p + (i + 64 <= n ? i : n - 64));
+      lo = _mm512_min_epu8(lo, x);
+      hi = _mm512_max_epu8(hi, x);
+   }
+   alignas(64) std::uint8_t los[64];
+   alignas(64) std::uint8_t his[64];
+   _mm512_store_si512(los, lo);
+   _mm512_store_si512(his, hi);
+   return { minmax_scalar(los, 64).first, minmax_scalar(his, 64).second };
+}
+
+DSACPP_TARGET("avx512f") inline std::pair<std::int32_t, std::int32_t> minmax_i32_avx512(const std::int32_t* p, std::size_t n) noexcept {
+   if (n < 16) return minmax_scalar(p, n);
+   __m512i lo = _mm512_loadu_si512(p);
+   __m512i hi = lo;
+   for (std::size_t i = 16; i < n; i += 16) {
+      __m512i x = _mm512_loadu_si512(p + (i + 16 <= n ? i : n - 16));
+      lo = _mm512_min_epi32(lo, x);
+      hi = _mm512_max_epi32(hi, x);
+   }
+   alignas(64) std::int32_t los[16];
+   alignas(64) std::int32_t his[16];
+   _mm512_store_si512(los, lo);
+   _mm512_store_si512(his, hi);
+   return { minmax_scalar(los, 16).first, minmax_scalar(his, 16).second };
+}
+
+DSACPP_TARGET("avx512f") inline std::pair<float, float> minmax_f32_avx512(const float* p, std::size_t n) noexcept {
+   if (n < 16) return minmax_scalar(p, n);
+   __m512 lo = _mm512_loadu_ps(p);
+   __m512 hi = lo;
+   for (std::size_t i = 16; i < n; i += 16) {
+      __m512 x = _mm512_loadu_ps(p + (i + 16 <= n ? i : n - 16));
+      lo = _mm512_min_ps(lo, x);
+      hi = _mm512_max_ps(hi, x);
+   }
+   alignas(64) float los[16];
+   alignas(64) float his[16];
+   _mm512_store_ps(los, lo);
+   _mm512_store_ps(his, hi);
+   return { minmax_scalar(los, 16).first, minmax_scalar(his, 16).second };
+}
+
+DSACPP_TARGET("avx512f") inline bool equal_f32_avx512(const float* a, const float* b, std::size_t n) noexcept {
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      if (_mm512_cmp_ps_mask(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), _CMP_EQ_OQ) != 0xFFFF) return false;
+   }
+   return equal_f32_sse2(a + i, b + i, n - i);
+}
+
+DSACPP_TARGET("avx512f,avx512bw") inline std::size_t search_avx512(const std::uint8_t* p, std::size_t n, const std::uint8_t* needle, std::size_t m) noexcept {
+   const __m512i first = _mm512_set1_epi8(static_cast<char>(needle[0]));
+   const __m512i last = _mm512_set1_epi8(static_cast<char>(needle[m - 1]));
+   std::size_t i = 0;
+   for (; i + m - 1 + 64 <= n; i += 64) {
+      __mmask64 a = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p + i), first);
+      std::uint64_t mask = _cvtmask64_u64(_mm512_mask_cmpeq_epi8_mask(a, _mm512_loadu_si512(p + i + m - 1), last));
+      while (mask) {
+         std::size_t at = i + static_cast<std::size_t>(__builtin_ctzll(mask));
+         if (std::memcmp(p + at + 1, needle + 1, m - 2) == 0) return at;
+         mask &= mask - 1;
+      }
+   }
+   std::size_t rest = search_sse2(p + i, n - i, needle, m);
+   return rest == n - i ? n : i + rest;
+}
+
+DSACPP_TARGET("avx512f") inline __mmask16 cmp_i32_avx512(__m512i x, __m512i t, compare op) noexcept {
+   // the predicate must be an immediate, so spell each case out
+   switch (op) {
+      case compare::equal:          return _mm512_cmp_epi32_mask(x, t, _MM_CMPINT_EQ);
+      case compare::not_equal:      return _mm512_cmp_epi32_mask(x, t, _MM_CMPINT_NE);
+      case compare::less:           return _mm512_cmp_epi32_mask(x, t, _MM_CMPINT_LT);
+      case compare::less_equal:     return _mm512_cmp_epi32_mask(x, t, _MM_CMPINT_LE);
+      case compare::greater:        return _mm512_cmp_epi32_mask(x, t, _MM_CMPINT_NLE);
+      default:                      return _mm512_cmp_epi32_mask(x, t, _MM_CMPINT_NLT);
+   }
+}
+
+DSACPP_TARGET("avx512f") inline __mmask16 cmp_f32_avx512(__m512 x, __m512 t, compare op) noexcept {
+   switch (op) {
+      case compare::equal:          return _mm512_cmp_ps_mask(x, t, _CMP_EQ_OQ);
+      case compare::not_equal:      return _mm512_cmp_ps_mask(x, t, _CMP_NEQ_UQ);
+      case compare::less:           return _mm512_cmp_ps_mask(x, t, _CMP_LT_OQ);
+      case compare::less_equal:     return _mm512_cmp_ps_mask(x, t, _CMP_LE_OQ);
+      case compare::greater:        return _mm512_cmp_ps_mask(x, t, _CMP_GT_OQ);
+      default:                      return _mm512_cmp_ps_mask(x, t, _CMP_GE_OQ);
+   }
+}
+
+DSACPP_TARGET("avx512f,popcnt") inline std::size_t filter_i32_avx512(const std::int32_t* p, std::size_t n, compare op, std::int32_t threshold, std::int32_t* out) noexcept {
+   const __m512i t = _mm512_set1_epi32(threshold);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __m512i x = _mm512_loadu_si512(p + i);
+      __mmask16 mask = cmp_i32_avx512(x, t, op);
+      _mm512_mask_compressstoreu_epi32(out + k, mask, x);
+      k += static_cast<std::size_t>(_mm_popcnt_u32(mask));
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+DSACPP_TARGET("avx512f,popcnt") inline std::size_t filter_f32_avx512(const float* p, std::size_t n, compare op, float threshold, float* out) noexcept {
+   const __m512 t = _mm512_set1_ps(threshold);
+   std::size_t k = 0;
+   std::size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      __m512 x = _mm512_loadu_ps(p + i);
+      __mmask16 mask = cmp_f32_avx512(x, t, op);
+      _mm512_mask_compressstoreu_ps(out + k, mask, x);
+      k += static_cast<std::size_t>(_mm_popcnt_u32(mask));
+   }
+   return k + filter_scalar(p + i, n - i, op, threshold, out + k);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // DSACPP_SIMD_X86
+
+/**
+ * Dispatch on the raw element range
+ */
+
+template<typename T>
+inline std::size_t find(const T* p, std::size_t n, T value) noexcept {
+#if DSACPP_SIMD_X86
+   level l = active().load(std::memory_order_relaxed);
+   if constexpr (std::is_integral<T>::value && sizeof(T) == 1) {
+      std::uint8_t v = static_cast<std::uint8_t>(value);
+      const std::uint8_t* q = reinterpret_cast<const std::uint8_t*>(p);
+      if (l == level::avx512) return find_u8_avx512(q, n, v);
+      if (l == level::avx2) return find_u8_avx2(q, n, v);
+      if (l == level::sse2) return find_u8_sse2(q, n, v);
+   } else if constexpr (std::is_integral<T>::value && sizeof(T) == 4) {
+      std::int32_t v = static_cast<std::int32_t>(value);
+      const std::int32_t* q = reinterpret_cast<const std::int32_t*>(p);
+      if (l == level::avx512) return find_i32_avx512(q, n, v);
+      if (l == level::avx2) return find_i32_avx2(q, n, v);
+      if (l == level::sse2) return find_i32_sse2(q, n, v);
+   } else if constexpr (std::is_same<T, float>::value) {
+      if (l == level::avx512) return find_f32_avx512(p, n, value);
+      if (l == level::avx2) return find_f32_avx2(p, n, value);
+      if (l == level::sse2) return find_f32_sse2(p, n, value);
+   }
+#endif
+   return find_scalar(p, n, value);
+}
+
+template<typename T>
+inline std::size_t count(const T* p, std::size_t n, T value) noexcept {
+#if DSACPP_SIMD_X86
+   level l = active().load(std::memory_order_relaxed);
+   if constexpr (std::is_integral<T>::value && sizeof(T) == 1) {
+      std::uint8_t v = static_cast<std::uint8_t>(value);
+      const std::uint8_t* q = reinterpret_cast<const std::uint8_t*>(p);
+      if (l == level::avx512) return count_u8_avx512(q, n, v);
+      if (l == level::avx2) return count_u8_avx2(q, n, v);
+      if (l == level::sse2) return count_u8_sse2(q, n, v);
+   } else if constexpr (std::is_integral<T>::value && sizeof(T) == 4) {
+      std::int32_t v = static_cast<std::int32_t>(value);
+      const std::int32_t* q = reinterpret_cast<const std::int32_t*>(p);
+      if (l == level::avx512) return count_i32_avx512(q, n, v);
+      if (l == level::avx2) return count_i32_avx2(q, n, v);
+      if (l == level::sse2) return count_i32_sse2(q, n, v);
+   } else if constexpr (std::is_same<T, float>::value) {
+      if (l == level::avx512) return count_f32_avx512(p, n, value);
+      if (l == level::avx2) return count_f32_avx2(p, n, value);
+      if (l == level::sse2) return count_f32_sse2(p, n, value);
+   }
+#endif
+   return count_scalar(p, n, value);
+}
+
+template<typename T>
+inline sum_t<T> sum(const T* p, std::size_t n) noexcept {
+#if DSACPP_SIMD_X86
+   level l = active().load(std::memory_order_relaxed);
+   if constexpr (std::is_same<T, std::uint8_t>::value) {
+      if (l == level::avx512) return sum_u8_avx512(p, n);
+      if (l == level::avx2) return sum_u8_avx2(p, n);
+      if (l == level::sse2) return sum_u8_sse2(p, n);
+   } else if constexpr (std::is_same<T, std::int32_t>::value) {
+      if (l == level::avx512) return sum_i32_avx512(p, n);
+      if (l == level::avx2) return sum_i32_avx2(p, n);
+      if (l == level::sse2) return sum_i32_sse2(p, n);
+   } else if constexpr (std::is_same<T, float>::value) {
+      if (l == level::avx512) return sum_f32_avx512(p, n);
+      if (l == level::avx2) return sum_f32_avx2(p, n);
+      if (l == level::sse2) return sum_f32_sse2(p, n);
+   }
+#endif
+   return sum_scalar(p, n);
+}
+
+template<typename T>
+inline std::pair<T, T> minmax(const T* p, std::size_t n) noexcept {
+#if DSACPP_SIMD_X86
+   level l = active().load(std::memory_order_relaxed);
+   if constexpr (std::is_same<T, std::uint8_t>::value) {
+      if (l == level::avx512) return minmax_u8_avx512(p, n);
+      if (l == level::avx2) return minmax_u8_avx2(p, n);
+      if (l == level::sse2) return minmax_u8_sse2(p, n);
+   } else if constexpr (std::is_same<T, std::int32_t>::value) {
+      if (l == level::avx512) return minmax_i32_avx512(p, n);
+      if (l == level::avx2) return minmax_i32_avx2(p, n);
+      if (l == level::sse2) return minmax_i32_sse2(p, n);
+   } else if constexpr (std::is_same<T, float>::value) {
+      if (l == level::avx512) return minmax_f32_avx512(p, n);
+      if (l == level::avx2) return minmax_f32_avx2(p, n);
+      if (l == level::sse2) return minmax_f32_sse2(p, n);
+   }
+#endif
+   return minmax_scalar(p, n);
+}
+
+template<typename T>
+inline bool equal(const T* a, const T* b, std::size_t n) noexcept {
+   if constexpr (std::is_integral<T>::value) {
+      // libc memcmp already carries its own dispatched vector kernels
+      return n == 0 || std::memcmp(a, b, n * sizeof(T)) == 0;
+   } else {
+#if DSACPP_SIMD_X86
+      if constexpr (std::is_same<T, float>::value) {
+         level l = active().load(std::memory_order_relaxed);
+         if (l == level::avx512) return equal_f32_avx512(a, b, n);
+         if (l == level::avx2) return equal_f32_avx2(a, b, n);
+         if (l == level::sse2) return equal_f32_sse2(a, b, n);
+      }
+#endif
+      for (std::size_t i = 0; i < n; i++) {
+         if (!(a[i] == b[i])) return false;
+      }
+      return true;
+   }
+}
+
+inline std::size_t search(const std::uint8_t* p, std::size_t n, const std::uint8_t* needle, std::size_t m) noexcept {
+   if (m == 0) return 0;
+   if (m > n) return n;
+   if (m == 1) return find(p, n, needle[0]);
+#if DSACPP_SIMD_X86
+   level l = active().load(std::memory_order_relaxed);
+   if (l == level::avx512) return search_avx512(p, n, needle, m);
+   if (l == level::avx2) return search_avx2(p, n, needle, m);
+   if (l == level::sse2) return search_sse2(p, n, needle, m);
+#endif
+   return search_scalar(p, n, needle, m);
+}
+
+// out must have room for n elements plus one vector of slack
+template<typename T>
+inline std::size_t filter(const T* p, std::size_t n, compare op, T threshold, T* out) noexcept {
+#if DSACPP_SIMD_X86
+   level l = active().load(std::memory_order_relaxed);
+   if constexpr (std::is_same<T, std::uint8_t>::value) {
+      if (l == level::avx512 || l == level::avx2) return filter_u8_avx2(p, n, op, threshold, out);
+      if (l == level::sse2) return filter_u8_sse2(p, n, op, threshold, out);
+   } else if constexpr (std::is_same<T, std::int32_t>::value) {
+      if (l == level::avx512) return filter_i32_avx512(p, n, op, threshold, out);
+      if (l == level::avx2) return filter_i32_avx2(p, n, op, threshold, out);
+      if (l == level::sse2) return filter_i32_sse2(p, n, op, threshold, out);
+   } else if constexpr (std::is_same<T, float>::value) {
+      if (l == level::avx512) return filter_f32_avx512(p, n, op, threshold, out);
+      if (l == level::avx2) return filter_f32_avx2(p, n, op, threshold, out);
+      if (l == level::sse2) return filter_f32_sse2(p, n, op, threshold, out);
+   }
+#endif
+   return filter_scalar(p, n, op, threshold, out);
+}
+
+// widest store a filter kernel may issue past its output
+constexpr std::size_t FILTER_SLACK_BYTES = 64;
+
+} // namespace detail
+
+inline level detected_level() noexcept {
+#if DSACPP_SIMD_X86
+   static const level detected = [] {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return level::avx512;
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return level::avx2;
+      if (__builtin_cpu_supports("sse2")) return level::sse2;
+      return level::scalar;
+   }();
+   return detected;
+#else
+   return level::scalar;
+#endif
+}
+
+inline level active_level() noexcept {
+   return detail::active().load(std::memory_order_relaxed);
+}
+
+inline void set_active_level(level requested) noexcept {
+   level detected = detected_level();
+   detail::active().store(requested < detected ? requested : detected, std::memory_order_relaxed);
+}
+
+template<typename T, typename A, typename G>
+typename vector<T, A, G>::const_iterator find(const vector<T, A, G>& v, const T& value) {
+   return v.begin() + static_cast<std::ptrdiff_t>(detail::find(v.data(), v.size(), value));
+}
+
+template<typename T, typename A, typename G>
+std::size_t count(const vector<T, A, G>& v, const T& value) {
+   return detail::count(v.data(), v.size(), value);
+}
+
+template<typename T, typename A, typename G>
+auto accumulate(const vector<T, A, G>& v) {
+   static_assert(std::is_arithmetic<T>::value, "simd::accumulate needs an arithmetic element type");
+   return detail::sum(v.data(), v.size());
+}
+
+template<typename T, typename A, typename G>
+std::pair<T, T> minmax(const vector<T, A, G>& v) {
+   if (v.empty()) {
+      throw std::out_of_range("simd::minmax empty vector");
+   }
+   return detail::minmax(v.data(), v.size());
+}
+
+template<typename T, typename A1, typename G1, typename A2, typename G2>
+bool equal(const vector<T, A1, G1>& a, const vector<T, A2, G2>& b) {
+   return a.size() == b.size() && detail::equal(a.data(), b.data(), a.size());
+}
+
+template<typename A1, typename G1, typename A2, typename G2>
+typename vector<std::uint8_t, A1, G1>::const_iterator search(
+   const vector<std::uint8_t, A1, G1>& haystack,
+   const vector<std::uint8_t, A2, G2>& needle)
+{
+   std::size_t at = detail::search(haystack.data(), haystack.size(), needle.data(), needle.size());
+   return haystack.begin() + static_cast<std::ptrdiff_t>(at);
+}
+
+template<typename T, typename A1, typename G1, typename A2, typename G2>
+std::size_t filter(const vector<T, A1, G1>& in, compare op, const T& threshold, vector<T, A2, G2>& out) {
+   static_assert(std::is_trivially_copyable<T>::value, "simd::filter writes elements as raw bytes");
+   std::size_t old_size = out.size();
+   std::size_t slack = (detail::FILTER_SLACK_BYTES + sizeof(T) - 1) / sizeof(T);
+   out.resize_for_overwrite(old_size + in.size() + slack);
+   std::size_t kept = detail::filter(in.data(), in.size(), op, threshold, out.data() + old_size);
+   out.resize_for_overwrite(old_size + kept);
+   return kept;
+}
+
+template<typename T>
+const T* find(const T* first, const T* last, const T& value) {
+   return first + detail::find(first, static_cast<std::size_t>(last - first), value);
+}
+
+template<typename T>
+std::size_t count(const T* first, const T* last, const T& value) {
+   return detail::count(first, static_cast<std::size_t>(last - first), value);
+}
+
+template<typename T>
+auto accumulate(const T* first, const T* last) {
+   static_assert(std::is_arithmetic<T>::value, "simd::accumulate needs an arithmetic element type");
+   return detail::sum(first, static_cast<std::size_t>(last - first));
+}
+
+template<typename T>
+std::pair<T, T> minmax(const T* first, const T* last) {
+   if (first == last) {
+      throw std::out_of_range("simd::minmax empty range");
+   }
+   return detail::minmax(first, static_cast<std::size_t>(last - first));
+}
+
+} // namespace simd
+
+} // namespace dsacpp
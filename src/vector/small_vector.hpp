@@ -0,0 +1,723 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <cassert>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "vector.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Vector that keeps up to N elements in an inline buffer and only moves to
+ * the heap once it overflows. Shares iterator types, growth policy and
+ * relocation with vector, and a heap-backed small_vector converts to and
+ * from vector by handing over its buffer.
+ */
+template<typename T, std::size_t N>
+class small_vector {
+   static_assert(N > 0, "small_vector needs at least one inline element");
+
+public:
+   /**
+    * Type declarations
+    */
+
+   using value_type              = T;
+   using size_type               = std::size_t;
+   using reference               = T&;
+   using rvalue_reference        = T&&;
+   using pointer                 = T*;
+   using const_value_type        = const T;
+   using const_reference         = const T&;
+   using const_pointer           = const T*;
+   using difference_type         = std::ptrdiff_t;
+
+   using iterator                = vector_iterator<T>;
+   using const_iterator          = vector_const_iterator<T>;
+   using reverse_iterator        = std::reverse_iterator<iterator>;
+   using const_reverse_iterator  = std::reverse_iterator<const_iterator>;
+
+   static constexpr size_type inline_capacity = N;
+
+   /**
+    * Constructors & Destructor
+    */
+
+   small_vector() noexcept;
+
+   explicit small_vector(size_type count, const_reference value = T());
+
+   small_vector(const small_vector& other);
+
+   small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value);
+
+   small_vector(std::initializer_list<value_type> init_list);
+
+   // SNIFAE
+   template<
+      typename iter,
+      typename = std::enable_if_t<
+                  std::is_base_of<
+                  std::input_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value
+      >
+   >
+   small_vector(iter begin, iter end);
+
+   explicit small_vector(const vector<T>& other);
+
+   // adopts other's buffer when it does not fit inline
+   explicit small_vector(vector<T>&& other);
+
+   ~small_vector() noexcept;
+
+   /**
+    * Getters
+    */
+
+   reference at(size_type index);
+   const_reference at(size_type index) const;
+
+   reference front();
+   const_reference front() const;
+
+   reference back();
+   const_reference back() const;
+
+   pointer data() noexcept;
+   const_pointer data() const noexcept;
+
+   /**
+    * Setters
+    */
+
+   void clear() noexcept(std::is_nothrow_destructible<T>::value);
+
+   void push_back(const_reference value);
+   void push_back(rvalue_reference value);
+
+   template<typename... Args>
+   void emplace_back(Args&&... args);
+
+   void pop_back();
+
+   void resize(size_type new_size);
+   void resize(size_type new_size, const_reference value);
+
+   // like resize(), but new elements are default-initialized
+   void resize_for_overwrite(size_type new_size);
+
+   void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible<T>::value);
+
+   /**
+    * Metadata
+    */
+
+   size_type size() const noexcept;
+
+   size_type capacity() const noexcept;
+
+   bool empty() const noexcept;
+
+   // true while the elements live in the inline buffer
+   bool is_inline() const noexcept;
+
+   void shrink_to_fit();
+
+   void reserve(size_type new_capacity);
+
+   void reallocate(size_type new_capacity);
+
+   /**
+    * Operators
+    */
+
+   small_vector& operator=(const small_vector& other);
+   small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value);
+   small_vector& operator=(std::initializer_list<value_type> init_list);
+
+   reference operator[](size_type index);
+   const_reference operator[](size_type index) const;
+
+   operator vector<T>() const &;
+
+   // hands the heap buffer over without touching the elements
+   operator vector<T>() &&;
+
+   /**
+    * Iterators
+    */
+
+   iterator begin() noexcept;
+   const_iterator begin() const noexcept;
+   reverse_iterator rbegin() noexcept;
+   const_reverse_iterator rbegin() const noexcept;
+
+   iterator end() noexcept;
+   const_iterator end() const noexcept;
+   reverse_iterator rend() noexcept;
+   const_reverse_iterator rend() const noexcept;
+
+private:
+
+   size_type size_ = 0;
+   size_type capacity_ = N;
+   pointer data_;
+   alignas(T) unsigned char buffer_[N * sizeof(T)];
+
+   // heap buffers come from vector's default allocator so they can change hands
+   using allocator_type = typename vector<T>::allocator_type;
+   using alloc_traits = std::allocator_traits<allocator_type>;
+
+   pointer _inline_data() noexcept;
+
+   static pointer _allocate(size_type& n);
+   static void _deallocate(pointer p, size_type n) noexcept;
+
+   // destroy the elements and return to the empty inline state
+   void _clear() noexcept;
+
+   // take other's elements, leaving it empty and inline; *this must be empty and inline
+   void _steal(small_vector& other);
+
+   // bounds check selected by DSACPP_VECTOR_BOUNDS_CHECK
+   void _check_index(size_type index, const char* where) const;
+
+   // emplace_back on a full buffer: builds the element in the new heap
+   // buffer before moving the others over, so args may alias an element
+   template<typename... Args>
+   void _emplace_back_slow(Args&&... args);
+
+   // move the live elements into the inline buffer or a fresh heap buffer
+   void _reallocate(size_type new_capacity);
+};
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector() noexcept :
+   data_{ _inline_data() }
+{ }
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(size_type count, const_reference value) :
+   data_{ _inline_data() }
+{
+   try {
+      reserve(count);
+      std::uninitialized_fill_n(data_, count, value);
+   } catch (...) {
+      _clear();
+      throw;
+   }
+   size_ = count;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(const small_vector<T, N>& other) :
+   data_{ _inline_data() }
+{
+   try {
+      reserve(other.size_);
+      std::uninitialized_copy_n(other.data_, other.size_, data_);
+   } catch (...) {
+      _clear();
+      throw;
+   }
+   size_ = other.size_;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(small_vector<T, N>&& other) noexcept(std::is_nothrow_move_constructible<T>::value) :
+   data_{ _inline_data() }
+{ _steal(other); }
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(std::initializer_list<value_type> init_list) :
+   data_{ _inline_data() }
+{
+   try {
+      reserve(init_list.size());
+      std::uninitialized_copy(init_list.begin(), init_list.end(), data_);
+   } catch (...) {
+      _clear();
+      throw;
+   }
+   size_ = init_list.size();
+}
+
+template<typename T, std::size_t N>
+template<typename iter, typename>
+small_vector<T, N>::small_vector(iter begin, iter end) :
+   data_{ _inline_data() }
+{
+   try {
+      if constexpr (std::is_base_of<
+                     std::forward_iterator_tag,
+                     typename std::iterator_traits<iter>::iterator_category
+                  >::value) {
+         size_type count = static_cast<size_type>(std::distance(begin, end));
+         reserve(count);
+         std::uninitialized_copy(begin, end, data_);
+         size_ = count;
+      } else {
+         for (; begin != end; ++begin) {
+            emplace_back(*begin);
+         }
+      }
+   } catch (...) {
+      _clear();
+      throw;
+   }
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(const vector<T>& other) :
+   data_{ _inline_data() }
+{
+   try {
+      reserve(other.size_);
+      std::uninitialized_copy_n(other.data_, other.size_, data_);
+   } catch (...) {
+      _clear();
+      throw;
+   }
+   size_ = other.size_;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(vector<T>&& other) :
+   data_{ _inline_data() }
+{
+   if (other.size_ > N) {
+      data_ = other.data_;
+      capacity_ = other.capacity_;
+   } else {
+      vector<T>::_relocate(other.data_, other.size_, data_);
+      other._deallocate(other.data_, other.capacity_);
+   }
+   size_ = other.size_;
+   other.size_ = 0;
+   other.capacity_ = 0;
+   other.data_ = nullptr;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::~small_vector() noexcept {
+   _clear();
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::reference small_vector<T, N>::at(size_type index) {
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range("small_vector::at", index, size_);
+   }
+   return data_[index];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_reference small_vector<T, N>::at(size_type index) const {
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range("small_vector::at", index, size_);
+   }
+   return data_[index];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::reference small_vector<T, N>::front() {
+   _check_index(0, "small_vector::front");
+   return data_[0];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_reference small_vector<T, N>::front() const {
+   _check_index(0, "small_vector::front");
+   return data_[0];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::reference small_vector<T, N>::back() {
+   _check_index(size_ - 1, "small_vector::back");
+   return data_[size_ - 1];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_reference small_vector<T, N>::back() const {
+   _check_index(size_ - 1, "small_vector::back");
+   return data_[size_ - 1];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::pointer small_vector<T, N>::data() noexcept {
+   return data_;
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_pointer small_vector<T, N>::data() const noexcept {
+   return data_;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::clear() noexcept(std::is_nothrow_destructible<T>::value) {
+   for (size_t i = 0; i < size_; i++) {
+      data_[i].~T();
+   }
+   size_ = 0;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::push_back(const_reference value) {
+   emplace_back(value);
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::push_back(rvalue_reference value) {
+   emplace_back(std::move(value));
+}
+
+template<typename T, std::size_t N>
+template<typename... Args>
+void small_vector<T, N>::emplace_back(Args&&... args) {
+   if (DSACPP_UNLIKELY(size_ == capacity_)) {
+      _emplace_back_slow(std::forward<Args>(args)...);
+      return;
+   }
+   new (data_ + size_) T(std::forward<Args>(args)...);
+   ++size_;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::pop_back() {
+   if (size_ == 0) {
+      throw std::out_of_range("small_vector::pop_back empty vector");
+   }
+   data_[--size_].~T();
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::resize(size_type new_size) {
+   if (new_size == size_) {
+      return;
+   } else if (new_size < size_) {
+      for (size_t i = new_size; i < size_; i++) {
+         data_[i].~T();
+      }
+   } else {
+      reserve(new_size);
+      std::uninitialized_value_construct(data_ + size_, data_ + new_size);
+   }
+   size_ = new_size;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::resize_for_overwrite(size_type new_size) {
+   if (new_size == size_) {
+      return;
+   } else if (new_size < size_) {
+      for (size_t i = new_size; i < size_; i++) {
+         data_[i].~T();
+      }
+   } else {
+      reserve(new_size);
+      std::uninitialized_default_construct(data_ + size_, data_ + new_size);
+   }
+   size_ = new_size;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::resize(size_type new_size, const_reference value) {
+   if (new_size == size_) {
+      return;
+   } else if (new_size < size_) {
+      for (size_t i = new_size; i < size_; i++) {
+         data_[i].~T();
+      }
+   } else {
+      if (new_size > capacity_ && &value >= data_ && &value < data_ + size_) {
+         // value lives in this vector and would move with the buffer
+         T tmp(value);
+         reserve(new_size);
+         std::uninitialized_fill(data_ + size_, data_ + new_size, tmp);
+         size_ = new_size;
+         return;
+      }
+      reserve(new_size);
+      std::uninitialized_fill(data_ + size_, data_ + new_size, value);
+   }
+   size_ = new_size;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::swap(small_vector<T, N>& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+   if (this == &other) return;
+   if (!is_inline() && !other.is_inline()) {
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(capacity_, other.capacity_);
+      return;
+   }
+   small_vector<T, N> tmp{ std::move(other) };
+   other._steal(*this);
+   _steal(tmp);
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::size_type small_vector<T, N>::size() const noexcept {
+   return size_;
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::size_type small_vector<T, N>::capacity() const noexcept {
+   return capacity_;
+}
+
+template<typename T, std::size_t N>
+bool small_vector<T, N>::empty() const noexcept {
+   return size_ == 0;
+}
+
+template<typename T, std::size_t N>
+bool small_vector<T, N>::is_inline() const noexcept {
+   return data_ == reinterpret_cast<const_pointer>(buffer_);
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::shrink_to_fit() {
+   if (capacity_ == size_ || is_inline()) return;
+   _reallocate(size_);
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::reserve(size_type new_capacity) {
+   if (new_capacity <= capacity_) return;
+   _reallocate(new_capacity);
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::reallocate(size_type new_capacity) {
+   if (new_capacity == capacity_) return;
+   if (new_capacity < size_) {
+      for (size_t i = new_capacity; i < size_; i++) {
+         data_[i].~T();
+      }
+      size_ = new_capacity;
+   }
+   _reallocate(new_capacity);
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>& small_vector<T, N>::operator=(const small_vector<T, N>& other) {
+   if (this == &other) return *this;
+   clear();
+   reserve(other.size_);
+   std::uninitialized_copy_n(other.data_, other.size_, data_);
+   size_ = other.size_;
+   return *this;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>& small_vector<T, N>::operator=(small_vector<T, N>&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+   if (this == &other) return *this;
+   _clear();
+   _steal(other);
+   return *this;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>& small_vector<T, N>::operator=(std::initializer_list<value_type> init_list) {
+   clear();
+   reserve(init_list.size());
+   std::uninitialized_copy(init_list.begin(), init_list.end(), data_);
+   size_ = init_list.size();
+   return *this;
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::reference small_vector<T, N>::operator[](size_type index) {
+   _check_index(index, "small_vector::operator[]");
+   return data_[index];
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_reference small_vector<T, N>::operator[](size_type index) const {
+   _check_index(index, "small_vector::operator[]");
+   return data_[index];
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::operator vector<T>() const & {
+   return vector<T>(data_, data_ + size_);
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::operator vector<T>() && {
+   vector<T> result;
+   if (!is_inline()) {
+      result.data_ = data_;
+      result.size_ = size_;
+      result.capacity_ = capacity_;
+      data_ = _inline_data();
+      capacity_ = N;
+   } else if (size_) {
+      result.reserve(size_);
+      vector<T>::_relocate(data_, size_, result.data_);
+      result.size_ = size_;
+   }
+   size_ = 0;
+   return result;
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::iterator small_vector<T, N>::begin() noexcept {
+   return iterator{ data_ };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_iterator small_vector<T, N>::begin() const noexcept {
+   return const_iterator{ data_ };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::reverse_iterator small_vector<T, N>::rbegin() noexcept {
+   return std::reverse_iterator<iterator>{ end() };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_reverse_iterator small_vector<T, N>::rbegin() const noexcept {
+   return std::reverse_iterator<const_iterator>{ end() };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::iterator small_vector<T, N>::end() noexcept {
+   return iterator{ data_ + size_ };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_iterator small_vector<T, N>::end() const noexcept {
+   return const_iterator{ data_ + size_ };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::reverse_iterator small_vector<T, N>::rend() noexcept {
+   return std::reverse_iterator<iterator>{ begin() };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::const_reverse_iterator small_vector<T, N>::rend() const noexcept {
+   return std::reverse_iterator<const_iterator>{ begin() };
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::pointer small_vector<T, N>::_inline_data() noexcept {
+   return reinterpret_cast<pointer>(buffer_);
+}
+
+template<typename T, std::size_t N>
+typename small_vector<T, N>::pointer small_vector<T, N>::_allocate(size_type& n) {
+   allocator_type alloc;
+   return detail::allocate_at_least(alloc, n);
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::_deallocate(pointer p, size_type n) noexcept {
+   allocator_type alloc;
+   alloc_traits::deallocate(alloc, p, n);
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::_clear() noexcept {
+   for (size_t i = 0; i < size_; i++) {
+      data_[i].~T();
+   }
+   if (!is_inline()) {
+      _deallocate(data_, capacity_);
+   }
+   data_ = _inline_data();
+   size_ = 0;
+   capacity_ = N;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::_steal(small_vector<T, N>& other) {
+   if (!other.is_inline()) {
+      data_ = other.data_;
+      capacity_ = other.capacity_;
+      other.data_ = other._inline_data();
+      other.capacity_ = N;
+   } else {
+      vector<T>::_relocate(other.data_, other.size_, data_);
+   }
+   size_ = other.size_;
+   other.size_ = 0;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::_check_index([[maybe_unused]] size_type index, [[maybe_unused]] const char* where) const {
+#if DSACPP_VECTOR_BOUNDS_CHECK >= 2
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range(where, index, size_);
+   }
+#elif DSACPP_VECTOR_BOUNDS_CHECK == 1
+   assert(index < size_ && "small_vector index out of range");
+#endif
+}
+
+template<typename T, std::size_t N>
+template<typename... Args>
+void small_vector<T, N>::_emplace_back_slow(Args&&... args) {
+   size_type new_capacity = vector<T>::growth_type::grow(capacity_, size_ + 1);
+   pointer new_data = _allocate(new_capacity);
+   try {
+      new (new_data + size_) T(std::forward<Args>(args)...);
+   } catch (...) {
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   try {
+      vector<T>::_relocate(data_, size_, new_data);
+   } catch (...) {
+      new_data[size_].~T();
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   if (!is_inline()) {
+      _deallocate(data_, capacity_);
+   }
+   data_ = new_data;
+   capacity_ = new_capacity;
+   ++size_;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::_reallocate(size_type new_capacity) {
+   if (new_capacity <= N) {
+      if (is_inline()) return;
+      pointer old_data = data_;
+      vector<T>::_relocate(old_data, size_, _inline_data());
+      _deallocate(old_data, capacity_);
+      data_ = _inline_data();
+      capacity_ = N;
+      return;
+   }
+   pointer new_data = _allocate(new_capacity);
+   try {
+      vector<T>::_relocate(data_, size_, new_data);
+   } catch (...) {
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   if (!is_inline()) {
+      _deallocate(data_, capacity_);
+   }
+   data_ = new_data;
+   capacity_ = new_capacity;
+}
+
+} // namespace dsacpp
@@ -0,0 +1,721 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "vector.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * Contiguous run of one soa_vector column; begin()/end() are raw pointers
+ * so the span feeds straight into pointer-based kernels.
+ */
+template<typename T>
+class column_span {
+public:
+   using value_type        = std::remove_const_t<T>;
+   using size_type         = std::size_t;
+   using pointer           = T*;
+   using reference         = T&;
+   using iterator          = T*;
+
+   column_span() noexcept : data_{ nullptr }, size_{ 0 } { }
+   column_span(pointer data, size_type size) noexcept : data_{ data }, size_{ size } { }
+
+   // span of T to span of const T
+   template<typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+   column_span(const column_span<U>& other) noexcept : data_{ other.data() }, size_{ other.size() } { }
+
+   reference operator[](size_type index) const noexcept { return data_[index]; }
+   pointer data() const noexcept { return data_; }
+   size_type size() const noexcept { return size_; }
+   bool empty() const noexcept { return size_ == 0; }
+
+   iterator begin() const noexcept { return data_; }
+   iterator end() const noexcept { return data_ + size_; }
+
+private:
+   pointer data_;
+   size_type size_;
+};
+
+/**
+ * Row iterator over an soa_vector. Dereferencing yields the row proxy, a
+ * tuple of references, so rows can be read and assigned but not swapped
+ * by std algorithms that expect a real reference.
+ */
+template<typename Container, typename Reference>
+class soa_iterator {
+public:
+   using value_type        = typename std::remove_const_t<Container>::value_type;
+   using reference         = Reference;
+   using pointer           = void;
+   using difference_type   = std::ptrdiff_t;
+   using iterator_category = std::random_access_iterator_tag;
+
+   soa_iterator() noexcept : vec_{ nullptr }, index_{ 0 } { }
+   soa_iterator(Container* vec, std::size_t index) noexcept : vec_{ vec }, index_{ index } { }
+
+   // iterator to const_iterator
+   template<typename C, typename R, typename = std::enable_if_t<std::is_const<Container>::value && !std::is_const<C>::value>>
+   soa_iterator(const soa_iterator<C, R>& other) noexcept : vec_{ other.vec_ }, index_{ other.index_ } { }
+
+   // dereference
+   reference operator*() const noexcept { return (*vec_)[index_]; }
+   reference operator[](difference_type n) const noexcept { return (*vec_)[index_ + n]; }
+
+   // increment/decrement
+   soa_iterator& operator++() noexcept { ++index_; return *this; }
+   soa_iterator operator++(int) noexcept { auto tmp = *this; ++index_; return tmp; }
+   soa_iterator& operator--() noexcept { --index_; return *this; }
+   soa_iterator operator--(int) noexcept { auto tmp = *this; --index_; return tmp; }
+
+   // arithmetic
+   soa_iterator& operator+=(difference_type n) noexcept { index_ += n; return *this; }
+   soa_iterator& operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+   soa_iterator operator+(difference_type n) const noexcept { return { vec_, index_ + n }; }
+   soa_iterator operator-(difference_type n) const noexcept { return { vec_, index_ - n }; }
+   difference_type operator-(const soa_iterator& other) const noexcept {
+      return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+   }
+
+   // comparisons
+   bool operator==(const soa_iterator& other) const noexcept { return index_ == other.index_; }
+   bool operator!=(const soa_iterator& other) const noexcept { return index_ != other.index_; }
+   bool operator<(const soa_iterator& other) const noexcept { return index_ < other.index_; }
+   bool operator>(const soa_iterator& other) const noexcept { return index_ > other.index_; }
+   bool operator<=(const soa_iterator& other) const noexcept { return index_ <= other.index_; }
+   bool operator>=(const soa_iterator& other) const noexcept { return index_ >= other.index_; }
+
+private:
+   template<typename C, typename R>
+   friend class soa_iterator;
+
+   Container* vec_;
+   std::size_t index_;
+};
+
+/**
+ * Structure-of-arrays vector: soa_vector<float, float, int> keeps every
+ * field in its own contiguous array, so a scan over one field touches only
+ * that field's cache lines. All columns share one allocation, each starting
+ * on a COLUMN_ALIGNMENT boundary, and grow together under vector's growth
+ * policy; elements move between buffers with vector's relocation, falling
+ * back to copies only when some column could throw mid-move.
+ *
+ * Rows are accessed through std::tuple<Ts&...> proxies and whole columns
+ * through column<I>().
+ */
+template<typename... Ts>
+class soa_vector {
+   static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+
+public:
+   /**
+    * Type declarations
+    */
+
+   using value_type              = std::tuple<Ts...>;
+   using size_type               = std::size_t;
+   using difference_type         = std::ptrdiff_t;
+   using reference               = std::tuple<Ts&...>;
+   using const_reference         = std::tuple<const Ts&...>;
+
+   using iterator                = soa_iterator<soa_vector, reference>;
+   using const_iterator          = soa_iterator<const soa_vector, const_reference>;
+
+   template<std::size_t I>
+   using column_type             = std::tuple_element_t<I, value_type>;
+
+   static constexpr size_type COLUMN_COUNT = sizeof...(Ts);
+
+   // wide enough for aligned AVX-512 loads at the start of every column
+   static constexpr size_type COLUMN_ALIGNMENT = 64;
+
+   /**
+    * Constructors & Destructor
+    */
+
+   soa_vector() noexcept;
+
+   explicit soa_vector(size_type count, const value_type& value = value_type());
+
+   soa_vector(const soa_vector& other);
+
+   soa_vector(soa_vector&& other) noexcept;
+
+   soa_vector(std::initializer_list<value_type> init_list);
+
+   ~soa_vector() noexcept;
+
+   /**
+    * Getters
+    */
+
+   reference at(size_type index);
+   const_reference at(size_type index) const;
+
+   reference operator[](size_type index) noexcept;
+   const_reference operator[](size_type index) const noexcept;
+
+   reference front() noexcept;
+   const_reference front() const noexcept;
+
+   reference back() noexcept;
+   const_reference back() const noexcept;
+
+   template<std::size_t I>
+   column_span<column_type<I>> column() noexcept;
+
+   template<std::size_t I>
+   column_span<const column_type<I>> column() const noexcept;
+
+   template<std::size_t I>
+   column_type<I>* data() noexcept;
+
+   template<std::size_t I>
+   const column_type<I>* data() const noexcept;
+
+   /**
+    * Setters
+    */
+
+   void clear() noexcept;
+
+   void push_back(const value_type& row);
+   void push_back(value_type&& row);
+
+   // one argument per column
+   template<typename... Args>
+   void emplace_back(Args&&... args);
+
+   void pop_back() noexcept;
+
+   void resize(size_type new_size);
+   void resize(size_type new_size, const value_type& value);
+
+   void swap(soa_vector& other) noexcept;
+
+   /**
+    * Metadata
+    */
+
+   size_type size() const noexcept;
+
+   size_type capacity() const noexcept;
+
+   bool empty() const noexcept;
+
+   void reserve(size_type new_capacity);
+
+   void shrink_to_fit();
+
+   /**
+    * Operators
+    */
+
+   soa_vector& operator=(const soa_vector& other);
+
+   soa_vector& operator=(soa_vector&& other) noexcept;
+
+   /**
+    * Iterators
+    */
+
+   iterator begin() noexcept;
+   const_iterator begin() const noexcept;
+
+   iterator end() noexcept;
+   const_iterator end() const noexcept;
+
+private:
+
+   using indices = std::index_sequence_for<Ts...>;
+   using columns = std::tuple<Ts*...>;
+
+   struct alignas(COLUMN_ALIGNMENT) block {
+      unsigned char bytes[COLUMN_ALIGNMENT];
+   };
+
+   using block_allocator = allocator<block>;
+
+   // a move that can throw halfway would leave some columns moved and others not
+   static constexpr bool NOTHROW_RELOCATE =
+      ((is_trivially_relocatable_v<Ts> || std::is_nothrow_move_constructible<Ts>::value) && ...);
+
+   size_type size_;
+   size_type capacity_;
+   block* block_;
+   columns columns_;
+
+   // lay out capacity rows of every column in a buffer, returning its block count
+   static size_type _blocks_for(size_type capacity) noexcept;
+   static columns _columns_in(block* buffer, size_type capacity) noexcept;
+
+   static block* _allocate(size_type capacity);
+   static void _deallocate(block* buffer, size_type capacity) noexcept;
+
+   void _clear() noexcept;
+   void _destroy_rows(size_type first, size_type last) noexcept;
+
+   // construct row index of cols from one argument per column, all or nothing
+   template<typename... Args, std::size_t... I>
+   static void _construct_row(const columns& cols, size_type index, std::index_sequence<I...>, Args&&... args);
+
+   template<std::size_t... I>
+   static void _destroy_row(const columns& cols, size_type index, std::index_sequence<I...>) noexcept;
+
+   // capacity to grow to so that at least required rows fit
+   size_type _grown_capacity(size_type required) const noexcept;
+
+   template<typename... Args>
+   void _emplace_back_slow(Args&&... args);
+
+   // move the rows into fresh storage of new_capacity (>= size_)
+   void _reallocate(size_type new_capacity);
+
+   // move every live row from columns_ to cols, destroying the originals
+   void _relocate_to(const columns& cols);
+
+   template<std::size_t... I>
+   void _relocate_columns(const columns& cols, std::index_sequence<I...>) noexcept;
+
+   template<std::size_t... I>
+   reference _row(size_type index, std::index_sequence<I...>) const noexcept;
+};
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector() noexcept :
+   size_{ 0 },
+   capacity_{ 0 },
+   block_{ nullptr },
+   columns_{}
+{ }
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector(size_type count, const value_type& value) : soa_vector() {
+   resize(count, value);
+}
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector(const soa_vector& other) : soa_vector() {
+   reserve(other.size_);
+   try {
+      for (; size_ < other.size_; size_++) {
+         std::apply([&](const Ts&... fields) { _construct_row(columns_, size_, indices{}, fields...); }, other[size_]);
+      }
+   } catch (...) {
+      _clear();
+      throw;
+   }
+}
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector(soa_vector&& other) noexcept : soa_vector() {
+   swap(other);
+}
+
+template<typename... Ts>
+soa_vector<Ts...>::soa_vector(std::initializer_list<value_type> init_list) : soa_vector() {
+   reserve(init_list.size());
+   try {
+      for (const value_type& row : init_list) {
+         push_back(row);
+      }
+   } catch (...) {
+      _clear();
+      throw;
+   }
+}
+
+template<typename... Ts>
+soa_vector<Ts...>::~soa_vector() noexcept {
+   _clear();
+}
+
+/**
+ * Getters
+ */
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::at(size_type index) {
+   if (index >= size_) {
+      detail::throw_out_of_range("soa_vector::at", index, size_);
+   }
+   return (*this)[index];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reference soa_vector<Ts...>::at(size_type index) const {
+   if (index >= size_) {
+      detail::throw_out_of_range("soa_vector::at", index, size_);
+   }
+   return (*this)[index];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::operator[](size_type index) noexcept {
+   return _row(index, indices{});
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reference soa_vector<Ts...>::operator[](size_type index) const noexcept {
+   return _row(index, indices{});
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::front() noexcept {
+   return (*this)[0];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reference soa_vector<Ts...>::front() const noexcept {
+   return (*this)[0];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::back() noexcept {
+   return (*this)[size_ - 1];
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_reference soa_vector<Ts...>::back() const noexcept {
+   return (*this)[size_ - 1];
+}
+
+template<typename... Ts>
+template<std::size_t I>
+column_span<typename soa_vector<Ts...>::template column_type<I>> soa_vector<Ts...>::column() noexcept {
+   return { std::get<I>(columns_), size_ };
+}
+
+template<typename... Ts>
+template<std::size_t I>
+column_span<const typename soa_vector<Ts...>::template column_type<I>> soa_vector<Ts...>::column() const noexcept {
+   return { std::get<I>(columns_), size_ };
+}
+
+template<typename... Ts>
+template<std::size_t I>
+typename soa_vector<Ts...>::template column_type<I>* soa_vector<Ts...>::data() noexcept {
+   return std::get<I>(columns_);
+}
+
+template<typename... Ts>
+template<std::size_t I>
+const typename soa_vector<Ts...>::template column_type<I>* soa_vector<Ts...>::data() const noexcept {
+   return std::get<I>(columns_);
+}
+
+/**
+ * Setters
+ */
+
+template<typename... Ts>
+void soa_vector<Ts...>::clear() noexcept {
+   _destroy_rows(0, size_);
+   size_ = 0;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::push_back(const value_type& row) {
+   std::apply([this](const Ts&... fields) { emplace_back(fields...); }, row);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::push_back(value_type&& row) {
+   std::apply([this](Ts&... fields) { emplace_back(std::move(fields)...); }, row);
+}
+
+template<typename... Ts>
+template<typename... Args>
+void soa_vector<Ts...>::emplace_back(Args&&... args) {
+   static_assert(sizeof...(Args) == sizeof...(Ts), "soa_vector::emplace_back takes one argument per column");
+   if (size_ == capacity_) {
+      _emplace_back_slow(std::forward<Args>(args)...);
+      return;
+   }
+   _construct_row(columns_, size_, indices{}, std::forward<Args>(args)...);
+   size_++;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::pop_back() noexcept {
+   _destroy_row(columns_, --size_, indices{});
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::resize(size_type new_size) {
+   resize(new_size, value_type());
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::resize(size_type new_size, const value_type& value) {
+   if (new_size <= size_) {
+      _destroy_rows(new_size, size_);
+      size_ = new_size;
+      return;
+   }
+   reserve(new_size);
+   while (size_ < new_size) push_back(value);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::swap(soa_vector& other) noexcept {
+   std::swap(size_, other.size_);
+   std::swap(capacity_, other.capacity_);
+   std::swap(block_, other.block_);
+   std::swap(columns_, other.columns_);
+}
+
+/**
+ * Metadata
+ */
+
+template<typename... Ts>
+typename soa_vector<Ts...>::size_type soa_vector<Ts...>::size() const noexcept {
+   return size_;
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::size_type soa_vector<Ts...>::capacity() const noexcept {
+   return capacity_;
+}
+
+template<typename... Ts>
+bool soa_vector<Ts...>::empty() const noexcept {
+   return size_ == 0;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::reserve(size_type new_capacity) {
+   if (new_capacity <= capacity_) return;
+   _reallocate(new_capacity);
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::shrink_to_fit() {
+   if (size_ == capacity_) return;
+   if (size_ == 0) {
+      _clear();
+      return;
+   }
+   _reallocate(size_);
+}
+
+/**
+ * Operators
+ */
+
+template<typename... Ts>
+soa_vector<Ts...>& soa_vector<Ts...>::operator=(const soa_vector& other) {
+   if (this != &other) {
+      soa_vector tmp(other);
+      swap(tmp);
+   }
+   return *this;
+}
+
+template<typename... Ts>
+soa_vector<Ts...>& soa_vector<Ts...>::operator=(soa_vector&& other) noexcept {
+   if (this != &other) {
+      _clear();
+      swap(other);
+   }
+   return *this;
+}
+
+/**
+ * Iterators
+ */
+
+template<typename... Ts>
+typename soa_vector<Ts...>::iterator soa_vector<Ts...>::begin() noexcept {
+   return iterator(this, 0);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_iterator soa_vector<Ts...>::begin() const noexcept {
+   return const_iterator(this, 0);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::iterator soa_vector<Ts...>::end() noexcept {
+   return iterator(this, size_);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::const_iterator soa_vector<Ts...>::end() const noexcept {
+   return const_iterator(this, size_);
+}
+
+/**
+ * Private helpers
+ */
+
+template<typename... Ts>
+typename soa_vector<Ts...>::size_type soa_vector<Ts...>::_blocks_for(size_type capacity) noexcept {
+   size_type bytes = 0;
+   ((bytes += (capacity * sizeof(Ts) + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT), ...);
+   return bytes / COLUMN_ALIGNMENT;
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::columns soa_vector<Ts...>::_columns_in(block* buffer, size_type capacity) noexcept {
+   unsigned char* cursor = reinterpret_cast<unsigned char*>(buffer);
+   auto place = [&](auto* tag) {
+      using T = std::remove_pointer_t<decltype(tag)>;
+      T* column = reinterpret_cast<T*>(cursor);
+      cursor += (capacity * sizeof(T) + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+      return column;
+   };
+   // braced init evaluates left to right, so columns land in declaration order
+   return columns{ place(static_cast<Ts*>(nullptr))... };
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::block* soa_vector<Ts...>::_allocate(size_type capacity) {
+   static_assert(((alignof(Ts) <= COLUMN_ALIGNMENT) && ...), "soa_vector column over-aligned");
+   block_allocator alloc;
+   return alloc.allocate(_blocks_for(capacity));
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::_deallocate(block* buffer, size_type capacity) noexcept {
+   block_allocator alloc;
+   alloc.deallocate(buffer, _blocks_for(capacity));
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::_clear() noexcept {
+   clear();
+   if (block_) {
+      _deallocate(block_, capacity_);
+   }
+   block_ = nullptr;
+   columns_ = columns{};
+   capacity_ = 0;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::_destroy_rows(size_type first, size_type last) noexcept {
+   if constexpr (!(std::is_trivially_destructible<Ts>::value && ...)) {
+      for (size_type i = first; i < last; i++) {
+         _destroy_row(columns_, i, indices{});
+      }
+   }
+}
+
+template<typename... Ts>
+template<typename... Args, std::size_t... I>
+void soa_vector<Ts...>::_construct_row(const columns& cols, size_type index, std::index_sequence<I...>, Args&&... args) {
+   size_type built = 0;
+   try {
+      ((::new (static_cast<void*>(std::get<I>(cols) + index)) Ts(std::forward<Args>(args)), built++), ...);
+   } catch (...) {
+      // unwind the columns already constructed
+      ((I < built ? std::get<I>(cols)[index].~Ts() : void()), ...);
+      throw;
+   }
+}
+
+template<typename... Ts>
+template<std::size_t... I>
+void soa_vector<Ts...>::_destroy_row(const columns& cols, size_type index, std::index_sequence<I...>) noexcept {
+   (std::get<I>(cols)[index].~Ts(), ...);
+}
+
+template<typename... Ts>
+typename soa_vector<Ts...>::size_type soa_vector<Ts...>::_grown_capacity(size_type required) const noexcept {
+   return vector<column_type<0>>::growth_type::grow(capacity_, required);
+}
+
+template<typename... Ts>
+template<typename... Args>
+void soa_vector<Ts...>::_emplace_back_slow(Args&&... args) {
+   // build the new row first, args may refer to rows about to move
+   size_type new_capacity = _grown_capacity(size_ + 1);
+   block* new_block = _allocate(new_capacity);
+   columns new_columns = _columns_in(new_block, new_capacity);
+   try {
+      _construct_row(new_columns, size_, indices{}, std::forward<Args>(args)...);
+   } catch (...) {
+      _deallocate(new_block, new_capacity);
+      throw;
+   }
+   try {
+      _relocate_to(new_columns);
+   } catch (...) {
+      _destroy_row(new_columns, size_, indices{});
+      _deallocate(new_block, new_capacity);
+      throw;
+   }
+   if (block_) {
+      _deallocate(block_, capacity_);
+   }
+   block_ = new_block;
+   columns_ = new_columns;
+   capacity_ = new_capacity;
+   size_++;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::_reallocate(size_type new_capacity) {
+   block* new_block = _allocate(new_capacity);
+   columns new_columns = _columns_in(new_block, new_capacity);
+   try {
+      _relocate_to(new_columns);
+   } catch (...) {
+      _deallocate(new_block, new_capacity);
+      throw;
+   }
+   if (block_) {
+      _deallocate(block_, capacity_);
+   }
+   block_ = new_block;
+   columns_ = new_columns;
+   capacity_ = new_capacity;
+}
+
+template<typename... Ts>
+void soa_vector<Ts...>::_relocate_to(const columns& cols) {
+   if constexpr (NOTHROW_RELOCATE) {
+      _relocate_columns(cols, indices{});
+   } else {
+      // copy row by row so a throw leaves the old rows untouched
+      size_type i = 0;
+      try {
+         for (; i < size_; i++) {
+            std::apply([&](Ts*... src) {
+               _construct_row(cols, i, indices{}, std::move_if_noexcept(src[i])...);
+            }, columns_);
+         }
+      } catch (...) {
+         while (i) _destroy_row(cols, --i, indices{});
+         throw;
+      }
+      _destroy_rows(0, size_);
+   }
+}
+
+template<typename... Ts>
+template<std::size_t... I>
+void soa_vector<Ts...>::_relocate_columns(const columns& cols, std::index_sequence<I...>) noexcept {
+   (vector<Ts>::_relocate(std::get<I>(columns_), size_, std::get<I>(cols)), ...);
+}
+
+template<typename... Ts>
+template<std::size_t... I>
+typename soa_vector<Ts...>::reference soa_vector<Ts...>::_row(size_type index, std::index_sequence<I...>) const noexcept {
+   return reference(std::get<I>(columns_)[index]...);
+}
+
+} // namespace dsacpp
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <iterator>
 #include <cassert>
+#include <cstring>
 #include <initializer_list>
 #include <type_traits>
 #include <memory>
@@ -12,96 +14,245 @@
 #include <type_traits>
 #include <utility>
 
+#include "allocator.hpp"
+#include "vector_stats.hpp"
+
+/**
+ * Bounds checking applied by operator[], front() and back():
+ *    0 - unchecked (default)
+ *    1 - assert only, compiled out under NDEBUG
+ *    2 - always check, throwing std::out_of_range
+ * at() always checks regardless of this setting.
+ */
+#ifndef DSACPP_VECTOR_BOUNDS_CHECK
+#define DSACPP_VECTOR_BOUNDS_CHECK 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DSACPP_COLD __attribute__((cold, noinline))
+#define DSACPP_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#elif defined(_MSC_VER)
+#define DSACPP_COLD __declspec(noinline)
+#define DSACPP_UNLIKELY(x) (x)
+#else
+#define DSACPP_COLD
+#define DSACPP_UNLIKELY(x) (x)
+#endif
+
 namespace dsacpp
 {
 
+namespace detail
+{
+
+// kept out of line so the formatting code never lands in a caller's hot path
+[[noreturn]] DSACPP_COLD inline void throw_out_of_range(const char* where, std::size_t index, std::size_t size) {
+   std::ostringstream oss;
+   oss << where << " index " << index << " out of range " << "(size=" << size << ")";
+   throw std::out_of_range(oss.str());
+}
+
+// allocators may grow or shrink a block in place through
+// bool expand(T*, size_t old_n, size_t new_n) and
+// bool shrink(T*, size_t old_n, size_t new_n)
+template<typename A, typename = void>
+struct has_expand : std::false_type { };
+
+template<typename A>
+struct has_expand<A, std::void_t<decltype(std::declval<A&>().expand(
+   std::declval<typename A::value_type*>(), std::size_t{}, std::size_t{}))>> : std::true_type { };
+
+template<typename A, typename = void>
+struct has_shrink : std::false_type { };
+
+template<typename A>
+struct has_shrink<A, std::void_t<decltype(std::declval<A&>().shrink(
+   std::declval<typename A::value_type*>(), std::size_t{}, std::size_t{}))>> : std::true_type { };
+
+template<typename A, typename = void>
+struct has_allocate_at_least : std::false_type { };
+
+template<typename A>
+struct has_allocate_at_least<A, std::void_t<decltype(std::declval<A&>().allocate_at_least(std::size_t{}))>> : std::true_type { };
+
+// allocate at least n elements, updating n to what the allocator really gave
+template<typename A>
+typename std::allocator_traits<A>::pointer allocate_at_least(A& alloc, std::size_t& n) {
+   if constexpr (has_allocate_at_least<A>::value) {
+      auto result = alloc.allocate_at_least(n);
+      n = result.count;
+      return result.ptr;
+   } else {
+      return std::allocator_traits<A>::allocate(alloc, n);
+   }
+}
+
+} // namespace detail
+
+/**
+ * Growth policies for vector. A policy is any type with a static
+ *    size_t grow(size_t capacity, size_t required)
+ * returning the capacity to allocate once required elements no longer fit.
+ */
+namespace growth_policy
+{
+
+// capacity *= Num / Den, starting from Initial elements
+template<std::size_t Num, std::size_t Den, std::size_t Initial = 16>
+struct geometric {
+   static_assert(Num > Den && Den > 0, "geometric growth must increase capacity");
+
+   static constexpr std::size_t grow(std::size_t capacity, std::size_t required) noexcept {
+      std::size_t grown = Initial;
+      if (capacity) {
+         std::size_t step = capacity / Den * (Num - Den);
+         if (step == 0) step = 1;
+         grown = capacity > static_cast<std::size_t>(-1) - step ? static_cast<std::size_t>(-1) : capacity + step;
+      }
+      return grown < required ? required : grown;
+   }
+};
+
+using doubling = geometric<2, 1>;
+
+// lets a freed run of earlier blocks be reused by a later request
+using one_and_half = geometric<3, 2>;
+
+// grow by Chunk elements at a time, for memory-bound workloads
+template<std::size_t Chunk>
+struct fixed_chunk {
+   static_assert(Chunk > 0, "fixed_chunk needs a positive chunk size");
+
+   static constexpr std::size_t grow(std::size_t capacity, std::size_t required) noexcept {
+      std::size_t grown = (required + Chunk - 1) / Chunk * Chunk;
+      return grown < capacity + Chunk ? capacity + Chunk : grown;
+   }
+};
+
+} // namespace growth_policy
+
+/**
+ * Types that may be relocated with a plain memcpy (move + destroy of the
+ * source collapses to a byte copy). Trivially copyable types qualify
+ * automatically; other types may opt in by specializing this trait.
+ */
 template<typename T>
-class vector {
+struct is_trivially_relocatable : std::is_trivially_copyable<T> { };
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/**
+ * Tag requesting default- rather than value-initialization of new elements,
+ * so trivial types are left indeterminate instead of zeroed. Meant for
+ * buffers that are about to be overwritten, e.g. by read() or recv().
+ */
+struct default_init_t { explicit default_init_t() = default; };
+
+inline constexpr default_init_t default_init{};
+
+/**
+ * Iterators, shared by every contiguous container in the library
+ */
+
+template<typename T>
+class vector_iterator {
 public:
-   /**
-    * Iterators
-    */
-   
-   class iterator {
-   public:
-      using value_type        = const T;
-      using reference         = const T&;
-      using pointer           = const T*;
-      using difference_type   = std::ptrdiff_t;
-      using iterator_category = std::random_access_iterator_tag;
-
-      iterator() : ptr_{ nullptr } { }
-      explicit iterator(pointer p) : ptr_{ p } { }
-
-      // dereference and pointer access
-      reference operator*() const noexcept { return *ptr_; }
-      pointer operator->() const noexcept { return ptr_; }
-
-      // increment/decrement
-      iterator& operator++() noexcept { ++ptr_; return *this; }
-      iterator operator++(int) noexcept { iterator tmp = *this; ++(*this); return tmp; }
-      iterator& operator--() noexcept { --ptr_; return *this; }
-      iterator operator--(int) noexcept { iterator tmp = *this; --(*this); return tmp; }
-
-      // arithmetic
-      iterator& operator+=(difference_type n) noexcept { ptr_ += n; return *this; }
-      iterator& operator-=(difference_type n) noexcept { ptr_ -= n; return *this; }
-      iterator operator+(difference_type n) const noexcept { iterator tmp{ ptr_ }; tmp += n; return tmp; }
-      iterator operator-(difference_type n) const noexcept { iterator tmp{ ptr_ }; tmp -= n; return tmp; }
-      difference_type operator-(const iterator& other) const noexcept { return ptr_ - other.ptr_; }
-
-      // comparisons
-      bool operator==(const iterator& other) const noexcept { return ptr_ == other.ptr_; }
-      bool operator!=(const iterator& other) const noexcept { return ptr_ != other.ptr_; }
-      bool operator<(const iterator& other) const noexcept { return ptr_ < other.ptr_; }
-      bool operator>(const iterator& other) const noexcept { return ptr_ > other.ptr_; }
-      bool operator<=(const iterator& other) const noexcept { return ptr_ <= other.ptr_; }
-      bool operator>=(const iterator& other) const noexcept { return ptr_ >= other.ptr_; }
-
-   private:
-      pointer ptr_;
-   };
-
-   class const_iterator {
-   public:
-      using value_type        = const T;
-      using reference         = const T&;
-      using pointer           = const T*;
-      using difference_type   = std::ptrdiff_t;
-      using iterator_category = std::random_access_iterator_tag;
-
-      const_iterator() : ptr_{ nullptr } { }
-      explicit const_iterator(pointer p) : ptr_{ p } { }
-
-      // dereference and pointer access
-      reference operator*()  const noexcept { return *ptr_; }
-      pointer operator->() const noexcept { return ptr_; }
-
-      // increment/decrement
-      const_iterator& operator++() noexcept { ++ptr_; return *this; }
-      const_iterator operator++(int) noexcept { auto tmp = *this; ++ptr_; return tmp; }
-      const_iterator& operator--() noexcept { --ptr_; return *this; }
-      const_iterator operator--(int) noexcept { auto tmp = *this; --ptr_; return tmp; }
-
-      // arithmetic
-      const_iterator& operator+=(difference_type n) noexcept { ptr_ += n; return *this; }
-      const_iterator  operator+ (difference_type n) const noexcept { return const_iterator{ ptr_ + n}; }
-      const_iterator& operator-=(difference_type n) noexcept { ptr_ -= n; return *this; }
-      const_iterator  operator- (difference_type n) const noexcept { return const_iterator{ ptr_ - n }; }
-      difference_type operator-(const const_iterator& other) const noexcept { return ptr_ - other.ptr_; }
-
-      // comparisons
-      bool operator==(const const_iterator& other) const noexcept { return ptr_ == other.ptr_; }
-      bool operator!=(const const_iterator& other) const noexcept { return ptr_ != other.ptr_; }
-      bool operator<(const const_iterator& other) const noexcept { return ptr_ <  other.ptr_; }
-      bool operator>(const const_iterator& other) const noexcept { return ptr_ >  other.ptr_; }
-      bool operator<=(const const_iterator& other) const noexcept { return ptr_ <= other.ptr_; }
-      bool operator>=(const const_iterator& other) const noexcept { return ptr_ >= other.ptr_; }
-
-   private:
-      pointer ptr_;
-   };
+   using value_type        = T;
+   using reference         = T&;
+   using pointer           = T*;
+   using difference_type   = std::ptrdiff_t;
+   using iterator_category = std::random_access_iterator_tag;
+
+   vector_iterator() : ptr_{ nullptr } { }
+   explicit vector_iterator(pointer p) : ptr_{ p } { }
+
+   // dereference and pointer access
+   reference operator*() const noexcept { return *ptr_; }
+   pointer operator->() const noexcept { return ptr_; }
+   reference operator[](difference_type n) const noexcept { return ptr_[n]; }
+
+   // increment/decrement
+   vector_iterator& operator++() noexcept { ++ptr_; return *this; }
+   vector_iterator operator++(int) noexcept { vector_iterator tmp = *this; ++(*this); return tmp; }
+   vector_iterator& operator--() noexcept { --ptr_; return *this; }
+   vector_iterator operator--(int) noexcept { vector_iterator tmp = *this; --(*this); return tmp; }
+
+   // arithmetic
+   vector_iterator& operator+=(difference_type n) noexcept { ptr_ += n; return *this; }
+   vector_iterator& operator-=(difference_type n) noexcept { ptr_ -= n; return *this; }
+   vector_iterator operator+(difference_type n) const noexcept { vector_iterator tmp{ ptr_ }; tmp += n; return tmp; }
+   vector_iterator operator-(difference_type n) const noexcept { vector_iterator tmp{ ptr_ }; tmp -= n; return tmp; }
+   difference_type operator-(const vector_iterator& other) const noexcept { return ptr_ - other.ptr_; }
+
+   // comparisons
+   bool operator==(const vector_iterator& other) const noexcept { return ptr_ == other.ptr_; }
+   bool operator!=(const vector_iterator& other) const noexcept { return ptr_ != other.ptr_; }
+   bool operator<(const vector_iterator& other) const noexcept { return ptr_ < other.ptr_; }
+   bool operator>(const vector_iterator& other) const noexcept { return ptr_ > other.ptr_; }
+   bool operator<=(const vector_iterator& other) const noexcept { return ptr_ <= other.ptr_; }
+   bool operator>=(const vector_iterator& other) const noexcept { return ptr_ >= other.ptr_; }
+
+private:
+   pointer ptr_;
+};
 
+template<typename T>
+class vector_const_iterator {
+public:
+   using value_type        = T;
+   using reference         = const T&;
+   using pointer           = const T*;
+   using difference_type   = std::ptrdiff_t;
+   using iterator_category = std::random_access_iterator_tag;
+
+   vector_const_iterator() : ptr_{ nullptr } { }
+   explicit vector_const_iterator(pointer p) : ptr_{ p } { }
+   vector_const_iterator(const vector_iterator<T>& other) : ptr_{ other.operator->() } { }
+
+   // dereference and pointer access
+   reference operator*()  const noexcept { return *ptr_; }
+   pointer operator->() const noexcept { return ptr_; }
+   reference operator[](difference_type n) const noexcept { return ptr_[n]; }
+
+   // increment/decrement
+   vector_const_iterator& operator++() noexcept { ++ptr_; return *this; }
+   vector_const_iterator operator++(int) noexcept { auto tmp = *this; ++ptr_; return tmp; }
+   vector_const_iterator& operator--() noexcept { --ptr_; return *this; }
+   vector_const_iterator operator--(int) noexcept { auto tmp = *this; --ptr_; return tmp; }
+
+   // arithmetic
+   vector_const_iterator& operator+=(difference_type n) noexcept { ptr_ += n; return *this; }
+   vector_const_iterator  operator+ (difference_type n) const noexcept { return vector_const_iterator{ ptr_ + n}; }
+   vector_const_iterator& operator-=(difference_type n) noexcept { ptr_ -= n; return *this; }
+   vector_const_iterator  operator- (difference_type n) const noexcept { return vector_const_iterator{ ptr_ - n }; }
+   difference_type operator-(const vector_const_iterator& other) const noexcept { return ptr_ - other.ptr_; }
+
+   // comparisons
+   bool operator==(const vector_const_iterator& other) const noexcept { return ptr_ == other.ptr_; }
+   bool operator!=(const vector_const_iterator& other) const noexcept { return ptr_ != other.ptr_; }
+   bool operator<(const vector_const_iterator& other) const noexcept { return ptr_ <  other.ptr_; }
+   bool operator>(const vector_const_iterator& other) const noexcept { return ptr_ >  other.ptr_; }
+   bool operator<=(const vector_const_iterator& other) const noexcept { return ptr_ <= other.ptr_; }
+   bool operator>=(const vector_const_iterator& other) const noexcept { return ptr_ >= other.ptr_; }
+
+private:
+   pointer ptr_;
+};
+
+template<typename T, std::size_t N>
+class small_vector;
+
+template<typename... Ts>
+class soa_vector;
+
+template<
+   typename T,
+   typename Allocator   = allocator<T>,
+   typename Growth      = growth_policy::doubling
+>
+class vector {
+public:
    /**
     * Type declarations
     */
@@ -115,9 +266,11 @@ public:
    using const_reference         = const T&;
    using const_pointer           = const T*;
    using difference_type         = std::ptrdiff_t;
+   using allocator_type          = Allocator;
+   using growth_type             = Growth;
 
-   using iterator                = iterator;
-   using const_iterator          = const_iterator;
+   using iterator                = vector_iterator<T>;
+   using const_iterator          = vector_const_iterator<T>;
    using reverse_iterator        = std::reverse_iterator<iterator>;
    using const_reverse_iterator  = std::reverse_iterator<const_iterator>;
 
@@ -126,8 +279,12 @@ public:
     */
 
    vector() noexcept;
+
+   explicit vector(const allocator_type& alloc) noexcept;
    
-   explicit vector(size_type count, const_reference value = T());
+   explicit vector(size_type count, const_reference value = T(), const allocator_type& alloc = Allocator());
+
+   vector(size_type count, default_init_t, const allocator_type& alloc = Allocator());
 
    vector(const vector& other) noexcept(std::is_nothrow_copy_constructible<T>::value);
 
@@ -162,6 +319,9 @@ public:
    reference back();
    const_reference back() const;
 
+   pointer data() noexcept;
+   const_pointer data() const noexcept;
+
    /**
     * Setters
     */
@@ -179,8 +339,56 @@ public:
    void resize(size_type new_size);
    void resize(size_type new_size, const_reference value);
 
+   // like resize(), but new elements are default-initialized
+   void resize_for_overwrite(size_type new_size);
+
+   // grows to count uninitialized elements, lets op(data(), count) write
+   // them and return how many it wrote; the vector is then cut to that size
+   template<typename Operation>
+   void resize_and_overwrite(size_type count, Operation op);
+
    void swap(vector& other) noexcept;
 
+   iterator insert(const_iterator pos, const_reference value);
+   iterator insert(const_iterator pos, rvalue_reference value);
+   iterator insert(const_iterator pos, size_type count, const_reference value);
+   iterator insert(const_iterator pos, std::initializer_list<value_type> init_list);
+
+   template<
+      typename iter,
+      typename = std::enable_if_t<
+                  std::is_base_of<
+                  std::input_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value
+      >
+   >
+   iterator insert(const_iterator pos, iter first, iter last);
+
+   template<typename... Args>
+   iterator emplace(const_iterator pos, Args&&... args);
+
+   iterator erase(const_iterator pos);
+   iterator erase(const_iterator first, const_iterator last);
+
+   void assign(size_type count, const_reference value);
+   void assign(std::initializer_list<value_type> init_list);
+
+   template<
+      typename iter,
+      typename = std::enable_if_t<
+                  std::is_base_of<
+                  std::input_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value
+      >
+   >
+   void assign(iter first, iter last);
+
+   // append every element of range, reallocating at most once for forward ranges
+   template<typename Range>
+   void append_range(Range&& range);
+
    /**
     * Metadata
     */
@@ -191,6 +399,8 @@ public:
 
    bool empty() const noexcept;
 
+   allocator_type get_allocator() const noexcept;
+
    void shrink_to_fit();
 
    void reserve(size_type new_capacity);
@@ -224,146 +434,221 @@ public:
 
 private:
 
-   static constexpr size_t VECTOR_DEFAULT_CAPACITY = 16;
-   static constexpr u_int16_t VECTOR_GROWTH_RATE = 2;
+   template<typename U, std::size_t N>
+   friend class small_vector;
 
+   template<typename... Us>
+   friend class soa_vector;
+
+   using alloc_traits = std::allocator_traits<allocator_type>;
+
+   [[no_unique_address]] allocator_type alloc_;
    size_type size_ = 0;
    size_type capacity_ = 0;
    pointer data_ = nullptr;
 
    void _clear() noexcept;
 
-   // multiply capacity by growth rate
+   // may round n up to the block's usable size
+   pointer _allocate(size_type& n);
+   void _deallocate(pointer p, size_type n) noexcept;
+
+   // grow or shrink the buffer in place when the allocator supports it
+   bool _try_expand(size_type new_capacity) noexcept;
+   bool _try_shrink(size_type new_capacity) noexcept;
+
+   // bounds check selected by DSACPP_VECTOR_BOUNDS_CHECK
+   void _check_index(size_type index, const char* where) const;
+
+   // buffer change reported to vector_stats when DSACPP_VECTOR_INSTRUMENT
+   // is on; sizes are in elements, capacity is the buffer's afterwards
+   static void _record(vector_event::kind_type kind, size_type capacity, size_type allocated = 0,
+                       size_type freed = 0, size_type relocated = 0) noexcept;
+
+   // grow capacity as the growth policy dictates
    void _resize();
+
+   // capacity to grow to so that at least required elements fit
+   size_type _grown_capacity(size_type required) const noexcept;
+
+   // construct an element at the end of a full vector, then move the rest over
+   template<typename... Args>
+   void _emplace_back_slow(Args&&... args);
+
+   // open a gap of count slots at index and let fill construct into it
+   template<typename Fill>
+   iterator _insert_n(size_type index, size_type count, Fill&& fill);
+
+   // append a forward range after a single capacity check
+   template<typename iter>
+   void _append(iter first, iter last, std::forward_iterator_tag);
+
+   template<typename iter>
+   void _append(iter first, iter last, std::input_iterator_tag);
+
+   // move the live elements into a fresh buffer of new_capacity (>= size_)
+   void _reallocate(size_type new_capacity);
+
+   // move n elements from src into uninitialized dest, destroying src;
+   // ranges may overlap unless the move falls back to a throwing copy,
+   // in which case the strong guarantee holds instead
+   static void _relocate(pointer src, size_type n, pointer dest);
 };
 
-template<typename T>
-vector<T>::vector() noexcept { }
+/**
+ * vector whose buffer starts on an Align-byte boundary, e.g.
+ * aligned_vector<float, 64> for aligned AVX-512 loads.
+ */
+template<typename T, std::size_t Align = CACHE_LINE_SIZE>
+using aligned_vector = vector<T, allocator<T, Align>>;
 
-template<typename T>
-vector<T>::vector(size_type count, const_reference value) :
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector() noexcept { }
+
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(const allocator_type& alloc) noexcept :
+   alloc_{ alloc }
+{ }
+
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(size_type count, const_reference value, const allocator_type& alloc) :
+   alloc_{ alloc },
    size_{ count },
    capacity_{ count },
-   data_{ capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr }
+   data_{ _allocate(capacity_) }
 { std::uninitialized_fill_n(data_, size_, value); }
 
-template<typename T>
-vector<T>::vector(const vector<T>& other) noexcept(std::is_nothrow_copy_constructible<T>::value) :
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(size_type count, default_init_t, const allocator_type& alloc) :
+   alloc_{ alloc },
+   size_{ count },
+   capacity_{ count },
+   data_{ _allocate(capacity_) }
+{ std::uninitialized_default_construct_n(data_, size_); }
+
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(const vector<T, Allocator, Growth>& other) noexcept(std::is_nothrow_copy_constructible<T>::value) :
+   alloc_{ alloc_traits::select_on_container_copy_construction(other.alloc_) },
    size_{ other.size_ },
    capacity_{ other.capacity_ },
-   data_{ capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr }
+   data_{ _allocate(capacity_) }
 { std::uninitialized_copy_n(other.data_, size_, data_); }
 
-template<typename T>
-vector<T>::vector(vector<T>&& other) noexcept :
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector<T, Allocator, Growth>&& other) noexcept :
+   alloc_{ std::move(other.alloc_) },
    size_{ other.size_ },
    capacity_{ other.capacity_ },
    data_{ other.data_ }
 { other.size_ = 0; other.capacity_ = 0; other.data_ = nullptr; }
 
-template<typename T>
-vector<T>::vector(std::initializer_list<value_type> init_list) :
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(std::initializer_list<value_type> init_list) :
    size_{ init_list.size() },
    capacity_{ init_list.size() },
-   data_{ capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr }
+   data_{ _allocate(capacity_) }
 { std::uninitialized_copy(init_list.begin(), init_list.end(), data_); }
 
-template<typename T>
+template<typename T, typename Allocator, typename Growth>
 template<typename iter, typename>
-vector<T>::vector(iter begin, iter end) {
-   auto dist = std::distance(begin, end);
-   size_ = static_cast<size_type>(dist);
-   capacity_ = static_cast<size_type>(dist);
-   data_ = capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr;
-   std::uninitialized_copy(begin, end, data_);
+vector<T, Allocator, Growth>::vector(iter begin, iter end) {
+   _append(begin, end, typename std::iterator_traits<iter>::iterator_category{});
 }
 
-template<typename T>
-vector<T>::~vector() noexcept {
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::~vector() noexcept {
    _clear();
 }
 
-template<typename T>
-typename vector<T>::reference vector<T>::at(size_type index) {
-   if (index >= size_) {
-      std::ostringstream oss;
-      oss << "vector::at index" << index << " out of range" << "(size=" << size_ << ")";
-      throw std::out_of_range(oss.str());
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::reference vector<T, Allocator, Growth>::at(size_type index) {
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range("vector::at", index, size_);
    }
    return data_[index];
 }
 
-template<typename T>
-typename vector<T>::const_reference vector<T>::at(size_type index) const {
-   if (index >= size_) {
-      std::ostringstream oss;
-      oss << "vector::at index" << index << " out of range" << "(size=" << size_ << ")";
-      throw std::out_of_range(oss.str());
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_reference vector<T, Allocator, Growth>::at(size_type index) const {
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range("vector::at", index, size_);
    }
    return data_[index];
 }
 
-template<typename T>
-typename vector<T>::reference vector<T>::front() {
-   return at(0);
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::reference vector<T, Allocator, Growth>::front() {
+   _check_index(0, "vector::front");
+   return data_[0];
 }
 
-template<typename T>
-typename vector<T>::const_reference vector<T>::front() const {
-   return at(0);
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_reference vector<T, Allocator, Growth>::front() const {
+   _check_index(0, "vector::front");
+   return data_[0];
 }
 
-template<typename T>
-typename vector<T>::reference vector<T>::back() {
-   return at(size_ - 1);
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::reference vector<T, Allocator, Growth>::back() {
+   _check_index(size_ - 1, "vector::back");
+   return data_[size_ - 1];
 }
 
-template<typename T>
-typename vector<T>::const_reference vector<T>::back() const {
-   return at(size_ - 1);
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_reference vector<T, Allocator, Growth>::back() const {
+   _check_index(size_ - 1, "vector::back");
+   return data_[size_ - 1];
 }
 
-template<typename T>
-void vector<T>::clear() noexcept(std::is_nothrow_destructible<T>::value) {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::pointer vector<T, Allocator, Growth>::data() noexcept {
+   return data_;
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_pointer vector<T, Allocator, Growth>::data() const noexcept {
+   return data_;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::clear() noexcept(std::is_nothrow_destructible<T>::value) {
    for (size_t i = 0; i < size_; i++) {
       data_[i].~T();
    }
    size_ = 0;
 }
 
-template<typename T>
-void vector<T>::push_back(const_reference value) {
-   if (size_ >= capacity_) {
-      _resize();
-   }
-   new (data_ + size_++) T(value);
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::push_back(const_reference value) {
+   emplace_back(value);
 }
 
-template<typename T>
-void vector<T>::push_back(rvalue_reference value) {
-   if (size_ >= capacity_) {
-      _resize();
-   }
-   new (data_ + size_++) T(std::move(value)); 
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::push_back(rvalue_reference value) {
+   emplace_back(std::move(value));
 }
 
-template<typename T>
+template<typename T, typename Allocator, typename Growth>
 template<typename... Args>
-void vector<T>::emplace_back(Args&&... args) {
-   if (size_ == capacity_) _resize();
-   new (data_ + size_++) T(std::forward<Args>(args)...);
+void vector<T, Allocator, Growth>::emplace_back(Args&&... args) {
+   if (DSACPP_UNLIKELY(size_ == capacity_)) {
+      _emplace_back_slow(std::forward<Args>(args)...);
+      return;
+   }
+   new (data_ + size_) T(std::forward<Args>(args)...);
+   ++size_;
 }
 
-template<typename T>
-void vector<T>::pop_back() {
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::pop_back() {
    if (size_ == 0) {
       throw std::out_of_range("vector::pop_back empty vector");
    }
    data_[--size_].~T();
 }
 
-template<typename T>
-void vector<T>::resize(size_type new_size) {
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_type new_size) {
    if (new_size == size_) {
       return;
    } else if (new_size < size_) {
@@ -371,18 +656,16 @@ void vector<T>::resize(size_type new_size) {
          data_[i].~T();
       }
    } else {
-      while (new_size > capacity_) {
-         _resize();
-      }
-      for (size_t i = size_; i < new_size; i++) {
-         new (data_ + i) T();
+      if (new_size > capacity_) {
+         _reallocate(_grown_capacity(new_size));
       }
+      std::uninitialized_value_construct(data_ + size_, data_ + new_size);
    }
    size_ = new_size;
 }
 
-template<typename T>
-void vector<T>::resize(size_type new_size, const_reference value) {
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_type new_size, const_reference value) {
    if (new_size == size_) {
       return;
    } else if (new_size < size_) {
@@ -390,94 +673,273 @@ void vector<T>::resize(size_type new_size, const_reference value) {
          data_[i].~T();
       }
    } else {
-      while (new_size > capacity_) {
-         _resize();
+      if (new_size > capacity_) {
+         if (&value >= data_ && &value < data_ + size_) {
+            // value lives in this vector and would move with the buffer
+            T tmp(value);
+            _reallocate(_grown_capacity(new_size));
+            std::uninitialized_fill(data_ + size_, data_ + new_size, tmp);
+            size_ = new_size;
+            return;
+         }
+         _reallocate(_grown_capacity(new_size));
       }
-      for (size_t i = size_; i < new_size; i++) {
-         new (data_ + i) T(value);
+      std::uninitialized_fill(data_ + size_, data_ + new_size, value);
+   }
+   size_ = new_size;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize_for_overwrite(size_type new_size) {
+   if (new_size == size_) {
+      return;
+   } else if (new_size < size_) {
+      for (size_t i = new_size; i < size_; i++) {
+         data_[i].~T();
       }
+   } else {
+      if (new_size > capacity_) {
+         _reallocate(_grown_capacity(new_size));
+      }
+      std::uninitialized_default_construct(data_ + size_, data_ + new_size);
    }
    size_ = new_size;
 }
 
-template<typename T>
-void vector<T>::swap(vector<T>& other) noexcept {
+template<typename T, typename Allocator, typename Growth>
+template<typename Operation>
+void vector<T, Allocator, Growth>::resize_and_overwrite(size_type count, Operation op) {
+   static_assert(std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+                 "vector::resize_and_overwrite hands out raw storage, which needs a trivial type");
+   if (count > capacity_) {
+      _reallocate(_grown_capacity(count));
+   }
+   size_type written = static_cast<size_type>(op(data_, count));
+   if (written > count) {
+      throw std::out_of_range("vector::resize_and_overwrite op wrote past count");
+   }
+   size_ = written;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::swap(vector<T, Allocator, Growth>& other) noexcept {
+   std::swap(alloc_, other.alloc_);
    std::swap(data_, other.data_);
    std::swap(size_, other.size_);
    std::swap(capacity_, other.capacity_);
 }
 
-template<typename T>
-typename vector<T>::size_type vector<T>::size() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, const_reference value) {
+   return emplace(pos, value);
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, rvalue_reference value) {
+   return emplace(pos, std::move(value));
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, size_type count, const_reference value) {
+   size_type index = static_cast<size_type>(pos - begin());
+   if (&value >= data_ && &value < data_ + size_) {
+      // value lives in this vector and would shift along with the gap
+      T tmp(value);
+      return _insert_n(index, count, [&](pointer dest) {
+         std::uninitialized_fill_n(dest, count, tmp);
+      });
+   }
+   return _insert_n(index, count, [&](pointer dest) {
+      std::uninitialized_fill_n(dest, count, value);
+   });
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, std::initializer_list<value_type> init_list) {
+   return insert(pos, init_list.begin(), init_list.end());
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename iter, typename>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, iter first, iter last) {
+   size_type index = static_cast<size_type>(pos - begin());
+   if constexpr (std::is_base_of<
+                  std::forward_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value) {
+      size_type count = static_cast<size_type>(std::distance(first, last));
+      return _insert_n(index, count, [&](pointer dest) {
+         std::uninitialized_copy(first, last, dest);
+      });
+   } else {
+      // single pass: append, then rotate the new tail into place
+      size_type old_size = size_;
+      _append(first, last, std::input_iterator_tag{});
+      std::rotate(data_ + index, data_ + old_size, data_ + size_);
+      return iterator{ data_ + index };
+   }
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename... Args>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::emplace(const_iterator pos, Args&&... args) {
+   size_type index = static_cast<size_type>(pos - begin());
+   if (index == size_) {
+      emplace_back(std::forward<Args>(args)...);
+      return iterator{ data_ + index };
+   }
+   // build the element first, args may refer into this vector
+   T tmp(std::forward<Args>(args)...);
+   return _insert_n(index, 1, [&](pointer dest) {
+      new (dest) T(std::move(tmp));
+   });
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::erase(const_iterator pos) {
+   return erase(pos, pos + 1);
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::erase(const_iterator first, const_iterator last) {
+   size_type index = static_cast<size_type>(first - begin());
+   size_type count = static_cast<size_type>(last - first);
+   if (count == 0) return iterator{ data_ + index };
+   if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible<T>::value) {
+      for (size_t i = index; i < index + count; i++) {
+         data_[i].~T();
+      }
+      _relocate(data_ + index + count, size_ - index - count, data_ + index);
+   } else {
+      std::move(data_ + index + count, data_ + size_, data_ + index);
+      for (size_t i = size_ - count; i < size_; i++) {
+         data_[i].~T();
+      }
+   }
+   size_ -= count;
+   return iterator{ data_ + index };
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::assign(size_type count, const_reference value) {
+   if (count > capacity_) {
+      vector<T, Allocator, Growth> tmp(count, value, alloc_);
+      swap(tmp);
+      return;
+   }
+   std::fill_n(data_, std::min(count, size_), value);
+   if (count > size_) {
+      std::uninitialized_fill(data_ + size_, data_ + count, value);
+   } else {
+      for (size_t i = count; i < size_; i++) {
+         data_[i].~T();
+      }
+   }
+   size_ = count;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::assign(std::initializer_list<value_type> init_list) {
+   assign(init_list.begin(), init_list.end());
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename iter, typename>
+void vector<T, Allocator, Growth>::assign(iter first, iter last) {
+   if constexpr (std::is_base_of<
+                  std::forward_iterator_tag,
+                  typename std::iterator_traits<iter>::iterator_category
+               >::value) {
+      size_type count = static_cast<size_type>(std::distance(first, last));
+      if (count > capacity_) {
+         vector<T, Allocator, Growth> tmp(alloc_);
+         tmp._append(first, last, std::forward_iterator_tag{});
+         swap(tmp);
+         return;
+      }
+      size_type overlap = std::min(count, size_);
+      iter mid = std::next(first, static_cast<difference_type>(overlap));
+      std::copy(first, mid, data_);
+      if (count > size_) {
+         std::uninitialized_copy(mid, last, data_ + size_);
+      } else {
+         for (size_t i = count; i < size_; i++) {
+            data_[i].~T();
+         }
+      }
+      size_ = count;
+   } else {
+      clear();
+      _append(first, last, std::input_iterator_tag{});
+   }
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename Range>
+void vector<T, Allocator, Growth>::append_range(Range&& range) {
+   using std::begin;
+   using std::end;
+   auto first = begin(range);
+   auto last = end(range);
+   _append(first, last, typename std::iterator_traits<decltype(first)>::iterator_category{});
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::size_type vector<T, Allocator, Growth>::size() const noexcept {
    return size_;
 }
 
-template<typename T>
-typename vector<T>::size_type vector<T>::capacity() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::size_type vector<T, Allocator, Growth>::capacity() const noexcept {
    return capacity_;
 }
 
-template<typename T>
-bool vector<T>::empty() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+bool vector<T, Allocator, Growth>::empty() const noexcept {
    return size_ == 0;
 }
 
-template<typename T>
-void vector<T>::shrink_to_fit() {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::allocator_type vector<T, Allocator, Growth>::get_allocator() const noexcept {
+   return alloc_;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::shrink_to_fit() {
    if (capacity_ == size_) return;
-   pointer new_data = size_ ? static_cast<pointer>(::operator new(size_ * sizeof(T))) : nullptr;
-   for (size_t i = 0; i < size_; i++) {
-      new (new_data + i) T(std::move(data_[i]));
-      data_[i].~T();
-   }
-   ::operator delete(data_);
-   data_ = new_data;
-   capacity_ = size_;
+   _reallocate(size_);
 }
 
-template<typename T>
-void vector<T>::reserve(size_type new_capacity) {
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::reserve(size_type new_capacity) {
    if (new_capacity <= capacity_) return;
-   pointer new_data = new_capacity ? static_cast<pointer>(::operator new(new_capacity * sizeof(T))) : nullptr;
-   for (size_t i = 0; i < size_; i++) {
-      new (new_data + i) T(std::move(data_[i]));
-      data_[i].~T();
-   }
-   ::operator delete(data_);
-   data_ = new_data;
-   capacity_ = new_capacity;
+   _reallocate(new_capacity);
 }
 
-template<typename T>
-void vector<T>::reallocate(size_type new_capacity) {
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::reallocate(size_type new_capacity) {
    if (new_capacity == capacity_) return;
-   pointer new_data = new_capacity ? static_cast<pointer>(::operator new(new_capacity * sizeof(T))) : nullptr;
-   for (size_t i = 0; i < size_; i++) {
-      new (new_data + i) T(std::move(data_[i]));
-      data_[i].~T();
+   if (new_capacity < size_) {
+      for (size_t i = new_capacity; i < size_; i++) {
+         data_[i].~T();
+      }
+      size_ = new_capacity;
    }
-   ::operator delete(data_);
-   data_ = new_data;
-   capacity_ = new_capacity;
+   _reallocate(new_capacity);
 }
 
-template<typename T>
-vector<T>& vector<T>::operator=(const vector<T>& other) {
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>& vector<T, Allocator, Growth>::operator=(const vector<T, Allocator, Growth>& other) {
    if (this == &other) return *this;
-   _clear();
-   size_ = other.size_;
-   capacity_ = other.capacity_;
-   data_ = capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr;
-   for (size_t i = 0; i < size_; i++) {
-      new (data_ + i) T(other.data_[i]);
-   }
+   assign(other.data_, other.data_ + other.size_);
    return *this;
 }
 
-template<typename T>
-vector<T>& vector<T>::operator=(vector<T>&& other) {
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>& vector<T, Allocator, Growth>::operator=(vector<T, Allocator, Growth>&& other) {
    if (this == &other) return *this;
    _clear();
+   alloc_ = std::move(other.alloc_);
    size_ = other.size_;
    capacity_ = other.capacity_;
    data_ = other.data_;
@@ -487,86 +949,298 @@ vector<T>& vector<T>::operator=(vector<T>&& other) {
    return *this;
 }
 
-template<typename T>
-vector<T>& vector<T>::operator=(std::initializer_list<value_type> init_list) {
-   _clear();
-   size_ = init_list.size();
-   capacity_ = init_list.size();
-   data_ = capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr;
-   std::uninitialized_copy_n(init_list.begin(), init_list.end(), data_);
+template<typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>& vector<T, Allocator, Growth>::operator=(std::initializer_list<value_type> init_list) {
+   assign(init_list.begin(), init_list.end());
    return *this;
 }
 
-template<typename T>
-typename vector<T>::reference vector<T>::operator[](size_type index) {
-   return at(index);
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::reference vector<T, Allocator, Growth>::operator[](size_type index) {
+   _check_index(index, "vector::operator[]");
+   return data_[index];
 }
 
-template<typename T>
-typename vector<T>::const_reference vector<T>::operator[](size_type index) const {
-   return at(index);
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_reference vector<T, Allocator, Growth>::operator[](size_type index) const {
+   _check_index(index, "vector::operator[]");
+   return data_[index];
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::begin() noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::begin() noexcept {
    return iterator{ data_ };
 }
 
-template<typename T>
-typename vector<T>::const_iterator vector<T>::begin() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_iterator vector<T, Allocator, Growth>::begin() const noexcept {
    return const_iterator{ data_ };
 }
 
-template<typename T>
-typename vector<T>::reverse_iterator vector<T>::rbegin() noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::reverse_iterator vector<T, Allocator, Growth>::rbegin() noexcept {
    return std::reverse_iterator<iterator>{ end() };
 }
 
-template<typename T>
-typename vector<T>::const_reverse_iterator vector<T>::rbegin() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_reverse_iterator vector<T, Allocator, Growth>::rbegin() const noexcept {
    return std::reverse_iterator<const_iterator>{ end() };
 }
 
-template<typename T>
-typename vector<T>::iterator vector<T>::end() noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::end() noexcept {
    return iterator{ data_ + size_ };
 }
 
-template<typename T>
-typename vector<T>::const_iterator vector<T>::end() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_iterator vector<T, Allocator, Growth>::end() const noexcept {
    return const_iterator{ data_ + size_ };
 }
 
-template<typename T>
-typename vector<T>::reverse_iterator vector<T>::rend() noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::reverse_iterator vector<T, Allocator, Growth>::rend() noexcept {
    return std::reverse_iterator<iterator>{ begin() };
 }
 
-template<typename T>
-typename vector<T>::const_reverse_iterator vector<T>::rend() const noexcept {
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_reverse_iterator vector<T, Allocator, Growth>::rend() const noexcept {
    return std::reverse_iterator<const_iterator>{ begin() };
 }
 
-template<typename T>
-void vector<T>::_clear() noexcept {
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_clear() noexcept {
    for (size_t i = 0; i < size_; i++) {
       data_[i].~T();
    }
-   ::operator delete(data_);
+   _deallocate(data_, capacity_);
+   data_ = nullptr;
    size_ = 0;
    capacity_ = 0;
 }
 
-template<typename T>
-void vector<T>::_resize()  {
-   capacity_ = capacity_ ? VECTOR_GROWTH_RATE * capacity_ : VECTOR_DEFAULT_CAPACITY;
-   pointer new_data = capacity_ ? static_cast<pointer>(::operator new(capacity_ * sizeof(T))) : nullptr;
-   for (size_t i = 0; i < size_; i++) {
-      new (new_data + i) T(data_[i]);
-      data_[i].~T();
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::pointer vector<T, Allocator, Growth>::_allocate(size_type& n) {
+   if (!n) return nullptr;
+   pointer p = detail::allocate_at_least(alloc_, n);
+   _record(vector_event::allocate, n, n);
+   return p;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_deallocate(pointer p, size_type n) noexcept {
+   if (!p) return;
+   _record(vector_event::deallocate, 0, 0, n);
+   alloc_traits::deallocate(alloc_, p, n);
+}
+
+template<typename T, typename Allocator, typename Growth>
+bool vector<T, Allocator, Growth>::_try_expand(size_type new_capacity) noexcept {
+   if constexpr (detail::has_expand<allocator_type>::value) {
+      if (data_ && alloc_.expand(data_, capacity_, new_capacity)) {
+         _record(vector_event::reallocate, new_capacity, new_capacity - capacity_);
+         capacity_ = new_capacity;
+         return true;
+      }
+   }
+   return false;
+}
+
+template<typename T, typename Allocator, typename Growth>
+bool vector<T, Allocator, Growth>::_try_shrink(size_type new_capacity) noexcept {
+   if constexpr (detail::has_shrink<allocator_type>::value) {
+      if (data_ && new_capacity && alloc_.shrink(data_, capacity_, new_capacity)) {
+         _record(vector_event::reallocate, new_capacity, 0, capacity_ - new_capacity);
+         capacity_ = new_capacity;
+         return true;
+      }
+   }
+   return false;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_check_index([[maybe_unused]] size_type index, [[maybe_unused]] const char* where) const {
+#if DSACPP_VECTOR_BOUNDS_CHECK >= 2
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range(where, index, size_);
+   }
+#elif DSACPP_VECTOR_BOUNDS_CHECK == 1
+   assert(index < size_ && "vector index out of range");
+#endif
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_record([[maybe_unused]] vector_event::kind_type kind, [[maybe_unused]] size_type capacity,
+                                           [[maybe_unused]] size_type allocated, [[maybe_unused]] size_type freed,
+                                           [[maybe_unused]] size_type relocated) noexcept {
+#if DSACPP_VECTOR_INSTRUMENT
+   detail::record_vector_event<T>(
+      vector_event{ kind, allocated * sizeof(T), freed * sizeof(T), relocated, capacity * sizeof(T) });
+#endif
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_resize()  {
+   _reallocate(_grown_capacity(size_ + 1));
+}
+
+template<typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::size_type vector<T, Allocator, Growth>::_grown_capacity(size_type required) const noexcept {
+   return growth_type::grow(capacity_, required);
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename... Args>
+void vector<T, Allocator, Growth>::_emplace_back_slow(Args&&... args) {
+   size_type new_capacity = _grown_capacity(size_ + 1);
+   if (_try_expand(new_capacity)) {
+      new (data_ + size_) T(std::forward<Args>(args)...);
+      ++size_;
+      return;
+   }
+   pointer new_data = _allocate(new_capacity);
+   try {
+      new (new_data + size_) T(std::forward<Args>(args)...);
+   } catch (...) {
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   try {
+      _relocate(data_, size_, new_data);
+   } catch (...) {
+      new_data[size_].~T();
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   _record(vector_event::reallocate, new_capacity, 0, 0, size_);
+   _deallocate(data_, capacity_);
+   data_ = new_data;
+   capacity_ = new_capacity;
+   ++size_;
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename Fill>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::_insert_n(size_type index, size_type count, Fill&& fill) {
+   if (count == 0) return iterator{ data_ + index };
+   if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible<T>::value) {
+      if (size_ + count <= capacity_ || _try_expand(_grown_capacity(size_ + count))) {
+         _relocate(data_ + index, size_ - index, data_ + index + count);
+         try {
+            fill(data_ + index);
+         } catch (...) {
+            _relocate(data_ + index + count, size_ - index, data_ + index);
+            throw;
+         }
+         size_ += count;
+         return iterator{ data_ + index };
+      }
+   }
+   // reallocate: build the new elements first so a throw leaves *this untouched
+   size_type new_capacity = size_ + count <= capacity_ ? capacity_ : _grown_capacity(size_ + count);
+   pointer new_data = _allocate(new_capacity);
+   try {
+      fill(new_data + index);
+   } catch (...) {
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible<T>::value) {
+      _relocate(data_, index, new_data);
+      _relocate(data_ + index, size_ - index, new_data + index + count);
+   } else {
+      // throwing moves: copy both halves before giving up the old buffer
+      try {
+         std::uninitialized_copy(data_, data_ + index, new_data);
+      } catch (...) {
+         for (size_t i = index; i < index + count; i++) new_data[i].~T();
+         _deallocate(new_data, new_capacity);
+         throw;
+      }
+      try {
+         std::uninitialized_copy(data_ + index, data_ + size_, new_data + index + count);
+      } catch (...) {
+         for (size_t i = 0; i < index + count; i++) new_data[i].~T();
+         _deallocate(new_data, new_capacity);
+         throw;
+      }
+      for (size_t i = 0; i < size_; i++) {
+         data_[i].~T();
+      }
    }
-   ::operator delete(data_);
+   _record(vector_event::reallocate, new_capacity, 0, 0, size_);
+   _deallocate(data_, capacity_);
    data_ = new_data;
+   capacity_ = new_capacity;
+   size_ += count;
+   return iterator{ data_ + index };
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename iter>
+void vector<T, Allocator, Growth>::_append(iter first, iter last, std::forward_iterator_tag) {
+   size_type count = static_cast<size_type>(std::distance(first, last));
+   if (size_ + count > capacity_) {
+      _reallocate(_grown_capacity(size_ + count));
+   }
+   std::uninitialized_copy(first, last, data_ + size_);
+   size_ += count;
+}
+
+template<typename T, typename Allocator, typename Growth>
+template<typename iter>
+void vector<T, Allocator, Growth>::_append(iter first, iter last, std::input_iterator_tag) {
+   for (; first != last; ++first) {
+      emplace_back(*first);
+   }
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_reallocate(size_type new_capacity) {
+   if (new_capacity > capacity_ ? _try_expand(new_capacity) : _try_shrink(new_capacity)) return;
+   pointer new_data = _allocate(new_capacity);
+   try {
+      _relocate(data_, size_, new_data);
+   } catch (...) {
+      _deallocate(new_data, new_capacity);
+      throw;
+   }
+   _record(vector_event::reallocate, new_capacity, 0, 0, size_);
+   _deallocate(data_, capacity_);
+   data_ = new_data;
+   capacity_ = new_capacity;
+}
+
+template<typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::_relocate(pointer src, size_type n, pointer dest) {
+   if constexpr (is_trivially_relocatable_v<T>) {
+      if (n) std::memmove(static_cast<void*>(dest), static_cast<const void*>(src), n * sizeof(T));
+   } else if constexpr (std::is_nothrow_move_constructible<T>::value) {
+      if (dest < src) {
+         for (size_t i = 0; i < n; i++) {
+            new (dest + i) T(std::move(src[i]));
+            src[i].~T();
+         }
+      } else {
+         for (size_t i = n; i-- > 0; ) {
+            new (dest + i) T(std::move(src[i]));
+            src[i].~T();
+         }
+      }
+   } else {
+      // copy fallback may throw; leave src intact and dest empty if it does
+      size_t i = 0;
+      try {
+         for (; i < n; i++) {
+            new (dest + i) T(std::move_if_noexcept(src[i]));
+         }
+      } catch (...) {
+         while (i) dest[--i].~T();
+         throw;
+      }
+      for (i = 0; i < n; i++) {
+         src[i].~T();
+      }
+   }
 }
 
 } // namespace dsacpp
\ No newline at end of file
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <typeinfo>
+
+/**
+ * Allocation instrumentation for vector, off unless DSACPP_VECTOR_INSTRUMENT
+ * is defined to 1. When off, vector's recording hooks are empty inline
+ * functions and nothing in this header is instantiated.
+ */
+#ifndef DSACPP_VECTOR_INSTRUMENT
+#define DSACPP_VECTOR_INSTRUMENT 0
+#endif
+
+namespace dsacpp
+{
+
+/**
+ * One change to a vector's buffer, as passed to the vector_stats hook.
+ *    - allocate:   a new buffer was obtained (allocated bytes)
+ *    - deallocate: a buffer was released (freed bytes)
+ *    - reallocate: the elements moved to a new buffer (relocated of them),
+ *                  or the buffer grew or shrank in place (allocated or
+ *                  freed bytes)
+ * capacity is the buffer size in bytes after the change.
+ */
+struct vector_event {
+   enum kind_type { allocate, deallocate, reallocate };
+
+   kind_type kind;
+   std::size_t allocated;
+   std::size_t freed;
+   std::size_t relocated;
+   std::size_t capacity;
+};
+
+/**
+ * Counters for one tag. Every element type gets a tag of its own through
+ * vector_stats_for<T>(); a call site can charge its vectors to a named
+ * tag instead by declaring a vector_stats and opening a vector_stats_scope
+ * on it. A vector_stats registers itself for for_each_vector_stats() and
+ * dump_vector_stats() on construction and drops out on destruction.
+ */
+class vector_stats {
+public:
+
+   explicit vector_stats(const char* tag) noexcept;
+
+   vector_stats(const vector_stats&) = delete;
+   vector_stats& operator=(const vector_stats&) = delete;
+
+   ~vector_stats();
+
+   const char* tag() const noexcept;
+
+   std::size_t allocations() const noexcept;
+   std::size_t reallocations() const noexcept;
+   std::size_t bytes_allocated() const noexcept;
+   std::size_t bytes_freed() const noexcept;
+   std::size_t elements_relocated() const noexcept;
+
+   // largest single buffer seen, in bytes
+   std::size_t peak_capacity() const noexcept;
+
+   void record(const vector_event& event) noexcept;
+   void reset() noexcept;
+
+private:
+
+   friend struct vector_stats_registry;
+
+   template<typename F>
+   friend void for_each_vector_stats(F f);
+
+   friend void reset_vector_stats() noexcept;
+
+   const char* tag_;
+   std::atomic<std::size_t> allocations_;
+   std::atomic<std::size_t> reallocations_;
+   std::atomic<std::size_t> bytes_allocated_;
+   std::atomic<std::size_t> bytes_freed_;
+   std::atomic<std::size_t> elements_relocated_;
+   std::atomic<std::size_t> peak_capacity_;
+
+   // registry links, guarded by the registry lock
+   vector_stats* prev_;
+   vector_stats* next_;
+};
+
+/**
+ * Charges vector events on the calling thread to stats until the scope
+ * closes. Scopes nest; the innermost one wins.
+ */
+class vector_stats_scope {
+public:
+
+   explicit vector_stats_scope(vector_stats& stats) noexcept;
+
+   vector_stats_scope(const vector_stats_scope&) = delete;
+   vector_stats_scope& operator=(const vector_stats_scope&) = delete;
+
+   ~vector_stats_scope();
+
+   // stats of the innermost open scope on this thread, or null
+   static vector_stats* current() noexcept;
+
+private:
+
+   vector_stats* previous_;
+
+   static vector_stats*& _current() noexcept;
+};
+
+// called after every recorded event, e.g. to feed a metrics exporter; must
+// not throw, and is not re-entered for vectors the hook itself touches
+using vector_stats_hook = void (*)(const vector_stats& stats, const vector_event& event);
+
+// install hook (null to remove); returns the previous one
+vector_stats_hook set_vector_stats_hook(vector_stats_hook hook) noexcept;
+
+// stats of the element type tag T
+template<typename T>
+vector_stats& vector_stats_for() noexcept;
+
+// f(const vector_stats&) for every live tag
+template<typename F>
+void for_each_vector_stats(F f);
+
+// one line per tag that saw any allocation
+void dump_vector_stats(std::ostream& out);
+
+void reset_vector_stats() noexcept;
+
+/**
+ * Intrusive list of every live vector_stats.
+ */
+struct vector_stats_registry {
+   std::mutex lock;
+   vector_stats* head = nullptr;
+   std::atomic<vector_stats_hook> hook{ nullptr };
+
+   static vector_stats_registry& instance() noexcept;
+
+   void add(vector_stats* stats) noexcept;
+   void remove(vector_stats* stats) noexcept;
+};
+
+namespace detail
+{
+
+// charge event to the current scope, or to Tag's stats outside any scope
+template<typename Tag>
+void record_vector_event(const vector_event& event) noexcept {
+   vector_stats* stats = vector_stats_scope::current();
+   if (!stats) stats = &vector_stats_for<Tag>();
+   stats->record(event);
+}
+
+} // namespace detail
+
+inline vector_stats::vector_stats(const char* tag) noexcept :
+   tag_{ tag },
+   allocations_{ 0 },
+   reallocations_{ 0 },
+   bytes_allocated_{ 0 },
+   bytes_freed_{ 0 },
+   elements_relocated_{ 0 },
+   peak_capacity_{ 0 },
+   prev_{ nullptr },
+   next_{ nullptr }
+{ vector_stats_registry::instance().add(this); }
+
+inline vector_stats::~vector_stats() {
+   vector_stats_registry::instance().remove(this);
+}
+
+inline const char* vector_stats::tag() const noexcept {
+   return tag_;
+}
+
+inline std::size_t vector_stats::allocations() const noexcept {
+   return allocations_.load(std::memory_order_relaxed);
+}
+
+inline std::size_t vector_stats::reallocations() const noexcept {
+   return reallocations_.load(std::memory_order_relaxed);
+}
+
+inline std::size_t vector_stats::bytes_allocated() const noexcept {
+   return bytes_allocated_.load(std::memory_order_relaxed);
+}
+
+inline std::size_t vector_stats::bytes_freed() const noexcept {
+   return bytes_freed_.load(std::memory_order_relaxed);
+}
+
+inline std::size_t vector_stats::elements_relocated() const noexcept {
+   return elements_relocated_.load(std::memory_order_relaxed);
+}
+
+inline std::size_t vector_stats::peak_capacity() const noexcept {
+   return peak_capacity_.load(std::memory_order_relaxed);
+}
+
+inline void vector_stats::record(const vector_event& event) noexcept {
+   if (event.kind == vector_event::allocate) {
+      allocations_.fetch_add(1, std::memory_order_relaxed);
+   } else if (event.kind == vector_event::reallocate) {
+      reallocations_.fetch_add(1, std::memory_order_relaxed);
+   }
+   if (event.allocated) bytes_allocated_.fetch_add(event.allocated, std::memory_order_relaxed);
+   if (event.freed) bytes_freed_.fetch_add(event.freed, std::memory_order_relaxed);
+   if (event.relocated) elements_relocated_.fetch_add(event.relocated, std::memory_order_relaxed);
+   std::size_t peak = peak_capacity_.load(std::memory_order_relaxed);
+   while (event.capacity > peak &&
+          !peak_capacity_.compare_exchange_weak(peak, event.capacity, std::memory_order_relaxed)) { }
+
+   // vectors used inside the hook must not call back into it
+   thread_local bool in_hook = false;
+   vector_stats_hook hook = vector_stats_registry::instance().hook.load(std::memory_order_acquire);
+   if (hook && !in_hook) {
+      in_hook = true;
+      hook(*this, event);
+      in_hook = false;
+   }
+}
+
+inline void vector_stats::reset() noexcept {
+   allocations_.store(0, std::memory_order_relaxed);
+   reallocations_.store(0, std::memory_order_relaxed);
+   bytes_allocated_.store(0, std::memory_order_relaxed);
+   bytes_freed_.store(0, std::memory_order_relaxed);
+   elements_relocated_.store(0, std::memory_order_relaxed);
+   peak_capacity_.store(0, std::memory_order_relaxed);
+}
+
+inline vector_stats_scope::vector_stats_scope(vector_stats& stats) noexcept :
+   previous_{ _current() }
+{ _current() = &stats; }
+
+inline vector_stats_scope::~vector_stats_scope() {
+   _current() = previous_;
+}
+
+inline vector_stats* vector_stats_scope::current() noexcept {
+   return _current();
+}
+
+inline vector_stats*& vector_stats_scope::_current() noexcept {
+   thread_local vector_stats* current = nullptr;
+   return current;
+}
+
+inline vector_stats_registry& vector_stats_registry::instance() noexcept {
+   // never destroyed, so vectors outliving static destruction may still record
+   static vector_stats_registry* registry = new vector_stats_registry;
+   return *registry;
+}
+
+inline void vector_stats_registry::add(vector_stats* stats) noexcept {
+   std::lock_guard<std::mutex> guard(lock);
+   stats->next_ = head;
+   if (head) head->prev_ = stats;
+   head = stats;
+}
+
+inline void vector_stats_registry::remove(vector_stats* stats) noexcept {
+   std::lock_guard<std::mutex> guard(lock);
+   if (stats->prev_) stats->prev_->next_ = stats->next_;
+   else head = stats->next_;
+   if (stats->next_) stats->next_->prev_ = stats->prev_;
+}
+
+inline vector_stats_hook set_vector_stats_hook(vector_stats_hook hook) noexcept {
+   return vector_stats_registry::instance().hook.exchange(hook, std::memory_order_acq_rel);
+}
+
+template<typename T>
+vector_stats& vector_stats_for() noexcept {
+   static vector_stats* stats = new vector_stats(typeid(T).name());
+   return *stats;
+}
+
+template<typename F>
+void for_each_vector_stats(F f) {
+   vector_stats_registry& registry = vector_stats_registry::instance();
+   std::lock_guard<std::mutex> guard(registry.lock);
+   for (const vector_stats* stats = registry.head; stats; stats = stats->next_) {
+      f(*stats);
+   }
+}
+
+inline void dump_vector_stats(std::ostream& out) {
+   for_each_vector_stats([&out](const vector_stats& stats) {
+      if (stats.allocations() == 0) return;
+      out << stats.tag()
+          << ": allocations=" << stats.allocations()
+          << " reallocations=" << stats.reallocations()
+          << " bytes_allocated=" << stats.bytes_allocated()
+          << " bytes_freed=" << stats.bytes_freed()
+          << " elements_relocated=" << stats.elements_relocated()
+          << " peak_capacity=" << stats.peak_capacity()
+          << '\n';
+   });
+}
+
+inline void reset_vector_stats() noexcept {
+   vector_stats_registry& registry = vector_stats_registry::instance();
+   std::lock_guard<std::mutex> guard(registry.lock);
+   for (vector_stats* stats = registry.head; stats; stats = stats->next_) {
+      stats->reset();
+   }
+}
+
+} // namespace dsacpp
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "vector.hpp"
+
+namespace dsacpp
+{
+
+/**
+ * On-disk vector format (POSIX only). A file is a 64-byte header followed
+ * by the raw element bytes starting at data_offset, which is a multiple of
+ * VECTOR_FILE_ALIGNMENT so a mapped file hands out suitably aligned T.
+ * Files are written in the host byte order and rejected on a host with
+ * the other one. Only trivially copyable T can be stored.
+ */
+struct vector_file_header {
+   char magic[8];                // VECTOR_FILE_MAGIC
+   std::uint32_t version;        // VECTOR_FILE_VERSION
+   std::uint32_t byte_order;     // VECTOR_FILE_BYTE_ORDER as written by the host
+   std::uint64_t element_size;   // sizeof(T)
+   std::uint64_t element_align;  // alignof(T)
+   std::uint64_t count;          // number of elements
+   std::uint64_t data_offset;    // file offset of the first element
+   std::uint64_t checksum;       // checksum64 of the element bytes
+   std::uint64_t reserved;
+};
+
+static_assert(sizeof(vector_file_header) == 64, "vector_file_header must stay 64 bytes");
+
+inline constexpr char VECTOR_FILE_MAGIC[8] = { 'D', 'S', 'A', 'V', 'E', 'C', '\0', '\0' };
+inline constexpr std::uint32_t VECTOR_FILE_VERSION = 1;
+inline constexpr std::uint32_t VECTOR_FILE_BYTE_ORDER = 0x01020304;
+inline constexpr std::size_t VECTOR_FILE_ALIGNMENT = 64;
+
+namespace detail
+{
+
+inline std::uint64_t rotl64(std::uint64_t x, int r) noexcept {
+   return (x << r) | (x >> (64 - r));
+}
+
+// 64-bit checksum in the style of xxHash64: four independent lanes keep a
+// multiply in flight each cycle, so hashing runs near memory bandwidth
+inline std::uint64_t checksum64(const void* data, std::size_t bytes) noexcept {
+   constexpr std::uint64_t P1 = 0x9E3779B185EBCA87ull;
+   constexpr std::uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+   constexpr std::uint64_t P3 = 0x165667B19E3779F9ull;
+   constexpr std::uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+   constexpr std::uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+   auto round = [](std::uint64_t acc, std::uint64_t word) {
+      return rotl64(acc + word * P2, 31) * P1;
+   };
+   auto load = [](const unsigned char* p) {
+      std::uint64_t word;
+      std::memcpy(&word, p, sizeof(word));
+      return word;
+   };
+
+   const unsigned char* p = static_cast<const unsigned char*>(data);
+   const unsigned char* end = p + bytes;
+   std::uint64_t hash;
+   if (bytes >= 32) {
+      std::uint64_t lanes[4] = { P1 + P2, P2, 0, 0 - P1 };
+      for (; p + 32 <= end; p += 32) {
+         lanes[0] = round(lanes[0], load(p));
+         lanes[1] = round(lanes[1], load(p + 8));
+         lanes[2] = round(lanes[2], load(p + 16));
+         lanes[3] = round(lanes[3], load(p + 24));
+      }
+      hash = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+      for (std::uint64_t lane : lanes) {
+         hash = (hash ^ round(0, lane)) * P1 + P4;
+      }
+   } else {
+      hash = P5;
+   }
+   hash += bytes;
+   for (; p + 8 <= end; p += 8) {
+      hash = rotl64(hash ^ round(0, load(p)), 27) * P1 + P4;
+   }
+   for (; p < end; p++) {
+      hash = rotl64(hash ^ (*p * P5), 11) * P1;
+   }
+   hash ^= hash >> 33;
+   hash *= P2;
+   hash ^= hash >> 29;
+   hash *= P3;
+   hash ^= hash >> 32;
+   return hash;
+}
+
+[[noreturn]] DSACPP_COLD inline void throw_system_error(const char* what, const std::string& path) {
+   throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path);
+}
+
+[[noreturn]] DSACPP_COLD inline void throw_format_error(const char* what, const std::string& path, const char* kind = "vector") {
+   throw std::runtime_error(std::string(kind) + " file " + path + ": " + what);
+}
+
+// write parts to a temporary file renamed over path, so readers never see
+// a half-written file; one writev normally, resumed after a short write
+inline void replace_file(const std::string& path, iovec* parts, int count) {
+   std::string tmp = path + ".tmp";
+   int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd < 0) {
+      throw_system_error("cannot create", tmp);
+   }
+
+   iovec* part = parts;
+   int left = count;
+   while (left > 0) {
+      ssize_t written = ::writev(fd, part, left);
+      if (written < 0) {
+         if (errno == EINTR) continue;
+         int error = errno;
+         ::close(fd);
+         ::unlink(tmp.c_str());
+         errno = error;
+         throw_system_error("cannot write", tmp);
+      }
+      std::size_t done = static_cast<std::size_t>(written);
+      while (left > 0 && done >= part->iov_len) {
+         done -= part->iov_len;
+         part++;
+         left--;
+      }
+      if (left > 0) {
+         part->iov_base = static_cast<unsigned char*>(part->iov_base) + done;
+         part->iov_len -= done;
+      }
+   }
+
+   if (::close(fd) != 0 || ::rename(tmp.c_str(), path.c_str()) != 0) {
+      int error = errno;
+      ::unlink(tmp.c_str());
+      errno = error;
+      throw_system_error("cannot replace", path);
+   }
+}
+
+// map all of path read-only, setting bytes to its size; a file shorter
+// than min_bytes is rejected as a kind file without a header
+inline void* map_file(const std::string& path, std::size_t min_bytes, const char* kind, std::size_t& bytes) {
+   int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0) {
+      throw_system_error("cannot open", path);
+   }
+   struct stat st;
+   if (::fstat(fd, &st) != 0) {
+      int error = errno;
+      ::close(fd);
+      errno = error;
+      throw_system_error("cannot stat", path);
+   }
+   bytes = static_cast<std::size_t>(st.st_size);
+   if (bytes < min_bytes) {
+      ::close(fd);
+      throw_format_error("too short for a header", path, kind);
+   }
+   void* map = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+   int error = errno;
+   ::close(fd);
+   if (map == MAP_FAILED) {
+      errno = error;
+      throw_system_error("cannot map", path);
+   }
+   return map;
+}
+
+} // namespace detail
+
+/**
+ * Write v to path in the vector file format. The header and elements go
+ * out in a single writev into a temporary file that is then renamed over
+ * path, so readers never see a half-written file. Durability against power
+ * loss (fsync) is left to the caller.
+ */
+template<typename T, typename A, typename G>
+void save(const vector<T, A, G>& v, const std::string& path);
+
+/**
+ * Read-only, zero-copy view of a vector file. The file is mapped, not read:
+ * opening costs a few system calls whatever the size, and pages fault in
+ * as they are touched. Offers the const half of vector's interface.
+ *
+ * The checksum covers every element byte, so checking it reads the whole
+ * file; pass verify_checksum to pay that at open, or call verify() later.
+ */
+template<typename T>
+class vector_view {
+   static_assert(std::is_trivially_copyable<T>::value, "vector files hold trivially copyable types only");
+   static_assert(alignof(T) <= VECTOR_FILE_ALIGNMENT, "vector files align data to VECTOR_FILE_ALIGNMENT");
+
+public:
+   /**
+    * Type declarations
+    */
+
+   using value_type              = T;
+   using size_type               = std::size_t;
+   using difference_type         = std::ptrdiff_t;
+   using const_reference         = const T&;
+   using const_pointer           = const T*;
+
+   using const_iterator          = vector_const_iterator<T>;
+   using iterator                = const_iterator;
+   using const_reverse_iterator  = std::reverse_iterator<const_iterator>;
+
+   /**
+    * Constructors & Destructor
+    */
+
+   vector_view() noexcept;
+
+   explicit vector_view(const std::string& path, bool verify_checksum = false);
+
+   vector_view(const vector_view&) = delete;
+   vector_view& operator=(const vector_view&) = delete;
+
+   vector_view(vector_view&& other) noexcept;
+   vector_view& operator=(vector_view&& other) noexcept;
+
+   ~vector_view() noexcept;
+
+   /**
+    * Getters
+    */
+
+   const_reference at(size_type index) const;
+   const_reference operator[](size_type index) const;
+   const_reference front() const;
+   const_reference back() const;
+   const_pointer data() const noexcept;
+
+   size_type size() const noexcept;
+   bool empty() const noexcept;
+
+   const vector_file_header& header() const noexcept;
+
+   // recompute the checksum over the mapped data
+   bool verify() const noexcept;
+
+   // copy into an owning vector
+   vector<T> to_vector() const;
+
+   void swap(vector_view& other) noexcept;
+
+   /**
+    * Iterators
+    */
+
+   const_iterator begin() const noexcept;
+   const_iterator end() const noexcept;
+   const_iterator cbegin() const noexcept;
+   const_iterator cend() const noexcept;
+   const_reverse_iterator rbegin() const noexcept;
+   const_reverse_iterator rend() const noexcept;
+
+private:
+
+   void* map_;
+   size_type map_bytes_;
+   const T* data_;
+   size_type size_;
+
+   const vector_file_header* _header() const noexcept;
+
+   void _check_index(size_type index, const char* where) const;
+
+   void _unmap() noexcept;
+};
+
+template<typename T, typename A, typename G>
+void save(const vector<T, A, G>& v, const std::string& path) {
+   static_assert(std::is_trivially_copyable<T>::value, "vector files hold trivially copyable types only");
+   static_assert(alignof(T) <= VECTOR_FILE_ALIGNMENT, "vector files align data to VECTOR_FILE_ALIGNMENT");
+
+   // the header is padded out to the first aligned offset
+   alignas(VECTOR_FILE_ALIGNMENT) unsigned char head[VECTOR_FILE_ALIGNMENT] = {};
+   vector_file_header header{};
+   std::memcpy(header.magic, VECTOR_FILE_MAGIC, sizeof(header.magic));
+   header.version = VECTOR_FILE_VERSION;
+   header.byte_order = VECTOR_FILE_BYTE_ORDER;
+   header.element_size = sizeof(T);
+   header.element_align = alignof(T);
+   header.count = v.size();
+   header.data_offset = sizeof(head);
+   header.checksum = detail::checksum64(v.data(), v.size() * sizeof(T));
+   std::memcpy(head, &header, sizeof(header));
+
+   iovec parts[2] = {
+      { head, sizeof(head) },
+      { const_cast<T*>(v.data()), v.size() * sizeof(T) },
+   };
+   detail::replace_file(path, parts, v.empty() ? 1 : 2);
+}
+
+template<typename T>
+vector_view<T>::vector_view() noexcept :
+   map_{ nullptr },
+   map_bytes_{ 0 },
+   data_{ nullptr },
+   size_{ 0 }
+{ }
+
+template<typename T>
+vector_view<T>::vector_view(const std::string& path, bool verify_checksum) : vector_view() {
+   map_ = detail::map_file(path, sizeof(vector_file_header), "vector", map_bytes_);
+
+   const vector_file_header& h = *_header();
+   const char* problem = nullptr;
+   if (std::memcmp(h.magic, VECTOR_FILE_MAGIC, sizeof(h.magic)) != 0) {
+      problem = "bad magic";
+   } else if (h.version != VECTOR_FILE_VERSION) {
+      problem = "unsupported version";
+   } else if (h.byte_order != VECTOR_FILE_BYTE_ORDER) {
+      problem = "written with the other byte order";
+   } else if (h.element_size != sizeof(T) || h.element_align != alignof(T)) {
+      problem = "element type does not match";
+   } else if (h.data_offset % VECTOR_FILE_ALIGNMENT != 0 || h.data_offset > map_bytes_
+              || h.count > (map_bytes_ - h.data_offset) / sizeof(T)) {
+      problem = "truncated or corrupt layout";
+   }
+   if (!problem) {
+      data_ = reinterpret_cast<const T*>(static_cast<const unsigned char*>(map_) + h.data_offset);
+      size_ = static_cast<size_type>(h.count);
+      if (verify_checksum && !verify()) problem = "checksum mismatch";
+   }
+   if (problem) {
+      _unmap();
+      detail::throw_format_error(problem, path);
+   }
+}
+
+template<typename T>
+vector_view<T>::vector_view(vector_view&& other) noexcept : vector_view() {
+   swap(other);
+}
+
+template<typename T>
+vector_view<T>& vector_view<T>::operator=(vector_view&& other) noexcept {
+   if (this != &other) {
+      _unmap();
+      swap(other);
+   }
+   return *this;
+}
+
+template<typename T>
+vector_view<T>::~vector_view() noexcept {
+   _unmap();
+}
+
+/**
+ * Getters
+ */
+
+template<typename T>
+typename vector_view<T>::const_reference vector_view<T>::at(size_type index) const {
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range("vector_view::at", index, size_);
+   }
+   return data_[index];
+}
+
+template<typename T>
+typename vector_view<T>::const_reference vector_view<T>::operator[](size_type index) const {
+   _check_index(index, "vector_view::operator[]");
+   return data_[index];
+}
+
+template<typename T>
+typename vector_view<T>::const_reference vector_view<T>::front() const {
+   _check_index(0, "vector_view::front");
+   return data_[0];
+}
+
+template<typename T>
+typename vector_view<T>::const_reference vector_view<T>::back() const {
+   _check_index(size_ - 1, "vector_view::back");
+   return data_[size_ - 1];
+}
+
+template<typename T>
+typename vector_view<T>::const_pointer vector_view<T>::data() const noexcept {
+   return data_;
+}
+
+template<typename T>
+typename vector_view<T>::size_type vector_view<T>::size() const noexcept {
+   return size_;
+}
+
+template<typename T>
+bool vector_view<T>::empty() const noexcept {
+   return size_ == 0;
+}
+
+template<typename T>
+const vector_file_header& vector_view<T>::header() const noexcept {
+   assert(map_ && "vector_view::header on an empty view");
+   return *_header();
+}
+
+template<typename T>
+bool vector_view<T>::verify() const noexcept {
+   if (!map_) return true;
+   return detail::checksum64(data_, size_ * sizeof(T)) == _header()->checksum;
+}
+
+template<typename T>
+vector<T> vector_view<T>::to_vector() const {
+   return vector<T>(begin(), end());
+}
+
+template<typename T>
+void vector_view<T>::swap(vector_view& other) noexcept {
+   std::swap(map_, other.map_);
+   std::swap(map_bytes_, other.map_bytes_);
+   std::swap(data_, other.data_);
+   std::swap(size_, other.size_);
+}
+
+/**
+ * Iterators
+ */
+
+template<typename T>
+typename vector_view<T>::const_iterator vector_view<T>::begin() const noexcept {
+   return const_iterator(data_);
+}
+
+template<typename T>
+typename vector_view<T>::const_iterator vector_view<T>::end() const noexcept {
+   return const_iterator(data_ + size_);
+}
+
+template<typename T>
+typename vector_view<T>::const_iterator vector_view<T>::cbegin() const noexcept {
+   return begin();
+}
+
+template<typename T>
+typename vector_view<T>::const_iterator vector_view<T>::cend() const noexcept {
+   return end();
+}
+
+template<typename T>
+typename vector_view<T>::const_reverse_iterator vector_view<T>::rbegin() const noexcept {
+   return const_reverse_iterator(end());
+}
+
+template<typename T>
+typename vector_view<T>::const_reverse_iterator vector_view<T>::rend() const noexcept {
+   return const_reverse_iterator(begin());
+}
+
+/**
+ * Private helpers
+ */
+
+template<typename T>
+const vector_file_header* vector_view<T>::_header() const noexcept {
+   return static_cast<const vector_file_header*>(map_);
+}
+
+template<typename T>
+void vector_view<T>::_check_index([[maybe_unused]] size_type index, [[maybe_unused]] const char* where) const {
+#if DSACPP_VECTOR_BOUNDS_CHECK >= 2
+   if (DSACPP_UNLIKELY(index >= size_)) {
+      detail::throw_out_of_range(where, index, size_);
+   }
+#elif DSACPP_VECTOR_BOUNDS_CHECK == 1
+   assert(index < size_ && "vector_view index out of range");
+#endif
+}
+
+template<typename T>
+void vector_view<T>::_unmap() noexcept {
+   if (map_) {
+      ::munmap(map_, map_bytes_);
+   }
+   map_ = nullptr;
+   map_bytes_ = 0;
+   data_ = nullptr;
+   size_ = 0;
+}
+
+} // namespace dsacpp
@@ -0,0 +1,109 @@
+// g++ -std=c++20 -O2 -pthread test/concurrent_vector/concurrent_vector_test.cpp -o concurrent_vector_test && ./concurrent_vector_test
+
+#include <atomic>
+#include <cassert>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../../src/concurrent_vector/concurrent_vector.hpp"
+
+namespace
+{
+
+// std::allocator that fails on demand
+template<typename T>
+struct failing_allocator {
+   using value_type = T;
+
+   static inline bool fail = false;
+
+   failing_allocator() = default;
+   template<typename U>
+   failing_allocator(const failing_allocator<U>&) noexcept { }
+
+   T* allocate(std::size_t n) {
+      if (fail) throw std::bad_alloc();
+      return std::allocator<T>().allocate(n);
+   }
+   void deallocate(T* p, std::size_t n) noexcept { std::allocator<T>().deallocate(p, n); }
+
+   bool operator==(const failing_allocator&) const noexcept { return true; }
+   bool operator!=(const failing_allocator&) const noexcept { return false; }
+};
+
+} // namespace
+
+int main() {
+   // readers poll constructed() on slots whose segment may not exist yet
+   {
+      dsacpp::concurrent_vector<int> v;
+      std::atomic<bool> done{ false };
+      std::thread reader([&] {
+         while (!done.load()) {
+            std::size_t n = v.size();
+            for (std::size_t i = 0; i < n + 64; i++) {
+               if (v.constructed(i)) assert(v[i] == 7);
+            }
+         }
+      });
+      std::vector<std::thread> writers;
+      for (int t = 0; t < 4; t++) {
+         writers.emplace_back([&] {
+            for (int i = 0; i < 20000; i++) v.push_back(7);
+         });
+      }
+      for (auto& w : writers) w.join();
+      done.store(true);
+      reader.join();
+      assert(v.size() == 80000);
+   }
+
+   // slots in a segment that could not be allocated fail instead of hanging
+   {
+      dsacpp::concurrent_vector<int, failing_allocator<int>> v;
+      for (int i = 0; i < 32; i++) v.push_back(i);
+      failing_allocator<int>::fail = true;
+      try {
+         v.push_back(32);
+         assert(false);
+      } catch (const std::bad_alloc&) { }
+      assert(v.size() == 33 && !v.constructed(32));
+      try {
+         (void)v.at(32);
+         assert(false);
+      } catch (const std::out_of_range&) { }
+
+      // claims past the failed segment, into one that also fails
+      try {
+         v.grow_by(100, 7);
+         assert(false);
+      } catch (const std::bad_alloc&) { }
+      failing_allocator<int>::fail = false;
+      assert(v.size() == 133 && !v.constructed(132));
+      try {
+         (void)v.at(132);
+         assert(false);
+      } catch (const std::out_of_range&) { }
+      assert(v.at(31) == 31);
+
+      v.clear();
+      v.push_back(0);
+      assert(v.size() == 1 && v.at(0) == 0);
+   }
+
+   // a grow_by reaching a segment that fails keeps what it built before it
+   {
+      dsacpp::concurrent_vector<int, failing_allocator<int>> v;
+      v.reserve(96);
+      failing_allocator<int>::fail = true;
+      try {
+         v.grow_by(200, 7);
+         assert(false);
+      } catch (const std::bad_alloc&) { }
+      failing_allocator<int>::fail = false;
+      assert(v.size() == 200 && v.at(95) == 7 && !v.constructed(96));
+   }
+   return 0;
+}
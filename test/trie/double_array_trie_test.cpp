@@ -0,0 +1,35 @@
+// g++ -std=c++20 -O2 -pthread test/trie/double_array_trie_test.cpp -o double_array_trie_test && ./double_array_trie_test
+
+#include <cassert>
+#include <set>
+#include <string>
+
+#include "../../src/trie/trie.hpp"
+#include "../../src/trie/double_array_trie.hpp"
+
+int main() {
+   // every one- and two-byte string against small key sets, so lookups
+   // walk off the used slots into the padding at the end of the array
+   const char* sets[][3] = { { "a", "", "" }, { "\xff", "", "" }, { "ab", "b", "\xfe\x01" } };
+   for (auto& keys : sets) {
+      dsacpp::trie<char, int> t;
+      std::set<std::string> expected;
+      int n = 0;
+      for (const char* k : keys) {
+         if (!*k) continue;
+         t.insert(k, n++);
+         expected.insert(k);
+      }
+      auto da = t.compile();
+      assert(da.size() == expected.size());
+      for (int a = 0; a < 256; a++) {
+         std::string one(1, static_cast<char>(a));
+         assert(da.contains(one) == (expected.count(one) > 0));
+         for (int b = 0; b < 256; b++) {
+            std::string two = one + static_cast<char>(b);
+            assert(da.contains(two) == (expected.count(two) > 0));
+         }
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,60 @@
+// g++ -std=c++20 -O2 -pthread test/trie/key_bytes_test.cpp -o key_bytes_test && ./key_bytes_test
+
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../../src/trie/trie.hpp"
+#include "../../src/trie/concurrent_trie.hpp"
+#include "../../src/trie/frozen_trie.hpp"
+#include "../../src/trie/trie_view.hpp"
+#include "../../src/trie/double_array_trie.hpp"
+
+int main() {
+   // multi-byte tokens, including ones whose high byte is set
+   using key = std::u16string;
+   std::vector<key> keys = { u"a", u"ab", u"ÿ", u"Ā", u"￿\u0001", u"中文" };
+
+   std::vector<std::uint8_t> bytes;
+   dsacpp::detail::key_to_bytes(keys[4], bytes);
+   assert((bytes == std::vector<std::uint8_t>{ 0xff, 0xff, 0x00, 0x01 }));
+   key back;
+   dsacpp::detail::bytes_to_key(bytes, back);
+   assert(back == keys[4]);
+
+   dsacpp::trie<char16_t, int> t;
+   dsacpp::concurrent_trie<char16_t, int> c;
+   for (std::size_t i = 0; i < keys.size(); i++) {
+      t.insert(keys[i], static_cast<int>(i));
+      c.insert(keys[i], static_cast<int>(i));
+   }
+
+   // every member of the family walks the same bytes to the same keys
+   auto frozen = t.freeze();
+   auto compiled = t.compile();
+   std::string path = "key_bytes_test.trie";
+   save(t, path);
+   dsacpp::trie_view<char16_t, int> view(path);
+   for (std::size_t i = 0; i < keys.size(); i++) {
+      int want = static_cast<int>(i);
+      assert(t.at(keys[i]) == want);
+      assert(c.find(keys[i]) && *c.find(keys[i]) == want);
+      assert(frozen.at(keys[i]) == want);
+      assert(compiled.at(keys[i]) == want);
+      assert(view.at(keys[i]) == want);
+   }
+
+   // and enumerate keys in the same order
+   std::vector<key> in_order;
+   for (const auto& [k, v] : t) in_order.push_back(k);
+   std::vector<key> seen;
+   frozen.for_each_prefix(u"", [&](const key& k, int) { seen.push_back(k); return true; });
+   assert(seen == in_order);
+   seen.clear();
+   view.for_each_prefix(u"", [&](const key& k, int) { seen.push_back(k); return true; });
+   assert(seen == in_order);
+
+   std::remove(path.c_str());
+   return 0;
+}
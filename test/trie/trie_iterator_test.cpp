@@ -0,0 +1,50 @@
+// g++ -std=c++20 -O2 -pthread test/trie/trie_iterator_test.cpp -o trie_iterator_test && ./trie_iterator_test
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "../../src/trie/trie.hpp"
+
+int main() {
+   dsacpp::trie<char, int> t;
+   t.insert("apple", 1);
+   t.insert("apply", 2);
+   t.insert("banana", 3);
+
+   // iterators reassign, across positions and from end
+   auto it = t.end();
+   it = t.find("apply");
+   assert(it != t.end() && it->first == "apply" && it->second == 2);
+   it = t.find("banana");
+   assert(it->first == "banana" && (*it).second == 3);
+   auto other = t.begin();
+   it = std::move(other);
+   assert(it->first == "apple");
+   t["apple"] = 10;
+   assert(it->second == 10);
+
+   dsacpp::trie<char, int>::const_iterator cit;
+   cit = it;
+   assert(cit->second == 10);
+
+   // standard algorithms that assign iterators
+   auto best = std::max_element(t.begin(), t.end(),
+      [](const auto& a, const auto& b) { return a.second < b.second; });
+   assert(best->first == "apple");
+
+   // non-arithmetic data can be changed through an iterator
+   dsacpp::trie<char, std::string> m;
+   m.insert("k", "old");
+   m.begin()->second = "new";
+   assert(m.at("k") == "new");
+
+   dsacpp::trie<char> s;
+   s.insert("x");
+   s.insert("y");
+   auto sit = s.end();
+   sit = s.find("y");
+   assert(*sit == "y" && sit->size() == 1);
+   return 0;
+}
@@ -0,0 +1,49 @@
+// g++ -std=c++20 -O2 -pthread test/trie/trie_scores_test.cpp -o trie_scores_test && ./trie_scores_test
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../../src/trie/trie.hpp"
+
+using scored = dsacpp::trie<char, std::uint32_t>;
+using ranking = std::vector<std::pair<std::string, std::uint32_t>>;
+
+// scores can only change through the trie, never through a reference
+static_assert(std::is_same<decltype(std::declval<scored&>().at("")), const std::uint32_t&>::value);
+static_assert(std::is_same<decltype(std::declval<scored&>().begin()->second), const std::uint32_t&>::value);
+
+int main() {
+   scored t;
+   t.insert("apple", 1);
+   t.insert("apricot", 2);
+   t.insert("banana", 3);
+
+   // subscript assignment keeps top_k exact
+   t["apple"] = 100;
+   assert(t.at("apple") == 100);
+   assert((t.top_k("ap", 1) == ranking{ { "apple", 100 } }));
+   assert((t.top_k("a", 2) == ranking{ { "apple", 100 }, { "apricot", 2 } }));
+
+   // and so do lowering, compound assignment and new keys
+   t["apple"] = 0;
+   assert((t.top_k("a", 1) == ranking{ { "apricot", 2 } }));
+   t["apricot"] += 5;
+   ++t["avocado"];
+   t["avocado"] += 9;
+   assert((t.top_k("a", 3) == ranking{ { "avocado", 10 }, { "apricot", 7 }, { "apple", 0 } }));
+   t["banana"] = t["avocado"];
+   assert((t.top_k("", 1).front().second == 10));
+   std::uint32_t read = t["apricot"];
+   assert(read == 7);
+
+   // a reference outliving an erase puts its key back
+   auto ref = t["apple"];
+   t.erase("apple");
+   ref = 50;
+   assert((t.top_k("ap", 1) == ranking{ { "apple", 50 } }));
+   return 0;
+}
@@ -0,0 +1,32 @@
+// g++ -std=c++20 -O2 test/vector/mmap_allocator_test.cpp -o mmap_allocator_test && ./mmap_allocator_test
+
+#include <cassert>
+#include <memory>
+#include <type_traits>
+
+#include "../../src/vector/mmap_allocator.hpp"
+
+int main() {
+   using alloc = dsacpp::mmap_allocator<int>;
+   static_assert(std::allocator_traits<alloc>::is_always_equal::value);
+
+   // every block records its own reservation, so any instance frees it
+   alloc small{ std::size_t{ 1 } << 20 };
+   alloc large{ std::size_t{ 1 } << 30 };
+   assert(small == large);
+   int* p = small.allocate(100);
+   p[99] = 1;
+   large.deallocate(p, 100);
+
+   // storage and the settings it was reserved with travel together
+   dsacpp::mmap_vector<int> a(small);
+   dsacpp::mmap_vector<int> b(large);
+   for (int i = 0; i < 1000; i++) a.push_back(i);
+   b.push_back(-1);
+   a.swap(b);
+   assert(a.size() == 1 && a[0] == -1 && a.get_allocator().reserve_bytes() == large.reserve_bytes());
+   assert(b.size() == 1000 && b[999] == 999 && b.get_allocator().reserve_bytes() == small.reserve_bytes());
+   a = std::move(b);
+   assert(a.size() == 1000 && a[999] == 999 && a.get_allocator().reserve_bytes() == small.reserve_bytes());
+   return 0;
+}
@@ -0,0 +1,81 @@
+// g++ -std=c++20 -O2 test/vector/small_vector_test.cpp -o small_vector_test && ./small_vector_test
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+#include "../../src/vector/small_vector.hpp"
+
+namespace
+{
+
+int live = 0;
+
+// throws from its copy constructor once armed copies have been made
+struct fragile {
+   static inline int copies_left = -1;
+
+   fragile() { live++; }
+   fragile(const fragile&) {
+      if (copies_left == 0) throw std::runtime_error("fragile");
+      if (copies_left > 0) copies_left--;
+      live++;
+   }
+   ~fragile() { live--; }
+};
+
+} // namespace
+
+int main() {
+   // push_back of an element of the vector itself, spilling and growing
+   dsacpp::small_vector<std::string, 2> v;
+   v.push_back(std::string(40, 'a'));
+   v.push_back(std::string(40, 'b'));
+   v.push_back(v[0]);
+   assert(!v.is_inline() && v[2] == std::string(40, 'a'));
+   while (v.size() < v.capacity()) v.push_back("x");
+   v.push_back(v[1]);
+   assert(v.back() == std::string(40, 'b'));
+   v.emplace_back(v.front());
+   assert(v.back() == std::string(40, 'a'));
+   v.push_back(std::move(v[1]));
+   assert(v.back() == std::string(40, 'b'));
+
+   // resize filling with an element of the vector itself, spilling and growing
+   {
+      dsacpp::small_vector<std::string, 2> r;
+      r.push_back(std::string(40, 'a'));
+      r.push_back(std::string(40, 'b'));
+      r.resize(5, r[0]);
+      assert(r.size() == 5 && r[4] == std::string(40, 'a'));
+      r.resize(r.capacity());
+      r.resize(r.size() + 1, r[1]);
+      assert(r.back() == std::string(40, 'b'));
+   }
+
+   // a throwing element constructor leaves nothing behind
+   {
+      dsacpp::small_vector<fragile, 2> src(5);
+      fragile::copies_left = 3;
+      try {
+         dsacpp::small_vector<fragile, 2> copy(src);
+         assert(false);
+      } catch (const std::runtime_error&) { }
+      fragile::copies_left = -1;
+      assert(live == 5);
+   }
+   assert(live == 0);
+   {
+      dsacpp::small_vector<fragile, 2> grown(1);
+      fragile proto;
+      fragile::copies_left = 3;
+      try {
+         grown.resize(6, proto);
+         assert(false);
+      } catch (const std::runtime_error&) { }
+      fragile::copies_left = -1;
+      assert(grown.size() == 1 && live == 2);
+   }
+   assert(live == 0);
+   return 0;
+}
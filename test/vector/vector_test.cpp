@@ -0,0 +1,54 @@
+// g++ -std=c++20 -O2 test/vector/vector_test.cpp -o vector_test && ./vector_test
+
+#include <cassert>
+#include <stdexcept>
+
+#include "../../src/vector/vector.hpp"
+
+namespace
+{
+
+int live = 0;
+
+// throws from its copy constructor when armed
+struct fragile {
+   static inline bool fail = false;
+
+   fragile() { live++; }
+   fragile(const fragile&) {
+      if (fail) throw std::runtime_error("fragile");
+      live++;
+   }
+   ~fragile() { live--; }
+};
+
+} // namespace
+
+int main() {
+   {
+      dsacpp::vector<fragile> v;
+      v.reserve(4);
+      fragile f;
+      v.push_back(f);
+      fragile::fail = true;
+      try {
+         v.push_back(f);
+         assert(false);
+      } catch (const std::runtime_error&) { }
+      assert(v.size() == 1);
+
+      // the slow path, on a full buffer
+      fragile::fail = false;
+      while (v.size() < v.capacity()) v.push_back(f);
+      std::size_t full = v.size();
+      fragile::fail = true;
+      try {
+         v.push_back(f);
+         assert(false);
+      } catch (const std::runtime_error&) { }
+      assert(v.size() == full);
+      fragile::fail = false;
+   }
+   assert(live == 0);
+   return 0;
+}